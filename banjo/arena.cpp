@@ -0,0 +1,39 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "arena.hpp"
+
+
+namespace banjo
+{
+
+Arena::~Arena()
+{
+  for (char* b : blocks)
+    delete[] b;
+}
+
+
+// Allocate n bytes aligned to a in a new block. Large requests get
+// a block of their own so that the remainder of the current block is
+// not wasted.
+void*
+Arena::allocate_block(std::size_t n, std::size_t a)
+{
+  std::size_t size = n + a;
+  bool large = size > block_size / 4;
+  if (!large)
+    size = block_size;
+  char* b = new char[size];
+  blocks.push_back(b);
+  char* p = align_up(b, a);
+  if (!large) {
+    ptr = p + n;
+    lim = b + size;
+  }
+  used += n;
+  return p;
+}
+
+
+} // namespace banjo
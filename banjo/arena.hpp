@@ -0,0 +1,76 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_ARENA_HPP
+#define BANJO_ARENA_HPP
+
+// A region-based allocator for storage that lives as long as the
+// AST. Allocation bumps a pointer within the current block; memory
+// is released only when the arena is destroyed.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace banjo
+{
+
+// A bump allocator. Note that an arena is not thread-safe.
+struct Arena
+{
+  static constexpr std::size_t block_size = 64 * 1024;
+
+  Arena() = default;
+  ~Arena();
+
+  // Non-copyable
+  Arena(Arena const&) = delete;
+  Arena& operator=(Arena const&) = delete;
+
+  void* allocate(std::size_t, std::size_t = alignof(std::max_align_t));
+  void* allocate_block(std::size_t, std::size_t);
+
+  template<typename T>
+  T* allocate(std::size_t n) { return static_cast<T*>(allocate(n * sizeof(T), alignof(T))); }
+
+  // Returns the number of bytes handed out by the arena.
+  std::size_t bytes_allocated() const { return used; }
+
+  char*              ptr = nullptr; // The next free byte
+  char*              lim = nullptr; // The end of the current block
+  std::vector<char*> blocks;        // All allocated blocks
+  std::size_t        used = 0;      // Bytes allocated
+};
+
+
+// Returns p rounded up to a multiple of a, which must be a power of 2.
+inline char*
+align_up(char* p, std::size_t a)
+{
+  std::uintptr_t n = reinterpret_cast<std::uintptr_t>(p);
+  return reinterpret_cast<char*>((n + a - 1) & ~(a - 1));
+}
+
+
+// Allocate n bytes aligned to a. When the current block is exhausted,
+// a new one is allocated.
+inline void*
+Arena::allocate(std::size_t n, std::size_t a)
+{
+  if (ptr) {
+    char* p = align_up(ptr, a);
+    if (p + n <= lim) {
+      ptr = p + n;
+      used += n;
+      return p;
+    }
+  }
+  return allocate_block(n, a);
+}
+
+
+} // namespace banjo
+
+
+#endif
@@ -2,3 +2,17 @@
 // All rights reserved
 
 #include "ast-base.hpp"
+
+
+namespace banjo
+{
+
+Arena*&
+list_arena()
+{
+  static thread_local Arena* a = nullptr;
+  return a;
+}
+
+
+} // namespace banjo
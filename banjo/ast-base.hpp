@@ -8,13 +8,20 @@
 // supporting structures.
 
 #include "prelude.hpp"
+#include "arena.hpp"
+#include "source.hpp"
 
 #include <lingo/integer.hpp>
 #include <lingo/real.hpp>
 #include <lingo/token.hpp>
 
-#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 
 namespace banjo
@@ -24,6 +31,7 @@ struct Term;
 
 struct Name;
 struct Type;
+struct Unary_type;
 struct Declared_type;
 struct Expr;
 struct Id_expr;
@@ -31,7 +39,9 @@ struct Decl_expr;
 struct Unary_expr;
 struct Binary_expr;
 struct Dot_expr;
+struct Nested_decl_expr;
 struct Conv;
+struct Standard_conv;
 struct Init;
 struct Req;
 struct Stmt;
@@ -41,6 +51,7 @@ struct Value_decl;
 struct Type_decl;
 struct Def;
 struct Cons;
+struct Binary_cons;
 
 
 #define define_node(Node) struct Node;
@@ -62,6 +73,34 @@ struct Overload_set;
 using lingo::Integer;
 
 
+// -------------------------------------------------------------------------- //
+// Node kinds
+
+// Each node class has a unique kind. Testing the kind of a term is
+// considerably cheaper than a dynamic_cast, and allows functions to be
+// applied to terms using a switch in place of a double dispatch.
+//
+// The kinds are generated from the node definition files, in order, so
+// the kinds of each category of terms (and of each intermediate base
+// class) are consecutive.
+enum Node_kind : std::uint8_t
+{
+#define define_node(Node) Node##_kind,
+#include "ast-name.def"
+#include "ast-type.def"
+#include "ast-expr.def"
+#include "ast-req.def"
+#include "ast-stmt.def"
+#include "ast-decl.def"
+#include "ast-def.def"
+#include "ast-cons.def"
+#undef define_node
+
+  // Lists of terms are also terms.
+  List_kind
+};
+
+
 // -------------------------------------------------------------------------- //
 // Terms
 
@@ -74,134 +113,560 @@ struct Term
 {
   virtual ~Term() { }
 
+  // Returns the kind of the term. This is defined by each node class.
+  virtual Node_kind node_kind() const = 0;
+
   // Returns the source code location of the term. this
-  // may be an invalid position.
-  Location location() const { return loc; }
+  // may be an invalid position. Use the context's source manager
+  // to find the line and column of the location.
+  Source_location location() const { return loc; }
 
   // Returns the region of text over which the term is written.
   // By default, this is is the empty region, which starts
   // and ends at the term's location.
-  virtual Region region() const { return {loc, loc}; }
+  virtual Source_region region() const { return {loc, loc}; }
 
-  Location loc;
+  Source_location loc;
 };
 
 
+// -------------------------------------------------------------------------- //
+// Dynamic type tests
+
+// The consecutive range of kinds [first, last].
+template<Node_kind First, Node_kind Last>
+struct Node_range
+{
+  static constexpr bool is_node = true;
+
+  static constexpr bool contains(Node_kind k) { return First <= k && k <= Last; }
+};
+
+
+// By default, a class is not a node class and has no kinds.
+template<typename T>
+struct Node_leaf
+{
+  static constexpr bool is_node = false;
+};
+
+
+#define define_node(Node) \
+  template<> struct Node_leaf<Node> : Node_range<Node##_kind, Node##_kind> { };
+#include "ast-name.def"
+#include "ast-type.def"
+#include "ast-expr.def"
+#include "ast-req.def"
+#include "ast-stmt.def"
+#include "ast-decl.def"
+#include "ast-def.def"
+#include "ast-cons.def"
+#undef define_node
+
+
+// The kinds of the terms whose dynamic type is T or a class derived
+// from T. For most node classes, this is just their own kind. The
+// abstract base classes, and node classes that have derived node
+// classes, are specialized below. The consistency of these ranges with
+// the class hierarchy is checked in ast.cpp.
+template<typename T>
+struct Node_kinds : Node_leaf<T>
+{ };
+
+
+template<> struct Node_kinds<Term>             : Node_range<Simple_id_kind, List_kind> { };
+template<> struct Node_kinds<Name>             : Node_range<Simple_id_kind, Qualified_id_kind> { };
+template<> struct Node_kinds<Type>             : Node_range<Void_type_kind, Unparsed_type_kind> { };
+template<> struct Node_kinds<Unary_type>       : Node_range<Qualified_type_kind, Pack_type_kind> { };
+template<> struct Node_kinds<Declared_type>    : Node_range<Class_type_kind, Synthetic_type_kind> { };
+template<> struct Node_kinds<Class_type>       : Node_range<Class_type_kind, Coroutine_type_kind> { };
+template<> struct Node_kinds<Expr>             : Node_range<Boolean_expr_kind, Unparsed_expr_kind> { };
+template<> struct Node_kinds<Id_expr>          : Node_range<Object_expr_kind, Overload_expr_kind> { };
+template<> struct Node_kinds<Decl_expr>        : Node_range<Object_expr_kind, Function_expr_kind> { };
+template<> struct Node_kinds<Dot_expr>         : Node_range<Field_expr_kind, Member_expr_kind> { };
+template<> struct Node_kinds<Nested_decl_expr> : Node_range<Field_expr_kind, Method_expr_kind> { };
+template<> struct Node_kinds<Binary_expr>      : Node_range<Add_expr_kind, Assign_expr_kind> { };
+template<> struct Node_kinds<Unary_expr>       : Node_range<Neg_expr_kind, Not_expr_kind> { };
+template<> struct Node_kinds<Conv>             : Node_range<Value_conv_kind, Ellipsis_conv_kind> { };
+template<> struct Node_kinds<Standard_conv>    : Node_range<Value_conv_kind, Numeric_conv_kind> { };
+template<> struct Node_kinds<Init>             : Node_range<Trivial_init_kind, Aggregate_init_kind> { };
+template<> struct Node_kinds<Req>              : Node_range<Type_req_kind, Deduction_req_kind> { };
+template<> struct Node_kinds<Stmt>             : Node_range<Empty_stmt_kind, Unparsed_stmt_kind> { };
+template<> struct Node_kinds<Decl>             : Node_range<Translation_unit_kind, Template_parm_kind> { };
+template<> struct Node_kinds<Object_decl>      : Node_range<Variable_decl_kind, Value_parm_kind> { };
+template<> struct Node_kinds<Variable_decl>    : Node_range<Variable_decl_kind, Field_decl_kind> { };
+template<> struct Node_kinds<Value_decl>       : Node_range<Constant_decl_kind, Constant_decl_kind> { };
+template<> struct Node_kinds<Function_decl>    : Node_range<Function_decl_kind, Method_decl_kind> { };
+template<> struct Node_kinds<Type_decl>        : Node_range<Class_decl_kind, Type_parm_kind> { };
+template<> struct Node_kinds<Def>              : Node_range<Empty_def_kind, Concept_def_kind> { };
+template<> struct Node_kinds<Cons>             : Node_range<Concept_cons_kind, Disjunction_cons_kind> { };
+template<> struct Node_kinds<Binary_cons>      : Node_range<Conjunction_cons_kind, Disjunction_cons_kind> { };
+
+
+// True when a dynamic type test for `T` on an object of static type
+// `U` can be answered by the kind of the term.
+template<typename T, typename U>
+constexpr bool
+is_node_test()
+{
+  using V = std::remove_cv_t<U>;
+  return Node_kinds<std::remove_cv_t<T>>::is_node
+      && std::is_base_of<Term, V>::value
+      && (std::is_base_of<V, T>::value || std::is_base_of<T, V>::value);
+}
+
+
+// Implements dynamic type tests and casts of terms using node kinds.
+template<typename T, typename U, bool = is_node_test<T, U>()>
+struct Node_cast
+{
+  using R = std::conditional_t<std::is_const<U>::value, T const, T>;
+
+  static bool test(U* u)
+  {
+    return u && Node_kinds<std::remove_cv_t<T>>::contains(u->node_kind());
+  }
+
+  static R* as(U* u)   { return test(u) ? static_cast<R*>(u) : nullptr; }
+  static R* cast(U* u) { return static_cast<R*>(u); }
+};
+
+
+// Any other test or cast (e.g., of symbols or values) falls back to a
+// dynamic_cast.
+template<typename T, typename U>
+struct Node_cast<T, U, false>
+{
+  static bool           test(U* u) { return lingo::is<T>(u); }
+  static decltype(auto) as(U* u)   { return lingo::as<T>(u); }
+  static decltype(auto) cast(U* u) { return lingo::cast<T>(u); }
+};
+
+
+// Returns true if `u` is non-null and has dynamic type `T`.
+template<typename T, typename U>
+inline bool
+is(U* u)
+{
+  return Node_cast<T, U>::test(u);
+}
+
+
+// Returns true if `u` has dynamic type `T`.
+template<typename T, typename U>
+inline bool
+is(U& u)
+{
+  return Node_cast<T, U>::test(&u);
+}
+
+
+// Returns `u` as a pointer to `T` if it has that dynamic type, and
+// null otherwise.
+template<typename T, typename U>
+inline decltype(auto)
+as(U* u)
+{
+  return Node_cast<T, U>::as(u);
+}
+
+
+// Returns `u` as a reference to `T`. The dynamic type of `u` must be `T`.
+template<typename T, typename U>
+inline decltype(auto)
+as(U& u)
+{
+  lingo_assert(is<T>(u));
+  return *Node_cast<T, U>::as(&u);
+}
+
+
+// Returns `u` as a pointer to `T`. The pointer must be null or have
+// dynamic type `T`.
+template<typename T, typename U>
+inline decltype(auto)
+cast(U* u)
+{
+  lingo_assert(!u || is<T>(u));
+  return Node_cast<T, U>::cast(u);
+}
+
+
+// Returns `u` as a reference to `T`. The dynamic type of `u` must be `T`.
+template<typename T, typename U>
+inline decltype(auto)
+cast(U& u)
+{
+  lingo_assert(is<T>(u));
+  return *Node_cast<T, U>::cast(&u);
+}
+
+
 // -------------------------------------------------------------------------- //
 // Lists
 
 
-// FIXME: Make this a random access iterator.
+// Returns a reference to the arena in which the storage of lists copied
+// into newly constructed nodes is allocated, or a reference to nullptr if
+// there is none. The arena is installed by Builder::make for the duration
+// of a node's construction (see Use_list_arena). Lists copied outside of
+// that are allocated on the heap.
+Arena*& list_arena();
+
+
+// Installs an arena for list storage, restoring the previous arena on
+// exit.
+struct Use_list_arena
+{
+  Use_list_arena(Arena& a)
+    : prev(list_arena())
+  {
+    list_arena() = &a;
+  }
+
+  ~Use_list_arena()
+  {
+    list_arena() = prev;
+  }
+
+  Arena* prev;
+};
+
+
+// A random access iterator over the terms of a list.
 template<typename T>
 struct List_iterator
 {
-  using Iter              = typename std::vector<T*>::iterator;
+  using Ptr               = T**;
   using value_type        = T;
   using reference         = T&;
   using pointer           = T*;
   using difference_type   = std::ptrdiff_t;
-  using iterator_category = std::forward_iterator_tag;
+  using iterator_category = std::random_access_iterator_tag;
 
   List_iterator() = default;
 
-  List_iterator(Iter i)
-    : iter(i)
+  List_iterator(Ptr p)
+    : ptr(p)
   { }
 
-  reference operator*() const { return **iter; }
-  pointer  operator->() const { return *iter; }
+  reference operator*() const                  { return **ptr; }
+  pointer   operator->() const                 { return *ptr; }
+  reference operator[](difference_type n) const { return *ptr[n]; }
+
+  List_iterator& operator++()    { ++ptr; return *this; }
+  List_iterator  operator++(int) { List_iterator x = *this; ++ptr; return x; }
+  List_iterator& operator--()    { --ptr; return *this; }
+  List_iterator  operator--(int) { List_iterator x = *this; --ptr; return x; }
 
-  List_iterator& operator++()    { ++iter; return *this; }
-  List_iterator  operator++(int) { List_iterator x = *this; ++iter; return x; }
+  List_iterator& operator+=(difference_type n) { ptr += n; return *this; }
+  List_iterator& operator-=(difference_type n) { ptr -= n; return *this; }
 
-  bool operator==(List_iterator i) const { return iter == i.iter; }
-  bool operator!=(List_iterator i) const { return iter != i.iter; }
-  List_iterator operator=(const List_iterator &i) {
-    iter = i.iter;
-    return *this; }
+  List_iterator operator+(difference_type n) const { return ptr + n; }
+  List_iterator operator-(difference_type n) const { return ptr - n; }
 
-  Iter iter;
+  difference_type operator-(List_iterator i) const { return ptr - i.ptr; }
+
+  bool operator==(List_iterator i) const { return ptr == i.ptr; }
+  bool operator!=(List_iterator i) const { return ptr != i.ptr; }
+  bool operator<(List_iterator i) const  { return ptr < i.ptr; }
+  bool operator>(List_iterator i) const  { return ptr > i.ptr; }
+  bool operator<=(List_iterator i) const { return ptr <= i.ptr; }
+  bool operator>=(List_iterator i) const { return ptr >= i.ptr; }
+
+  Ptr ptr;
 };
 
 
 template<typename T>
 struct List_iterator<T const>
 {
-  using Iter              = typename std::vector<T*>::const_iterator;
+  using Ptr               = T* const*;
   using value_type        = T;
   using reference         = T const&;
   using pointer           = T const*;
   using difference_type   = std::ptrdiff_t;
-  using iterator_category = std::forward_iterator_tag;
+  using iterator_category = std::random_access_iterator_tag;
 
   List_iterator() = default;
 
-  List_iterator(Iter i)
-    : iter(i)
+  List_iterator(Ptr p)
+    : ptr(p)
   { }
 
   List_iterator(List_iterator<T> i)
-    : iter(i.iter)
+    : ptr(i.ptr)
   { }
 
-  reference operator*() const { return **iter; }
-  pointer  operator->() const { return *iter; }
+  reference operator*() const                  { return **ptr; }
+  pointer   operator->() const                 { return *ptr; }
+  reference operator[](difference_type n) const { return *ptr[n]; }
+
+  List_iterator& operator++()    { ++ptr; return *this; }
+  List_iterator  operator++(int) { List_iterator x = *this; ++ptr; return x; }
+  List_iterator& operator--()    { --ptr; return *this; }
+  List_iterator  operator--(int) { List_iterator x = *this; --ptr; return x; }
 
-  List_iterator& operator++()    { ++iter; return *this; }
-  List_iterator  operator++(int) { List_iterator x = *this; ++iter; return x; }
+  List_iterator& operator+=(difference_type n) { ptr += n; return *this; }
+  List_iterator& operator-=(difference_type n) { ptr -= n; return *this; }
 
-  bool operator==(List_iterator i) const { return iter == i.iter; }
-  bool operator!=(List_iterator i) const { return iter != i.iter; }
+  List_iterator operator+(difference_type n) const { return ptr + n; }
+  List_iterator operator-(difference_type n) const { return ptr - n; }
 
-  Iter iter;
+  difference_type operator-(List_iterator i) const { return ptr - i.ptr; }
+
+  bool operator==(List_iterator i) const { return ptr == i.ptr; }
+  bool operator!=(List_iterator i) const { return ptr != i.ptr; }
+  bool operator<(List_iterator i) const  { return ptr < i.ptr; }
+  bool operator>(List_iterator i) const  { return ptr > i.ptr; }
+  bool operator<=(List_iterator i) const { return ptr <= i.ptr; }
+  bool operator>=(List_iterator i) const { return ptr >= i.ptr; }
+
+  Ptr ptr;
 };
 
 
 template<typename T>
-struct List : Term, std::vector<T*>
+inline List_iterator<T>
+operator+(std::ptrdiff_t n, List_iterator<T> i)
 {
-  using base_type = std::vector<T*>;
-  using iterator = List_iterator<T>;
-  using const_iterator = List_iterator<T const>;
+  return i + n;
+}
 
-  List() = default;
 
-  List(base_type const& x)
-    : base_type(x)
-  { }
+// A list of terms.
+//
+// Most lists are short, so a list stores up to inline_size terms
+// within itself. Longer lists are stored on the heap or, when copied
+// into a node under construction, in the list arena. Storage in the
+// arena is sized exactly and is never freed by the list; a list that
+// grows beyond its arena storage moves to the heap.
+template<typename T>
+struct List : Term
+{
+  static constexpr std::size_t inline_size = 2;
+
+  using value_type     = T*;
+  using size_type      = std::size_t;
+  using iterator       = List_iterator<T>;
+  using const_iterator = List_iterator<T const>;
 
-  List(base_type&& x)
-    : base_type(std::move(x))
+  List()
+    : data_(small_), size_(0), cap_(inline_size), heap_(false)
   { }
 
+  List(std::vector<T*> const& x)
+    : List()
+  {
+    init(x.data(), x.data() + x.size());
+  }
+
   List(std::initializer_list<T*> list)
-    : base_type(list)
-  { }
+    : List()
+  {
+    init(list.begin(), list.end());
+  }
+
+  List(List const& x)
+    : Term(x), data_(small_), size_(0), cap_(inline_size), heap_(false)
+  {
+    init(x.data_, x.data_ + x.size_);
+  }
+
+  List(List&&);
+  ~List();
 
-  std::vector<T*> const& base() const { return *this; }
-  std::vector<T*>&       base()       { return *this; }
+  List& operator=(List const&);
+  List& operator=(List&&);
 
-  T const& front() const { return *base().front(); }
-  T&       front()       { return *base().front(); }
+  Node_kind node_kind() const { return List_kind; }
 
-  T const& back() const { return *base().back(); }
-  T&       back()       { return *base().back(); }
+  bool        empty() const    { return size_ == 0; }
+  std::size_t size() const     { return size_; }
+  std::size_t capacity() const { return cap_; }
 
-  void push_back(T& x) { base().push_back(&x); }
-  void push_back(T* x) { base().push_back(x); }
+  T* const* data() const { return data_; }
+  T**       data()       { return data_; }
+
+  T* const& operator[](std::size_t n) const { return data_[n]; }
+  T*&       operator[](std::size_t n)       { return data_[n]; }
+
+  T const& front() const { return *data_[0]; }
+  T&       front()       { return *data_[0]; }
+
+  T const& back() const { return *data_[size_ - 1]; }
+  T&       back()       { return *data_[size_ - 1]; }
+
+  void push_back(T& x) { push_back(&x); }
+  void push_back(T* x);
+  void pop_back()      { --size_; }
+  void clear()         { size_ = 0; }
+  void reserve(std::size_t);
+  void resize(std::size_t);
 
   template<typename I>
   void append(I, I);
 
-  iterator begin() { return base().begin(); }
-  iterator end()   { return base().end(); }
+  iterator insert(const_iterator, T*);
+  iterator erase(const_iterator);
+  iterator remove_itr(const_iterator pos) { return erase(pos); }
+
+  iterator begin() { return data_; }
+  iterator end()   { return data_ + size_; }
+
+  const_iterator begin() const { return data_; }
+  const_iterator end() const   { return data_ + size_; }
 
-  iterator remove_itr(const_iterator pos)   { return base().erase(pos.iter);}
+  void init(T* const*, T* const*);
+  void release();
 
-  const_iterator begin() const { return base().begin(); }
-  const_iterator end() const   { return base().end(); }
+  T**           data_;  // The terms
+  std::uint32_t size_;  // The number of terms
+  std::uint32_t cap_;   // The capacity of data_
+  bool          heap_;  // True if data_ is on the heap
+  T*            small_[inline_size];
 };
 
+
+// Initialize the list with the terms in [first, last). If the terms do
+// not fit within the list, they are stored in the list arena, if any,
+// and on the heap otherwise.
+template<typename T>
+void
+List<T>::init(T* const* first, T* const* last)
+{
+  std::size_t n = last - first;
+  if (n > inline_size) {
+    if (Arena* a = list_arena()) {
+      data_ = a->allocate<T*>(n);
+    } else {
+      data_ = new T*[n];
+      heap_ = true;
+    }
+    cap_ = n;
+  }
+  std::copy(first, last, data_);
+  size_ = n;
+}
+
+
+// Move the terms of x into this list, stealing its storage if it is
+// not inline.
+template<typename T>
+List<T>::List(List&& x)
+  : Term(x)
+{
+  if (x.data_ == x.small_) {
+    data_ = small_;
+    std::copy(x.small_, x.small_ + x.size_, small_);
+  } else {
+    data_ = x.data_;
+  }
+  size_ = x.size_;
+  cap_ = x.cap_;
+  heap_ = x.heap_;
+  x.data_ = x.small_;
+  x.size_ = 0;
+  x.cap_ = inline_size;
+  x.heap_ = false;
+}
+
+
+template<typename T>
+List<T>::~List()
+{
+  release();
+}
+
+
+// Free heap-allocated storage.
+template<typename T>
+inline void
+List<T>::release()
+{
+  if (heap_)
+    delete[] data_;
+}
+
+
+// Note that the location of this list is not modified.
+template<typename T>
+List<T>&
+List<T>::operator=(List const& x)
+{
+  if (this != &x) {
+    clear();
+    reserve(x.size_);
+    std::copy(x.data_, x.data_ + x.size_, data_);
+    size_ = x.size_;
+  }
+  return *this;
+}
+
+
+// Note that the location of this list is not modified.
+template<typename T>
+List<T>&
+List<T>::operator=(List&& x)
+{
+  if (this != &x) {
+    if (x.data_ == x.small_) {
+      *this = static_cast<List const&>(x);
+      x.clear();
+    } else {
+      release();
+      data_ = x.data_;
+      size_ = x.size_;
+      cap_ = x.cap_;
+      heap_ = x.heap_;
+      x.data_ = x.small_;
+      x.size_ = 0;
+      x.cap_ = inline_size;
+      x.heap_ = false;
+    }
+  }
+  return *this;
+}
+
+
+// Ensure that the list can hold at least n terms. New storage is
+// always allocated on the heap.
+template<typename T>
+void
+List<T>::reserve(std::size_t n)
+{
+  if (n <= cap_)
+    return;
+  T** p = new T*[n];
+  std::copy(data_, data_ + size_, p);
+  release();
+  data_ = p;
+  cap_ = n;
+  heap_ = true;
+}
+
+
+// Resize the list to n terms. New terms are null.
+template<typename T>
+void
+List<T>::resize(std::size_t n)
+{
+  reserve(n);
+  std::fill(data_ + std::min<std::size_t>(size_, n), data_ + n, nullptr);
+  size_ = n;
+}
+
+
+template<typename T>
+inline void
+List<T>::push_back(T* x)
+{
+  if (size_ == cap_)
+    reserve(2 * cap_);
+  data_[size_++] = x;
+}
+
+
 // Insert a range of iterators at the end of the list.
 template<typename T>
 template<typename I>
@@ -215,6 +680,33 @@ List<T>::append(I first, I last)
 }
 
 
+// Insert x before pos, returning an iterator to the inserted term.
+template<typename T>
+auto
+List<T>::insert(const_iterator pos, T* x) -> iterator
+{
+  std::size_t n = pos.ptr - data_;
+  if (size_ == cap_)
+    reserve(2 * cap_);
+  std::copy_backward(data_ + n, data_ + size_, data_ + size_ + 1);
+  data_[n] = x;
+  ++size_;
+  return data_ + n;
+}
+
+
+// Remove the term at pos, returning an iterator to the term after it.
+template<typename T>
+auto
+List<T>::erase(const_iterator pos) -> iterator
+{
+  std::size_t n = pos.ptr - data_;
+  std::copy(data_ + n + 1, data_ + size_, data_ + n);
+  --size_;
+  return data_ + n;
+}
+
+
 // Lists
 using Term_list = List<Term>;
 using Type_list = List<Type>;
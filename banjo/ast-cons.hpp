@@ -50,6 +50,7 @@ struct Concept_cons : Cons
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Concept_cons_kind; }
 
   // Returns the resolved concept declaration.
   Concept_decl const& declaration() const { return cast<Concept_decl>(*decl); }
@@ -73,6 +74,7 @@ struct Predicate_cons : Cons
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Predicate_cons_kind; }
 
   // Returns the expression to be evaluated.
   Expr const& expression() const { return *expr; }
@@ -91,6 +93,7 @@ struct Expression_cons : Cons
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Expression_cons_kind; }
 
   Expr const& expression() const { return *expr; }
   Expr&       expression()       { return *expr; }
@@ -110,6 +113,7 @@ struct Type_cons : Cons
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Type_cons_kind; }
 };
 
 
@@ -122,6 +126,7 @@ struct Conversion_cons : Cons
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Conversion_cons_kind; }
 
   Expr const& expression() const { return *expr; }
   Expr&       expression()       { return *expr; }
@@ -141,6 +146,7 @@ struct Deduction_cons : Cons
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Deduction_cons_kind; }
 };
 
 
@@ -155,6 +161,7 @@ struct Parameterized_cons : Cons
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Parameterized_cons_kind; }
 
   Decl_list const& variables() const { return vars; }
   Decl_list&       variables()       { return vars; }
@@ -194,6 +201,7 @@ struct Conjunction_cons : Binary_cons
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Conjunction_cons_kind; }
 };
 
 
@@ -204,6 +212,7 @@ struct Disjunction_cons : Binary_cons
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Disjunction_cons_kind; }
 };
 
 
@@ -240,21 +249,31 @@ struct Generic_cons_mutator : Cons::Mutator, Generic_mutator<F, T>
 
 // Apply a function to the given constraint.
 template<typename F, typename T = typename std::result_of<F(Concept_cons const&)>::type>
-inline decltype(auto)
+inline T
 apply(Cons const& c, F fn)
 {
-  Generic_cons_visitor<F, T> vis(fn);
-  return accept(c, vis);
+  switch (c.node_kind()) {
+#define define_node(Node) case Node##_kind: return fn(static_cast<Node const&>(c));
+#include "ast-cons.def"
+#undef define_node
+  default: break;
+  }
+  lingo_unreachable();
 }
 
 
 // Apply a function to the given name.
 template<typename F, typename T = typename std::result_of<F(Concept_cons&)>::type>
-inline decltype(auto)
+inline T
 apply(Cons& c, F fn)
 {
-  Generic_cons_mutator<F, T> vis(fn);
-  return accept(c, vis);
+  switch (c.node_kind()) {
+#define define_node(Node) case Node##_kind: return fn(static_cast<Node&>(c));
+#include "ast-cons.def"
+#undef define_node
+  default: break;
+  }
+  lingo_unreachable();
 }
 
 
@@ -133,6 +133,7 @@ struct Translation_unit : Decl
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Translation_unit_kind; }
 
   // Returns the list of statements.
   Stmt_list const& statements() const { return stmts_; }
@@ -165,6 +166,7 @@ struct Variable_decl : Object_decl
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Variable_decl_kind; }
 
   // Returns the initializer for the variable.
   Def const& initializer() const { return *def_; }
@@ -183,6 +185,7 @@ struct Constant_decl : Value_decl
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Constant_decl_kind; }
 
   // Returns the initializer for the variable.
   Def const& initializer() const { return *def_; }
@@ -209,6 +212,7 @@ struct Function_decl : Decl
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Function_decl_kind; }
 
   // Returns the type of this declaration.
   Function_type const& type() const;
@@ -261,6 +265,7 @@ struct Class_decl : Type_decl
   
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Class_decl_kind; }
 
   // Returns the definition of the class.
   Def const& definition() const { return *def_; }
@@ -279,6 +284,7 @@ struct Extension_decl : Type_decl
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Extension_decl_kind; }
 
   Def const& definition() const { return *def_; }
   Def&       definition()       { return *def_; }
@@ -295,6 +301,7 @@ struct Coroutine_decl :Type_decl
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Coroutine_decl_kind; }
 
 
   Def const& definition() const { return *def_; }
@@ -325,6 +332,7 @@ struct Field_decl : Variable_decl
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Field_decl_kind; }
 
   // Returns the index of the field within the class.
   int index() const { return index_; }
@@ -342,6 +350,7 @@ struct Super_decl : Object_decl
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Super_decl_kind; }
 
   // Returns the declared type of the super
   Type const& type() const { return *type_; }
@@ -366,6 +375,7 @@ struct Method_decl : Function_decl
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Method_decl_kind; }
 };
 
 
@@ -392,6 +402,7 @@ struct Template_decl : Decl
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Template_decl_kind; }
 
   // Returns the template parameters of the declaration.
   Decl_list const& parameters() const { return parms; }
@@ -435,6 +446,7 @@ struct Concept_decl : Decl
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Concept_decl_kind; }
 
   // Returns the template parameters of the declaration.
   Decl_list const& parameters() const { return parms; }
@@ -504,6 +516,7 @@ struct Object_parm : Parameter_decl<Object_decl>
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Object_parm_kind; }
 
   // Returns the default argument for the parameter.
   // This is valid iff has_default_arguement() is true.
@@ -532,6 +545,7 @@ struct Value_parm : Parameter_decl<Object_decl>
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Value_parm_kind; }
 
   // Returns the default argument for the parameter.
   // This is valid iff has_default_arguement() is true.
@@ -559,6 +573,7 @@ struct Type_parm : Parameter_decl<Type_decl>
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Type_parm_kind; }
 
   // Returns the default argument for the parameter.
   // This is valid iff has_default_arguement() is true.
@@ -588,6 +603,7 @@ struct Template_parm : Parameter_decl<Decl>
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Template_parm_kind; }
 
   // Returns the tempalte declaration that defines the
   // signature of accepted arguments.
@@ -669,21 +685,31 @@ struct Generic_decl_mutator : Decl::Mutator, Generic_mutator<F, T>
 
 // Apply a function to the given declaration.
 template<typename F, typename T = typename std::result_of<F(Variable_decl const&)>::type>
-inline decltype(auto)
+inline T
 apply(Decl const& d, F fn)
 {
-  Generic_decl_visitor<F, T> vis(fn);
-  return accept(d, vis);
+  switch (d.node_kind()) {
+#define define_node(Node) case Node##_kind: return fn(static_cast<Node const&>(d));
+#include "ast-decl.def"
+#undef define_node
+  default: break;
+  }
+  lingo_unreachable();
 }
 
 
 // Apply a function to the given declaration.
 template<typename F, typename T = typename std::result_of<F(Variable_decl&)>::type>
-inline decltype(auto)
+inline T
 apply(Decl& d, F fn)
 {
-  Generic_decl_mutator<F, T> vis(fn);
-  return accept(d, vis);
+  switch (d.node_kind()) {
+#define define_node(Node) case Node##_kind: return fn(static_cast<Node&>(d));
+#include "ast-decl.def"
+#undef define_node
+  default: break;
+  }
+  lingo_unreachable();
 }
 
 
@@ -54,6 +54,7 @@ struct Empty_def : Def
 {
   void accept(Visitor& v) const { return v.visit(*this); }
   void accept(Mutator& v)       { return v.visit(*this); }
+  Node_kind node_kind() const   { return Empty_def_kind; }
 };
 
 
@@ -71,6 +72,7 @@ struct Defaulted_def : Def
 {
   void accept(Visitor& v) const { return v.visit(*this); }
   void accept(Mutator& v)       { return v.visit(*this); }
+  Node_kind node_kind() const   { return Defaulted_def_kind; }
 };
 
 
@@ -82,6 +84,7 @@ struct Deleted_def : Def
 {
   void accept(Visitor& v) const { return v.visit(*this); }
   void accept(Mutator& v)       { return v.visit(*this); }
+  Node_kind node_kind() const   { return Deleted_def_kind; }
 };
 
 
@@ -95,6 +98,7 @@ struct Expression_def : Def
 
   void accept(Visitor& v) const { return v.visit(*this); }
   void accept(Mutator& v)       { return v.visit(*this); }
+  Node_kind node_kind() const   { return Expression_def_kind; }
 
   // Returns the expression that defines the entity.
   Expr&       expression()       { return *expr_; }
@@ -116,6 +120,7 @@ struct Function_def : Def
 
   void accept(Visitor& v) const { return v.visit(*this); }
   void accept(Mutator& v)       { return v.visit(*this); }
+  Node_kind node_kind() const   { return Function_def_kind; }
 
   // Returns the statement associated with the function
   // definition.
@@ -143,6 +148,7 @@ struct Class_def : Def
 
   void accept(Visitor& v) const { return v.visit(*this); }
   void accept(Mutator& v)       { return v.visit(*this); }
+  Node_kind node_kind() const   { return Class_def_kind; }
 
   // Returns the list of member statements.
   Stmt_list const& statements() const { return stmts_; }
@@ -177,6 +183,7 @@ struct Concept_def : Def
 
   void accept(Visitor& v) const { return v.visit(*this); }
   void accept(Mutator& v)       { return v.visit(*this); }
+  Node_kind node_kind() const   { return Concept_def_kind; }
 
   // Returns the sequence of required declarations.
   Req_list const& requirements() const { return reqs; }
@@ -218,20 +225,30 @@ struct Generic_def_mutator : Def::Mutator, Generic_mutator<F, T>
 
 
 template<typename F, typename T = typename std::result_of<F(Empty_def const&)>::type>
-inline decltype(auto)
+inline T
 apply(Def const& t, F fn)
 {
-  Generic_def_visitor<F, T> vis(fn);
-  return accept(t, vis);
+  switch (t.node_kind()) {
+#define define_node(Node) case Node##_kind: return fn(static_cast<Node const&>(t));
+#include "ast-def.def"
+#undef define_node
+  default: break;
+  }
+  lingo_unreachable();
 }
 
 
 template<typename F, typename T = typename std::result_of<F(Empty_def&)>::type>
-inline decltype(auto)
+inline T
 apply(Def& t, F fn)
 {
-  Generic_def_mutator<F, T> vis(fn);
-  return accept(t, vis);
+  switch (t.node_kind()) {
+#define define_node(Node) case Node##_kind: return fn(static_cast<Node&>(t));
+#include "ast-def.def"
+#undef define_node
+  default: break;
+  }
+  lingo_unreachable();
 }
 
 
@@ -4,8 +4,6 @@
 #include "ast-eq.hpp"
 #include "ast.hpp"
 
-#include <typeindex>
-
 
 namespace banjo
 {
@@ -31,9 +29,7 @@ is_equivalent(Term const& x1, Term const& x2)
     return true;
 
   // Types of different kinds are not the same.
-  std::type_index ti1 = typeid(x1);
-  std::type_index ti2 = typeid(x2);
-  if (ti1 != ti2)
+  if (x1.node_kind() != x2.node_kind())
     return false;
 
   if (Type const* t1 = as<Type>(&x1))
@@ -145,9 +141,7 @@ is_equivalent(Name const& n1, Name const& n2)
     return true;
 
   // Types of different kinds are not the same.
-  std::type_index ti1 = typeid(n1);
-  std::type_index ti2 = typeid(n2);
-  if (ti1 != ti2)
+  if (n1.node_kind() != n2.node_kind())
     return false;
 
   // Find a comparison of the types.
@@ -255,9 +249,7 @@ is_equivalent(Type const& t1, Type const& t2)
     return true;
 
   // Types of different kinds are not the same.
-  std::type_index ti1 = typeid(t1);
-  std::type_index ti2 = typeid(t2);
-  if (ti1 != ti2)
+  if (t1.node_kind() != t2.node_kind())
     return false;
 
   // Find a comparison of the types.
@@ -276,6 +268,18 @@ is_equivalent(Literal_expr<T> const& e1, Literal_expr<T> const& e2)
 }
 
 
+// Small values are never equal to large values.
+bool
+is_equivalent(Integer_expr const& e1, Integer_expr const& e2)
+{
+  if (e1.is_small() && e2.is_small())
+    return e1.small_value() == e2.small_value();
+  if (e1.is_small() || e2.is_small())
+    return false;
+  return e1.value() == e2.value();
+}
+
+
 bool
 is_equivalent(Decl_expr const& e1, Decl_expr const& e2)
 {
@@ -336,9 +340,7 @@ is_equivalent(Expr const& e1, Expr const& e2)
     return true;
 
   // Types of different kinds are not the same.
-  std::type_index ti1 = typeid(e1);
-  std::type_index ti2 = typeid(e2);
-  if (ti1 != ti2)
+  if (e1.node_kind() != e2.node_kind())
     return false;
 
   // Delegate to specific rules.
@@ -450,9 +452,7 @@ is_equivalent(Cons const& c1, Cons const& c2)
     return true;
 
   // Types of different kinds are not the same.
-  std::type_index ti1 = typeid(c1);
-  std::type_index ti2 = typeid(c2);
-  if (ti1 != ti2)
+  if (c1.node_kind() != c2.node_kind())
     return false;
 
   // Delegate to specific rules.
@@ -9,6 +9,25 @@
 namespace banjo
 {
 
+// The value is stored inline when it is unchanged by conversion to a
+// signed 64-bit integer. For an unsigned type, that excludes values with
+// the high bit set, which would otherwise be read back as negative.
+Integer_expr::Integer_expr(Type& t, Integer const& n)
+  : Expr(t), small_(0), big_()
+{
+  Integer_type const* z = as<Integer_type>(&t);
+  bool small;
+  if (z && z->is_unsigned())
+    small = n.impl().getActiveBits() < 64;
+  else
+    small = n.impl().getMinSignedBits() <= 64;
+  if (small)
+    small_ = n.impl().getSExtValue();
+  else
+    big_.reset(new Integer(n));
+}
+
+
 Object_decl const&
 Object_expr::declaration() const
 {
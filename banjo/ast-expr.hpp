@@ -6,6 +6,8 @@
 
 #include "ast-base.hpp"
 
+#include <memory>
+
 
 namespace banjo
 {
@@ -123,16 +125,36 @@ struct Boolean_expr : Literal_expr<bool>
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Boolean_expr_kind; }
 };
 
 
-// An integer-valued literal.
-struct Integer_expr : Literal_expr<Integer>
+// An integer literal. Values that fit in 64 bits are stored inline.
+// An arbitrary precision integer is allocated only for values that
+// do not.
+struct Integer_expr : Expr
 {
-  using Literal_expr<Integer>::Literal_expr;
+  Integer_expr(Type& t, std::int64_t n)
+    : Expr(t), small_(n), big_()
+  { }
+
+  Integer_expr(Type& t, Integer const& n);
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Integer_expr_kind; }
+
+  // Returns true if the value is stored inline.
+  bool is_small() const { return !big_; }
+
+  // Returns the inline value of the literal.
+  std::int64_t small_value() const { lingo_assert(is_small()); return small_; }
+
+  // Returns the interpreted value of the literal.
+  Integer value() const { return big_ ? *big_ : Integer(small_); }
+
+  std::int64_t             small_;
+  std::unique_ptr<Integer> big_;
 };
 
 
@@ -143,6 +165,7 @@ struct Real_expr : Literal_expr<lingo::Real>
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Real_expr_kind; }
 };
 
 
@@ -156,6 +179,7 @@ struct Tuple_expr : Expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Tuple_expr_kind; }
 
   Expr_list const& elements() const { return elems; }
   Expr_list&       elements()       { return elems; }
@@ -205,6 +229,7 @@ struct Object_expr : Decl_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Object_expr_kind; }
 
   // Returns the referenced variable or parameter.
   Object_decl const& declaration() const;
@@ -219,6 +244,7 @@ struct Value_expr : Decl_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Value_expr_kind; }
 
   // Returns the referenced variable or parameter.
   Constant_decl const& declaration() const;
@@ -233,6 +259,7 @@ struct Function_expr : Decl_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Function_expr_kind; }
 
   // Returns the referenced function.
   Function_decl const& declaration() const;
@@ -253,6 +280,7 @@ struct Overload_expr : Id_expr
   
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Overload_expr_kind; }
 
   // Returns the referenced declaration.
   Decl_list const& declarations() const { return decls_; }
@@ -310,6 +338,7 @@ struct Field_expr : Nested_decl_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Field_expr_kind; }
 };
 
 
@@ -321,6 +350,7 @@ struct Method_expr : Nested_decl_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Method_expr_kind; }
 };
 
 
@@ -331,6 +361,7 @@ struct Member_expr : Dot_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Member_expr_kind; }
 };
 
 
@@ -345,6 +376,7 @@ struct Check_expr : Expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Check_expr_kind; }
 
   Concept_decl const& declaration() const;
   Concept_decl&       declaration();
@@ -364,6 +396,7 @@ struct Add_expr : Binary_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Add_expr_kind; }
 };
 
 
@@ -374,6 +407,7 @@ struct Sub_expr : Binary_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Sub_expr_kind; }
 };
 
 
@@ -384,6 +418,7 @@ struct Mul_expr : Binary_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Mul_expr_kind; }
 };
 
 
@@ -394,6 +429,7 @@ struct Div_expr : Binary_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Div_expr_kind; }
 };
 
 
@@ -404,6 +440,7 @@ struct Rem_expr : Binary_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Rem_expr_kind; }
 };
 
 
@@ -414,6 +451,7 @@ struct Neg_expr : Unary_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Neg_expr_kind; }
 };
 
 
@@ -424,6 +462,7 @@ struct Pos_expr : Unary_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Pos_expr_kind; }
 };
 
 
@@ -434,6 +473,7 @@ struct Bit_and_expr : Binary_expr
 
   void accept(Visitor& v) const { return v.visit(*this); }
   void accept(Mutator& v)       { return v.visit(*this); }
+  Node_kind node_kind() const   { return Bit_and_expr_kind; }
 };
 
 
@@ -444,6 +484,7 @@ struct Bit_or_expr : Binary_expr
 
   void accept(Visitor& v) const { return v.visit(*this); }
   void accept(Mutator& v)       { return v.visit(*this); }
+  Node_kind node_kind() const   { return Bit_or_expr_kind; }
 };
 
 
@@ -454,6 +495,7 @@ struct Bit_xor_expr : Binary_expr
 
   void accept(Visitor& v) const { return v.visit(*this); }
   void accept(Mutator& v)       { return v.visit(*this); }
+  Node_kind node_kind() const   { return Bit_xor_expr_kind; }
 };
 
 
@@ -464,6 +506,7 @@ struct Bit_lsh_expr : Binary_expr
 
   void accept(Visitor& v) const { return v.visit(*this); }
   void accept(Mutator& v)       { return v.visit(*this); }
+  Node_kind node_kind() const   { return Bit_lsh_expr_kind; }
 };
 
 
@@ -474,6 +517,7 @@ struct Bit_rsh_expr : Binary_expr
 
   void accept(Visitor& v) const { return v.visit(*this); }
   void accept(Mutator& v)       { return v.visit(*this); }
+  Node_kind node_kind() const   { return Bit_rsh_expr_kind; }
 };
 
 
@@ -484,6 +528,7 @@ struct Bit_not_expr : Unary_expr
 
   void accept(Visitor& v) const { return v.visit(*this); }
   void accept(Mutator& v)       { return v.visit(*this); }
+  Node_kind node_kind() const   { return Bit_not_expr_kind; }
 };
 
 
@@ -494,6 +539,7 @@ struct Eq_expr : Binary_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Eq_expr_kind; }
 };
 
 
@@ -504,6 +550,7 @@ struct Ne_expr : Binary_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Ne_expr_kind; }
 };
 
 
@@ -514,6 +561,7 @@ struct Lt_expr : Binary_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Lt_expr_kind; }
 };
 
 
@@ -524,6 +572,7 @@ struct Gt_expr : Binary_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Gt_expr_kind; }
 };
 
 
@@ -534,6 +583,7 @@ struct Le_expr : Binary_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Le_expr_kind; }
 };
 
 
@@ -544,6 +594,7 @@ struct Ge_expr : Binary_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Ge_expr_kind; }
 };
 
 
@@ -554,6 +605,7 @@ struct Cmp_expr : Binary_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Cmp_expr_kind; }
 };
 
 
@@ -564,6 +616,7 @@ struct And_expr : Binary_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return And_expr_kind; }
 };
 
 
@@ -574,6 +627,7 @@ struct Or_expr : Binary_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Or_expr_kind; }
 };
 
 
@@ -584,6 +638,7 @@ struct Not_expr : Unary_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Not_expr_kind; }
 };
 
 
@@ -608,6 +663,7 @@ struct Call_expr : Expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Call_expr_kind; }
 
   Expr const& function() const { return *fn; }
   Expr&       function()       { return *fn; }
@@ -627,6 +683,7 @@ struct Assign_expr : Binary_expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Assign_expr_kind; }
 };
 
 
@@ -641,6 +698,7 @@ struct Requires_expr : Expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Requires_expr_kind; }
 
   // Returns the list of parameters in terms of which the requirements
   // are written.
@@ -675,6 +733,7 @@ struct Synthetic_expr : Expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Synthetic_expr_kind; }
 
   // Returns the declaration from which this expression was
   // synthesized.
@@ -694,6 +753,7 @@ struct Unparsed_expr : Expr
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Unparsed_expr_kind; }
 
   Token_seq const& tokens() const { return toks; }
   Token_seq&       tokens()       { return toks; }
@@ -750,6 +810,7 @@ struct Value_conv : Standard_conv
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Value_conv_kind; }
 };
 
 
@@ -761,6 +822,7 @@ struct Qualification_conv : Standard_conv
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Qualification_conv_kind; }
 };
 
 
@@ -771,6 +833,7 @@ struct Boolean_conv : Standard_conv
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Boolean_conv_kind; }
 };
 
 
@@ -781,6 +844,7 @@ struct Integer_conv : Standard_conv
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Integer_conv_kind; }
 };
 
 
@@ -791,6 +855,7 @@ struct Float_conv : Standard_conv
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Float_conv_kind; }
 };
 
 
@@ -803,6 +868,7 @@ struct Numeric_conv : Standard_conv
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Numeric_conv_kind; }
 };
 
 
@@ -815,6 +881,7 @@ struct Dependent_conv : Conv
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Dependent_conv_kind; }
 };
 
 
@@ -826,6 +893,7 @@ struct Ellipsis_conv : Conv
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Ellipsis_conv_kind; }
 };
 
 
@@ -855,6 +923,7 @@ struct Trivial_init : Init
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Trivial_init_kind; }
 };
 
 
@@ -869,6 +938,7 @@ struct Copy_init : Init
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Copy_init_kind; }
 
   // Returns the source expression.
   Expr const& expression() const { return *expr; }
@@ -888,6 +958,7 @@ struct Bind_init : Init
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Bind_init_kind; }
 
   // Returns the source expression.
   Expr const& expression() const { return *expr; }
@@ -910,6 +981,7 @@ struct Direct_init : Init
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Direct_init_kind; }
 
   // Returns the constructor declaration
   Decl const& consructor() const { return *ctor; }
@@ -934,6 +1006,7 @@ struct Aggregate_init : Init
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Aggregate_init_kind; }
 
   // Returns a sequence of selected initializers for
   // a compound target type.
@@ -1015,21 +1088,31 @@ struct Generic_expr_mutator : Expr::Mutator, Generic_mutator<F, T>
 
 // Apply a function to the given type.
 template<typename F, typename T = typename std::result_of<F(Boolean_expr const&)>::type>
-inline decltype(auto)
+inline T
 apply(Expr const& e, F fn)
 {
-  Generic_expr_visitor<F, T> vis(fn);
-  return accept(e, vis);
+  switch (e.node_kind()) {
+#define define_node(Node) case Node##_kind: return fn(static_cast<Node const&>(e));
+#include "ast-expr.def"
+#undef define_node
+  default: break;
+  }
+  lingo_unreachable();
 }
 
 
 // Apply a function to the given type.
 template<typename F, typename T = typename std::result_of<F(Boolean_expr&)>::type>
-inline decltype(auto)
+inline T
 apply(Expr& e, F fn)
 {
-  Generic_expr_mutator<F, T> vis(fn);
-  return accept(e, vis);
+  switch (e.node_kind()) {
+#define define_node(Node) case Node##_kind: return fn(static_cast<Node&>(e));
+#include "ast-expr.def"
+#undef define_node
+  default: break;
+  }
+  lingo_unreachable();
 }
 
 
@@ -4,17 +4,15 @@
 #include "ast-hash.hpp"
 #include "ast.hpp"
 
-#include <typeinfo>
-
 
 namespace banjo
 {
 
-// Returns an initial hash value based on the dynamic type of T.
+// Returns an initial hash value based on the kind of T.
 template<typename T>
 std::size_t hash_type(T const& t)
 {
-  return typeid(t).hash_code();
+  return t.node_kind();
 }
 
 
@@ -216,6 +214,18 @@ hash_value(Literal_expr<T> const& e)
 }
 
 
+std::size_t
+hash_value(Integer_expr const& e)
+{
+  std::size_t h = hash_type(e);
+  if (e.is_small())
+    boost::hash_combine(h, e.small_value());
+  else
+    boost::hash_combine(h, e.value());
+  return h;
+}
+
+
 std::size_t
 hash_value(Id_expr const& e)
 {
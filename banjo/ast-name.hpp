@@ -53,6 +53,7 @@ struct Simple_id : Name
 
   void accept(Visitor& v) const { v.visit(*this); };
   void accept(Mutator& v)       { v.visit(*this); };
+  Node_kind node_kind() const   { return Simple_id_kind; }
 
   Symbol const& symbol() const { return *first; }
 
@@ -70,6 +71,7 @@ struct Global_id : Name
 
   void accept(Visitor& v) const { v.visit(*this); };
   void accept(Mutator& v)       { v.visit(*this); };
+  Node_kind node_kind() const   { return Global_id_kind; }
 };
 
 
@@ -85,6 +87,7 @@ struct Placeholder_id : Name
 
   void accept(Visitor& v) const { v.visit(*this); };
   void accept(Mutator& v)       { v.visit(*this); };
+  Node_kind node_kind() const   { return Placeholder_id_kind; }
 
   int number() const { return num; }
 
@@ -103,6 +106,7 @@ struct Operator_id : Name
 
   void accept(Visitor& v) const { v.visit(*this); };
   void accept(Mutator& v)       { v.visit(*this); };
+  Node_kind node_kind() const   { return Operator_id_kind; }
 
   // Returns the operator kind.
   Operator_kind kind() const { return op; }
@@ -118,6 +122,7 @@ struct Conversion_id : Name
 {
   void accept(Visitor& v) const { v.visit(*this); };
   void accept(Mutator& v)       { v.visit(*this); };
+  Node_kind node_kind() const   { return Conversion_id_kind; }
 };
 
 
@@ -128,6 +133,7 @@ struct Literal_id : Name
 {
   void accept(Visitor& v) const { v.visit(*this); };
   void accept(Mutator& v)       { v.visit(*this); };
+  Node_kind node_kind() const   { return Literal_id_kind; }
 };
 
 
@@ -135,6 +141,7 @@ struct Literal_id : Name
 struct Destructor_id : Name
 {
   void accept(Mutator& v)       { v.visit(*this); };
+  Node_kind node_kind() const   { return Destructor_id_kind; }
   void accept(Visitor& v) const { v.visit(*this); };
 
   // Returns the type named by the destructor id.
@@ -161,6 +168,7 @@ struct Template_id : Name
 
   void accept(Visitor& v) const { v.visit(*this); };
   void accept(Mutator& v)       { v.visit(*this); };
+  Node_kind node_kind() const   { return Template_id_kind; }
 
   Template_decl const& declaration() const;
   Template_decl&       declaration();
@@ -186,6 +194,7 @@ struct Concept_id : Name
 
   void accept(Visitor& v) const { v.visit(*this); };
   void accept(Mutator& v)       { v.visit(*this); };
+  Node_kind node_kind() const   { return Concept_id_kind; }
 
   Concept_decl const& declaration() const;
   Concept_decl&       declaration();
@@ -216,6 +225,7 @@ struct Qualified_id : Name
 
   void accept(Visitor& v) const { v.visit(*this); };
   void accept(Mutator& v)       { v.visit(*this); };
+  Node_kind node_kind() const   { return Qualified_id_kind; }
 
   // Returns the qualifying scope (the enclosing declaration)
   // for the unqualified id.
@@ -268,21 +278,31 @@ struct Generic_name_mutator : Name::Mutator, Generic_mutator<F, T>
 
 // Apply a function to the given name.
 template<typename F, typename T = typename std::result_of<F(Simple_id const&)>::type>
-inline decltype(auto)
+inline T
 apply(Name const& n, F fn)
 {
-  Generic_name_visitor<F, T> vis(fn);
-  return accept(n, vis);
+  switch (n.node_kind()) {
+#define define_node(Node) case Node##_kind: return fn(static_cast<Node const&>(n));
+#include "ast-name.def"
+#undef define_node
+  default: break;
+  }
+  lingo_unreachable();
 }
 
 
 // Apply a function to the given name.
 template<typename F, typename T = typename std::result_of<F(Simple_id&)>::type>
-inline decltype(auto)
+inline T
 apply(Name& n, F fn)
 {
-  Generic_name_mutator<F, T> vis(fn);
-  return accept(n, vis);
+  switch (n.node_kind()) {
+#define define_node(Node) case Node##_kind: return fn(static_cast<Node&>(n));
+#include "ast-name.def"
+#undef define_node
+  default: break;
+  }
+  lingo_unreachable();
 }
 
 
@@ -57,6 +57,7 @@ struct Type_req : Req
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Type_req_kind; }
 
   // Returns the form of the type required.
   Type const& type() const { return *ty; }
@@ -77,6 +78,7 @@ struct Syntactic_req : Req
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Syntactic_req_kind; }
 
   Expr const& expression() const { return *req; }
   Expr&       expression()       { return *req; }
@@ -92,6 +94,7 @@ struct Semantic_req : Req
 {
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Semantic_req_kind; }
 
   Decl const& declaration() const { return *decl; }
   Decl&       declaration()       { return *decl; }
@@ -106,6 +109,7 @@ struct Expression_req : Req
 {
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Expression_req_kind; }
 
   Expr const& expression() const { return *expr; }
   Expr&       expression()       { return *expr; }
@@ -123,6 +127,7 @@ struct Basic_req : Req
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Basic_req_kind; }
 
   // Returns the required expression.
   Expr const& expression() const { return *expr; }
@@ -146,6 +151,7 @@ struct Conversion_req : Req
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Conversion_req_kind; }
 
   Expr const& expression() const { return *expr; }
   Expr&       expression()       { return *expr; }
@@ -170,6 +176,7 @@ struct Deduction_req : Req
 {
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Deduction_req_kind; }
 
   Expr const& expression() const { return *expr; }
   Expr&       expression()       { return *expr; }
@@ -218,8 +225,13 @@ template<typename F, typename T = typename std::result_of<F(Type_req const&)>::t
 inline T
 apply(Req const& r, F fn)
 {
-  Generic_req_visitor<F, T> vis(fn);
-  return accept(r, vis);
+  switch (r.node_kind()) {
+#define define_node(Node) case Node##_kind: return fn(static_cast<Node const&>(r));
+#include "ast-req.def"
+#undef define_node
+  default: break;
+  }
+  lingo_unreachable();
 }
 
 
@@ -228,8 +240,13 @@ template<typename F, typename T = typename std::result_of<F(Type_req&)>::type>
 inline T
 apply(Req& r, F fn)
 {
-  Generic_req_mutator<F, T> vis(fn);
-  return accept(r, vis);
+  switch (r.node_kind()) {
+#define define_node(Node) case Node##_kind: return fn(static_cast<Node&>(r));
+#include "ast-req.def"
+#undef define_node
+  default: break;
+  }
+  lingo_unreachable();
 }
 
 
@@ -42,6 +42,7 @@ struct Empty_stmt : Stmt
 {
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Empty_stmt_kind; }
 };
 
 
@@ -56,6 +57,7 @@ struct Compound_stmt : Stmt
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Compound_stmt_kind; }
 
   Stmt_list const& statements() const { return stmts_; }
   Stmt_list&       statements()       { return stmts_; }
@@ -74,6 +76,7 @@ struct Expression_stmt : Stmt
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Expression_stmt_kind; }
 
   // Returns the expression of the statement.
   Expr const& expression() const { return *expr_; }
@@ -92,6 +95,7 @@ struct Declaration_stmt : Stmt
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Declaration_stmt_kind; }
 
   // Returns the declaration of the statement.
   Decl const& declaration() const { return *decl_; }
@@ -110,6 +114,7 @@ struct Return_stmt : Stmt
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Return_stmt_kind; }
 
   // Returns the expression returned by the statement.
   Expr const& expression() const { return *expr_; }
@@ -127,6 +132,7 @@ struct Yield_stmt : Stmt
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator &v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Yield_stmt_kind; }
 
   Expr const& expression() const { return *expr_; }
   Expr&       expression()       { return *expr_; }
@@ -143,6 +149,7 @@ struct If_then_stmt : Stmt
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return If_then_stmt_kind; }
 
   Expr const& condition() const { return *cond_; }
   Expr&       condition()       { return *cond_; }
@@ -164,6 +171,7 @@ struct If_else_stmt : Stmt
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return If_else_stmt_kind; }
 
   Expr const& condition() const { return *cond_; }
   Expr&       condition()       { return *cond_; }
@@ -189,6 +197,7 @@ struct While_stmt : Stmt
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return While_stmt_kind; }
 
   Expr const& condition() const { return *cond_; }
   Expr&       condition()       { return *cond_; }
@@ -206,6 +215,7 @@ struct Break_stmt : Stmt
 {
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Break_stmt_kind; }
 };
 
 
@@ -214,6 +224,7 @@ struct Continue_stmt : Stmt
 {
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Continue_stmt_kind; }
 };
 
 
@@ -224,6 +235,7 @@ struct Unparsed_stmt : Unparsed_term<Stmt>
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Unparsed_stmt_kind; }
 };
 
 
@@ -263,8 +275,13 @@ template<typename F, typename T = typename std::result_of<F(Empty_stmt const&)>:
 inline T
 apply(Stmt const& s, F fn)
 {
-  Generic_stmt_visitor<F, T> vis(fn);
-  return accept(s, vis);
+  switch (s.node_kind()) {
+#define define_node(Node) case Node##_kind: return fn(static_cast<Node const&>(s));
+#include "ast-stmt.def"
+#undef define_node
+  default: break;
+  }
+  lingo_unreachable();
 }
 
 
@@ -273,8 +290,13 @@ template<typename F, typename T = typename std::result_of<F(Empty_stmt&)>::type>
 inline T
 apply(Stmt& s, F fn)
 {
-  Generic_stmt_mutator<F, T> vis(fn);
-  return accept(s, vis);
+  switch (s.node_kind()) {
+#define define_node(Node) case Node##_kind: return fn(static_cast<Node&>(s));
+#include "ast-stmt.def"
+#undef define_node
+  default: break;
+  }
+  lingo_unreachable();
 }
 
 
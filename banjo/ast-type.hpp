@@ -57,6 +57,7 @@ struct Void_type : Type
 {
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Void_type_kind; }
 };
 
 
@@ -65,6 +66,7 @@ struct Boolean_type : Type
 {
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Boolean_type_kind; }
 };
 
 
@@ -82,6 +84,7 @@ struct Integer_type : Type
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Integer_type_kind; }
 
   bool sign() const        { return sgn; }
   bool is_signed() const   { return sgn; }
@@ -99,6 +102,7 @@ struct Byte_type : Type
 {
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Byte_type_kind; }
 };
 
 
@@ -111,6 +115,7 @@ struct Float_type : Type
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Float_type_kind; }
 
   int precision() const { return prec; }
 
@@ -127,6 +132,7 @@ struct Function_type : Type
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Function_type_kind; }
 
   Type_list const& parameter_types() const { return parms; }
   Type_list&       parameter_types()       { return parms; }
@@ -165,6 +171,7 @@ struct Qualified_type : Unary_type
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Qualified_type_kind; }
 
   // Returns the qualifier for this type. Note that these
   // override functions in type.
@@ -186,6 +193,7 @@ struct Pointer_type : Unary_type
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Pointer_type_kind; }
 };
 
 
@@ -196,6 +204,7 @@ struct Reference_type : Unary_type
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Reference_type_kind; }
 
   // Returns the non-reference version of this type.
   Type const& non_reference_type() const { return type(); }
@@ -209,6 +218,7 @@ struct Array_type : Type
   
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Array_type_kind; }
 
   Type const& type() const { return *ty; }
   Type&       type()       { return *ty; }
@@ -234,6 +244,7 @@ struct Tuple_type : Type
   
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Tuple_type_kind; }
   
   Type_list const& element_types() const { return types_; }
   Type_list&       element_types()       { return types_; }
@@ -256,6 +267,7 @@ struct Slice_type : Unary_type
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Slice_type_kind; }
 };
 
 
@@ -265,6 +277,7 @@ struct Dynarray_type : Type
   
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Dynarray_type_kind; }
 
   Type const& type() const { return *ty; }
   Type&       type()       { return *ty; }
@@ -284,6 +297,7 @@ struct Pack_type : Unary_type
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Pack_type_kind; }
 };
 
 
@@ -317,6 +331,7 @@ struct Class_type : Declared_type
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Class_type_kind; }
 };
 
 
@@ -327,6 +342,7 @@ struct Typename_type : Declared_type
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Typename_type_kind; }
 };
 
 
@@ -340,6 +356,7 @@ struct Coroutine_type : Class_type
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Coroutine_type_kind; }
 
   // Returns the list of parameters used to initialize the
   // coroutine closure.
@@ -387,6 +404,7 @@ struct Auto_type : Declared_type
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Auto_type_kind; }
 };
 
 
@@ -396,6 +414,7 @@ struct Decltype_type : Type
 {
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Decltype_type_kind; }
 };
 
 
@@ -411,6 +430,7 @@ struct Synthetic_type : Declared_type
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Synthetic_type_kind; }
 };
 
 
@@ -419,6 +439,7 @@ struct Type_type : Type
 {
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Type_type_kind; }
 };
 
 
@@ -431,6 +452,7 @@ struct Unparsed_type : Type
 
   void accept(Visitor& v) const { v.visit(*this); }
   void accept(Mutator& v)       { v.visit(*this); }
+  Node_kind node_kind() const   { return Unparsed_type_kind; }
 
   Token_seq const& tokens() const { return toks; }
   Token_seq&       tokens()       { return toks; }
@@ -567,21 +589,31 @@ struct Generic_type_mutator : Type::Mutator, Generic_mutator<F, T>
 
 // Apply a function to the given type.
 template<typename F, typename T = typename std::result_of<F(Void_type const&)>::type>
-inline decltype(auto)
+inline T
 apply(Type const& t, F fn)
 {
-  Generic_type_visitor<F, T> vis(fn);
-  return accept(t, vis);
+  switch (t.node_kind()) {
+#define define_node(Node) case Node##_kind: return fn(static_cast<Node const&>(t));
+#include "ast-type.def"
+#undef define_node
+  default: break;
+  }
+  lingo_unreachable();
 }
 
 
 // Apply a function to the given type.
 template<typename F, typename T = typename std::result_of<F(Void_type&)>::type>
-inline decltype(auto)
+inline T
 apply(Type& t, F fn)
 {
-  Generic_type_mutator<F, T> vis(fn);
-  return accept(t, vis);
+  switch (t.node_kind()) {
+#define define_node(Node) case Node##_kind: return fn(static_cast<Node&>(t));
+#include "ast-type.def"
+#undef define_node
+  default: break;
+  }
+  lingo_unreachable();
 }
 
 
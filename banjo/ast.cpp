@@ -3,10 +3,77 @@
 
 #include "ast.hpp"
 
+#include <type_traits>
+
 
 namespace banjo
 {
 
+// -------------------------------------------------------------------------- //
+// Node kinds
+
+// Returns true if the kinds of T are exactly the kinds of the node
+// classes derived from T.
+template<typename T>
+constexpr bool
+check_node_kinds()
+{
+#define define_node(Node) \
+  if (std::is_base_of<T, Node>::value != Node_kinds<T>::contains(Node##_kind)) \
+    return false;
+#include "ast-name.def"
+#include "ast-type.def"
+#include "ast-expr.def"
+#include "ast-req.def"
+#include "ast-stmt.def"
+#include "ast-decl.def"
+#include "ast-def.def"
+#include "ast-cons.def"
+#undef define_node
+  return true;
+}
+
+
+#define define_node(Node) \
+  static_assert(check_node_kinds<Node>(), "inconsistent kinds for " #Node);
+#include "ast-name.def"
+#include "ast-type.def"
+#include "ast-expr.def"
+#include "ast-req.def"
+#include "ast-stmt.def"
+#include "ast-decl.def"
+#include "ast-def.def"
+#include "ast-cons.def"
+#undef define_node
+
+static_assert(check_node_kinds<Name>(), "inconsistent kinds for Name");
+static_assert(check_node_kinds<Type>(), "inconsistent kinds for Type");
+static_assert(check_node_kinds<Unary_type>(), "inconsistent kinds for Unary_type");
+static_assert(check_node_kinds<Declared_type>(), "inconsistent kinds for Declared_type");
+static_assert(check_node_kinds<Expr>(), "inconsistent kinds for Expr");
+static_assert(check_node_kinds<Id_expr>(), "inconsistent kinds for Id_expr");
+static_assert(check_node_kinds<Decl_expr>(), "inconsistent kinds for Decl_expr");
+static_assert(check_node_kinds<Dot_expr>(), "inconsistent kinds for Dot_expr");
+static_assert(check_node_kinds<Nested_decl_expr>(), "inconsistent kinds for Nested_decl_expr");
+static_assert(check_node_kinds<Binary_expr>(), "inconsistent kinds for Binary_expr");
+static_assert(check_node_kinds<Unary_expr>(), "inconsistent kinds for Unary_expr");
+static_assert(check_node_kinds<Conv>(), "inconsistent kinds for Conv");
+static_assert(check_node_kinds<Standard_conv>(), "inconsistent kinds for Standard_conv");
+static_assert(check_node_kinds<Init>(), "inconsistent kinds for Init");
+static_assert(check_node_kinds<Req>(), "inconsistent kinds for Req");
+static_assert(check_node_kinds<Stmt>(), "inconsistent kinds for Stmt");
+static_assert(check_node_kinds<Decl>(), "inconsistent kinds for Decl");
+static_assert(check_node_kinds<Object_decl>(), "inconsistent kinds for Object_decl");
+static_assert(check_node_kinds<Value_decl>(), "inconsistent kinds for Value_decl");
+static_assert(check_node_kinds<Type_decl>(), "inconsistent kinds for Type_decl");
+static_assert(check_node_kinds<Def>(), "inconsistent kinds for Def");
+static_assert(check_node_kinds<Cons>(), "inconsistent kinds for Cons");
+static_assert(check_node_kinds<Binary_cons>(), "inconsistent kinds for Binary_cons");
+
+
+// -------------------------------------------------------------------------- //
+// Types
+
 
 // Returns true if `t` is an object type. That is, any type
 // except function types and reference types.
@@ -69,6 +69,10 @@ Symbol_table&
 Builder::symbols() { return cxt.symbols(); }
 
 
+Arena&
+Builder::lists() { return cxt.lists(); }
+
+
 // -------------------------------------------------------------------------- //
 // Names
 
@@ -432,6 +436,15 @@ Builder::get_integer(Type& t, Integer const& n)
 }
 
 
+// Returns an integer literal with a value that fits in 64 bits. This
+// does not allocate an arbitrary precision integer.
+Integer_expr&
+Builder::get_integer(Type& t, std::int64_t n)
+{
+  return make<Integer_expr>(t, n);
+}
+
+
 // Returns the 0 constant, with scalar type `t`.
 //
 // TODO: Verify that t is scalar.
@@ -451,6 +464,13 @@ Builder::get_int(Integer const& n)
 }
 
 
+Integer_expr&
+Builder::get_int(std::int64_t n)
+{
+  return get_integer(get_int_type(), n);
+}
+
+
 Integer_expr&
 Builder::get_uint(Integer const& n)
 {
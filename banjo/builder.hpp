@@ -91,8 +91,10 @@ struct Builder
   Boolean_expr&   get_true();
   Boolean_expr&   get_false();
   Integer_expr&   get_integer(Type&, Integer const&);
+  Integer_expr&   get_integer(Type&, std::int64_t);
   Integer_expr&   get_zero(Type&);
   Integer_expr&   get_int(Integer const&);
+  Integer_expr&   get_int(std::int64_t);
   Integer_expr&   get_uint(Integer const&);
   Tuple_expr&     make_tuple(Type&, Expr_list&&);
 
@@ -229,14 +231,17 @@ struct Builder
 
   // Resources
   Symbol_table& symbols();
+  Arena&        lists();
 
-  // Allocate an objet of the given type.
+  // Allocate an objet of the given type. Lists copied into the object
+  // during its construction are allocated in the context's list arena.
   //
   // TODO: This is a placeholder for using a legitimate object
   // pool in the context (or somewhere else).
   template<typename T, typename... Args>
   T& make(Args&&... args)
   {
+    Use_list_arena guard(lists());
     return *new T(std::forward<Args>(args)...);
   }
 
@@ -8,23 +8,50 @@
 #include "evaluation.hpp"
 
 #include "gen/llvm/generator.hpp"
+#include "gen/llvm/jit.hpp"
 
 #include <lingo/file.hpp>
 #include <lingo/io.hpp>
 #include <lingo/error.hpp>
 
+#include <cstring>
 #include <iostream>
+#include <memory>
 
 
 using namespace lingo;
 using namespace banjo;
 
 
+// Reduce the expression to a value. When `native` is true, try to
+// compile and execute the expression natively, falling back to the
+// evaluator if it cannot be compiled.
+Expr&
+calculate(Context& cxt, Expr& expr, bool native)
+{
+  if (native) {
+    Value v;
+    if (cxt.jit()->evaluate(expr, v))
+      return lift_value(cxt, expr.type(), v);
+  }
+  return reduce(cxt, expr);
+}
+
+
 int
 main(int argc, char* argv[])
 {
   Context cxt;
 
+  // With '-jit', every input expression is compiled, and hot functions
+  // are executed natively.
+  bool native = argc > 1 && std::strcmp(argv[1], "-jit") == 0;
+  std::unique_ptr<ll::Jit> jit;
+  if (native) {
+    jit.reset(new ll::Jit(cxt));
+    cxt.jit(jit.get());
+  }
+
   while (true) {
     String str;
     std::getline(std::cin, str);
@@ -47,7 +74,7 @@ main(int argc, char* argv[])
     Expr& expr = parse.expression();
     
     // Print the expression in reduced form.
-    Expr& red = reduce(cxt, expr);
+    Expr& red = calculate(cxt, expr, native);
     std::cout << red << '\n';
   }
 }
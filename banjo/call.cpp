@@ -55,12 +55,39 @@ initialize_parameters(Context& cxt, Type_list& parms, Expr_list& args)
 }
 
 
+// Copy-initialize each parameter with its corresponding argument,
+// storing the converted arguments in `conv`. Returns false if there
+// are too few arguments or an argument cannot be converted.
+bool
+try_initialize_parameters(Context& cxt, Type_list& parms, Expr_list& args, Expr_list& conv)
+{
+  // TODO: Handle default arguments here.
+  if (args.size() < parms.size())
+    return false;
+
+  Type_iter pi = parms.begin(), pn = parms.end();
+  Expr_iter ai = args.begin(), an = args.end();
+  while (pi != pn && ai != an) {
+    Expr* e = try_copy_initialize(cxt, *pi, *ai);
+    if (!e)
+      return false;
+    conv.push_back(*e);
+    ++pi;
+    ++ai;
+  }
+  return true;
+}
+
+
+// Build the candidate for a call to `f`. The candidate is not viable
+// if its parameters cannot be initialized by the arguments.
 Function_candidate
 build_function_candidate(Context& cxt, Function_decl& f, Expr_list& args)
 {
   Type_list& parms = f.type().parameter_types();
-  Expr_list conv = initialize_parameters(cxt, parms, args);
-  return {f, conv, true};
+  Expr_list conv;
+  bool ok = try_initialize_parameters(cxt, parms, args, conv);
+  return {f, conv, ok};
 }
 
 
@@ -73,6 +100,8 @@ build_function_call(Context& cxt, Function_decl& f, Expr_list& args)
 {
   Builder build(cxt);
   Function_candidate c = build_function_candidate(cxt, f, args);
+  if (!c.viable) // Diagnose the failure
+    c.args = initialize_parameters(cxt, f.type().parameter_types(), args);
   return build.make_call(f.return_type(), f, c.arguments());
 }
 
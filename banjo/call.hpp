@@ -41,6 +41,9 @@ struct Function_candidate
 // TODO: Rename this to argument_initialize and move
 // it into the initialization module.
 Expr_list initialize_parameters(Context&, Type_list&, Expr_list&);
+bool      try_initialize_parameters(Context&, Type_list&, Expr_list&, Expr_list&);
+
+Function_candidate build_function_candidate(Context&, Function_decl&, Expr_list&);
 
 Expr& build_function_call(Context&, Function_decl&, Expr_list&);
 
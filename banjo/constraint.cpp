@@ -114,6 +114,7 @@ admit_binary_expr(Context& cxt, Usage& c, Binary_expr& e)
   Type& t1 = declared_type(a.left());
   Type& t2 = declared_type(a.right());
   try {
+    Suppress_diagnostics quiet(cxt);
     copy_initialize(cxt, t1, e.left());
     copy_initialize(cxt, t2, e.right());
   } catch(Translation_error&) {
@@ -152,6 +153,7 @@ admit_call_expr(Context& cxt, Usage& c, Call_expr& e)
 
   // If conversion fails, this is not accessible.
   try {
+    Suppress_diagnostics quiet(cxt);
     initialize_parameters(cxt, ts, es);
   } catch (Translation_error&) {
     return nullptr;
@@ -181,7 +183,7 @@ admit_usage_expr(Context& cxt, Usage& c, Expr& e)
   };
 
   // An expression of a different kind prove admissibility.
-  if (typeid(c.expression()) != typeid(e))
+  if (c.expression().node_kind() != e.node_kind())
     return nullptr;
 
   return apply(e, fn{cxt, c});
@@ -301,6 +303,7 @@ admit_binary_conv(Context& cxt, Conversion_cons& c, Binary_expr& e)
   Type& t1 = declared_type(a.left());
   Type& t2 = declared_type(a.right());
   try {
+    Suppress_diagnostics quiet(cxt);
     copy_initialize(cxt, t1, e.left());
     copy_initialize(cxt, t2, e.right());
   } catch(Translation_error&) {
@@ -341,7 +344,7 @@ admit_usage_conv(Context& cxt, Conversion_cons& c, Expr& e, Type& t)
 
   // An expression of a different kind prove admissibility.
   Expr& e2 = c.expression();
-  if (typeid(e2) != typeid(e))
+  if (e2.node_kind() != e.node_kind())
     return nullptr;
 
   // If the expression's type is not equivalent to t, this constraint
@@ -16,8 +16,10 @@ namespace banjo
 Context::Context()
   : Builder(*this), syms()
   , global(nullptr), scope(nullptr)
+  , engine(nullptr)
+  , reorder(false)
   , id(0)
-  , diags(false)
+  , diags()
 {
   // Initialize the color system. This is a process-level
   // configuration. Perhaps we we should only initialize
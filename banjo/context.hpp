@@ -8,15 +8,27 @@
 #include "builder.hpp"
 #include "scope.hpp"
 #include "value.hpp"
+#include "layout.hpp"
+#include "module.hpp"
+#include "fingerprint.hpp"
+#include "diagnostic.hpp"
+#include "source.hpp"
 
 #include <lingo/environment.hpp>
 
+#include <mutex>
+
 
 namespace banjo
 {
 
 struct Scope;
 
+namespace ll
+{
+struct Jit;
+} // namespace ll
+
 
 // Used to associate scopes with terms: the translation unit, classes,
 // functions, and compound statements.
@@ -50,9 +62,16 @@ struct Context : Builder
   Symbol_table const& symbols() const { return syms; }
   Symbol_table&       symbols()       { return syms; }
 
+  // Guards the symbol table during concurrent lexing.
+  std::mutex& symbol_lock() { return symlock; }
+
   // Unique ids
   int get_unique_id();
 
+  // Input files
+  Source_manager const& sources() const { return srcs; }
+  Source_manager&       sources()       { return srcs; }
+
   // Input location
   Location input_location() const       { return input; }
   void     input_location(Location loc) { input = loc; }
@@ -85,13 +104,46 @@ struct Context : Builder
   Store&       constants()       { return values; }
   void store(Decl&, Value&&);
   void store(Decl&, Value const&);
-  Value const& load(Decl&);
+  Value const& load(Decl const&) const;
 
-  // Diagnostic state
-  bool diagnose_errors() const { return diags; }
+  // Native execution. When a JIT is installed, the evaluator may
+  // compile and run hot functions natively.
+  ll::Jit* jit() const      { return engine; }
+  void     jit(ll::Jit* j)  { engine = j; }
+
+  // Class layouts
+  Layout_map const& layouts() const { return lays; }
+  Layout_map&       layouts()       { return lays; }
+
+  // When true, the fields of classes are reordered to minimize padding.
+  bool reorder_fields() const { return reorder; }
+  void reorder_fields(bool b) { reorder = b; }
+
+  // Loaded modules
+  Module_map const& modules() const { return mods; }
+  Module_map&       modules()       { return mods; }
+
+  // The directory in which imported modules are found. When empty,
+  // modules are found in the working directory.
+  String const& module_directory() const          { return moddir; }
+  void          module_directory(String const& s) { moddir = s; }
 
-  Symbol_table syms;   // The symbol table
-  Location     input;  // The input location
+  // Storage for lists in AST nodes
+  Arena& lists() { return arena; }
+
+  // Fingerprints of top-level declarations
+  Fingerprint_map const& fingerprints() const { return prints; }
+  Fingerprint_map&       fingerprints()       { return prints; }
+
+  // Diagnostic state
+  Diagnostic_engine const& diagnostics() const { return diags; }
+  Diagnostic_engine&       diagnostics()       { return diags; }
+  bool diagnose_errors() const { return !diags.suppressed(); }
+
+  Symbol_table   syms;    // The symbol table
+  std::mutex     symlock; // Guards the symbol table
+  Location       input;   // The input location
+  Source_manager srcs;    // Input files
  
   // Scope and context.
   Scope*        global; // The global scope
@@ -102,11 +154,28 @@ struct Context : Builder
   // Constant value store.
   Store         values;
 
+  // The native execution engine, if any.
+  ll::Jit*      engine;
+
+  // Computed class layouts.
+  Layout_map    lays;
+  bool          reorder; // True if fields are reordered
+
+  // Imported modules.
+  Module_map    mods;
+  String        moddir; // The directory of imported modules
+
+  // Recorded fingerprints of top-level declarations.
+  Fingerprint_map prints;
+
+  // Storage for lists copied into AST nodes.
+  Arena           arena;
+
   // Store information for generating unique names.
   int             id;     // The current id counter
 
   // Diagnostic state
-  bool diags; // True if diagnostics should be emitted.
+  Diagnostic_engine diags;
 };
 
 
@@ -184,7 +253,7 @@ Context::store(Decl& d, Value const& v)
 
 // Load the value associated with the constant.
 inline Value const& 
-Context::load(Decl& d)
+Context::load(Decl const& d) const
 {
   lingo_assert(values.count(&d) == 1);
   auto iter = values.find(&d);
@@ -269,14 +338,14 @@ struct Save_input_location
 struct Change_diagnostics
 {
   Change_diagnostics(Context& cxt, bool b)
-    : cxt(cxt), prev(cxt.diags)
+    : cxt(cxt), prev(!cxt.diags.quiet)
   {
-    cxt.diags = b;
+    cxt.diags.quiet = !b;
   }
 
   ~Change_diagnostics()
   {
-    cxt.diags = prev;
+    cxt.diags.quiet = !prev;
   }
 
   Context& cxt;
@@ -284,7 +353,8 @@ struct Change_diagnostics
 };
 
 
-// Indicate that diagnostics should be suppressed.
+// Indicate that diagnostics should be suppressed. Suppressed diagnostics
+// are dropped without being formatted.
 struct Suppress_diagnostics : Change_diagnostics
 {
   Suppress_diagnostics(Context& cxt)
@@ -302,17 +372,69 @@ struct Emit_diagnostics : Change_diagnostics
 };
 
 
+// Buffers the diagnostics issued during a speculative check. If the
+// check succeeds, its diagnostics can be committed to the enclosing
+// context. Otherwise, they are discarded, without being formatted,
+// when the speculative context is left.
+struct Speculate_diagnostics
+{
+  Speculate_diagnostics(Context& cxt)
+    : cxt(cxt), active(true)
+  {
+    cxt.diags.buffers.push_back(&buf);
+  }
+
+  ~Speculate_diagnostics()
+  {
+    leave();
+  }
+
+  // Returns true if an error was buffered.
+  bool failed() const
+  {
+    for (Lazy_diagnostic const& d : buf)
+      if (d.kind == error_diag)
+        return true;
+    return false;
+  }
+
+  // Report the buffered diagnostics to the enclosing context.
+  void commit()
+  {
+    leave();
+    for (Lazy_diagnostic& d : buf)
+      cxt.diags.report(std::move(d));
+    buf.clear();
+  }
+
+  // Stop buffering diagnostics.
+  void leave()
+  {
+    if (active) {
+      lingo_assert(cxt.diags.buffers.back() == &buf);
+      cxt.diags.buffers.pop_back();
+      active = false;
+    }
+  }
+
+  Context&        cxt;
+  Diagnostic_list buf;
+  bool            active;
+};
+
+
 using lingo::error;
 using lingo::warning;
 using lingo::note;
 
 
-// Emit a formatted message at the current input position.
+// Emit a formatted message at the current input position. The
+// message is formatted only if it is emitted.
 template<typename... Args>
 inline void
 error(Context& cxt, char const* msg, Args const&... args)
 {
-  error(cxt.input_location(), msg, args...);
+  cxt.diags.report(error_diag, cxt.input_location(), msg, args...);
 }
 
 
@@ -321,7 +443,7 @@ template<typename... Args>
 inline void
 warning(Context& cxt, char const* msg, Args const&... args)
 {
-  warning(cxt.input_location(), msg, args...);
+  cxt.diags.report(warning_diag, cxt.input_location(), msg, args...);
 }
 
 
@@ -330,7 +452,7 @@ template<typename... Args>
 inline void
 note(Context& cxt, char const* msg, Args const&... args)
 {
-  note(cxt.input_location(), msg, args...);
+  cxt.diags.report(note_diag, cxt.input_location(), msg, args...);
 }
 
 
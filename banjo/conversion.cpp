@@ -8,7 +8,6 @@
 #include "initialization.hpp"
 #include "printer.hpp"
 
-#include <typeindex>
 #include <iostream>
 
 
@@ -255,7 +254,7 @@ is_similar(Type const& a, Type const& b)
   Type const& ua = a.unqualified_type();
   Type const& ub = b.unqualified_type();
 
-  if (typeid(ua) != typeid(ub))
+  if (ua.node_kind() != ub.node_kind())
     return false;
   else
     return apply(ua, fn{ub});
@@ -389,25 +388,38 @@ convert_qualifier(Expr& e, Type& t)
 // Standard conversions
 
 // Try to find a standard conversion sequence from a source
-// expression `e` and a destination type `t`.
+// expression `e` and a destination type `t`. Returns nullptr if
+// there is no such conversion.
 //
 // FIXME: Should `t` be an object type? That is we should perform
 // conversions iff we can declare an object of type T?
-Expr&
-standard_conversion(Expr& e, Type& t)
+Expr*
+try_standard_conversion(Expr& e, Type& t)
 {
   Expr& c1 = convert_category(e, t);
   if (is_equivalent(c1.type(), t))
-    return c1;
+    return &c1;
 
   Expr& c2 = convert_value(c1, t);
   if (is_equivalent(c2.type(), t))
-    return c2;
+    return &c2;
 
   Expr& c3 = convert_qualifier(c2, t);
   if (is_equivalent(c3.type(), t))
-    return c3;
+    return &c3;
+
+  return nullptr;
+}
 
+
+// Find a standard conversion sequence from a source expression `e`
+// and a destination type `t`. Throws an exception if there is no
+// such conversion.
+Expr&
+standard_conversion(Expr& e, Type& t)
+{
+  if (Expr* c = try_standard_conversion(e, t))
+    return *c;
   throw Type_error("cannot convert '{}' (type '{}') to '{}'", e, e.type(), t);
 }
 
@@ -435,6 +447,13 @@ standard_conversion(Expr const& e, Type const& t)
 }
 
 
+Expr*
+try_standard_conversion(Expr const& e, Type const& t)
+{
+  return try_standard_conversion(modify(e), modify(t));
+}
+
+
 // -------------------------------------------------------------------------- //
 // Arithmetic conversions
 
@@ -686,40 +705,48 @@ contextual_conversion_to_bool(Context& cxt, Expr& e)
 //
 // A dependent conversion is either a standard, conversion conisisting
 // of a object-to-value conversion and a qualification adjustment, or
-// it is a conversion admitted by a constraint.
-Expr&
-dependent_conversion(Context& cxt, Expr& e, Type& t)
+// it is a conversion admitted by a constraint. Returns nullptr if there
+// is no such conversion.
+Expr*
+try_dependent_conversion(Context& cxt, Expr& e, Type& t)
 {
 #if 0
   // In certain contexts, no conversions are applied.
   if (cxt.in_requirements())
-    return e;
+    return &e;
   if (!cxt.current_template_constraints())
-    return e;
+    return &e;
 
   // Determine if we can reach the destination type by a
   // standard set of conversions on the dependent source
   // expression. Discard that conversion and replace it with
   // a dependent conversion.
-  try {
-    // FIXME: If an object-to-value conversion is applied, then
-    // we need to also ensure that the type is copy constructible.
-    // Note that copy constructible would also entail move
-    // constructible.
-    Expr& c = standard_conversion(e, t);
-    (void)c;
-    return *new Dependent_conv(t, e);
-  } catch (Translation_error&) {
-    // Fall through...
-  }
+  //
+  // FIXME: If an object-to-value conversion is applied, then
+  // we need to also ensure that the type is copy constructible.
+  // Note that copy constructible would also entail move
+  // constructible.
+  if (try_standard_conversion(e, t))
+    return new Dependent_conv(t, e);
 
   // Search for a conversion to t among the listed constraints.
   Expr& cons = *cxt.current_template_constraints();
   if (Expr* c = admit_conversion(cxt, cons, e, t)) {
-    return *c;
+    return c;
   }
 #endif
 
+  return nullptr;
+}
+
+
+// Find a dependent conversion of `e` to `t`. Throws an exception if
+// there is no such conversion.
+Expr&
+dependent_conversion(Context& cxt, Expr& e, Type& t)
+{
+  if (Expr* c = try_dependent_conversion(cxt, e, t))
+    return *c;
   throw Type_error(cxt, "no admissible conversion from '{}' to '{}'", e, t);
 }
 
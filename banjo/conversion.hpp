@@ -192,9 +192,11 @@ enum Conversion_comp
 // FIXME: All of these should take a context.
 
 Expr&     standard_conversion(Expr const&, Type const&);
+Expr*     try_standard_conversion(Expr const&, Type const&);
 Expr_pair arithmetic_conversion(Expr const&, Expr const&);
 Expr&     contextual_conversion_to_bool(Context& cxt, Expr&);
 Expr&     dependent_conversion(Context& cxt, Expr&, Type&);
+Expr*     try_dependent_conversion(Context& cxt, Expr&, Type&);
 
 Conversion_seq get_conversion_sequence(Expr const&);
 
@@ -77,41 +77,42 @@ declare_required_expression(Context& cxt, Expr& e)
 //      - d1 and d2 are functions that cannot be overloaded, or
 //      - d1 and d2 are types having different kinds.
 //
-// Note that d1 precedes d2 in lexical order.
+// Note that d1 precedes d2 in lexical order. Returns false if the
+// declarations conflict.
 //
 // TODO: Would it make sense to poison the declaration so that it's not
 // analyzed in subsequent passes? We could essentially replace the existing
 // overload set with one containing a poisoned declaration. Any expression
 // that uses that name would have an invalid type. We could then use this
 // to list the places where the error affects use.
-void
+bool
 check_declarations(Context& cxt, Decl const& d1, Decl const& d2)
 {
   struct fn
   {
     Context& cxt;
     Decl const& d2;
-    void operator()(Decl const& d)           { lingo_unhandled(d); }
-    void operator()(Object_decl const& d1)   { return check_declarations(cxt, d1, cast_as(d1, d2)); }
-    void operator()(Function_decl const& d1) { return check_declarations(cxt, d1, cast_as(d1, d2)); }
-    void operator()(Type_decl const& d1)     { return check_declarations(cxt, d1, cast_as(d1, d2)); }
+    bool operator()(Decl const& d)           { lingo_unhandled(d); }
+    bool operator()(Object_decl const& d1)   { return check_declarations(cxt, d1, cast_as(d1, d2)); }
+    bool operator()(Function_decl const& d1) { return check_declarations(cxt, d1, cast_as(d1, d2)); }
+    bool operator()(Type_decl const& d1)     { return check_declarations(cxt, d1, cast_as(d1, d2)); }
   };
-  if (typeid(d1) != typeid(d2)) {
+  if (d1.node_kind() != d2.node_kind()) {
     // TODO: Get the source location right.
     error(cxt, "declaration changes the meaning of '{}'", d1.name());
-    note("'{}' previously declared as:", d1.name());
+    note(cxt, "'{}' previously declared as:", d1.name());
     
     // TODO: Don't print the definition. It's not germaine to
     // the error. If we have source locations, I wonder if we
     // can just point at the line.
-    note("{}", d1);
-    throw Declaration_error();
+    note(cxt, "{}", d1);
+    return false;
   }
-  apply(d1, fn{cxt, d2});
+  return apply(d1, fn{cxt, d2});
 }
 
 
-void
+bool
 check_declarations(Context& cxt, Object_decl const& d1, Object_decl const& d2)
 {
   struct fn
@@ -123,18 +124,19 @@ check_declarations(Context& cxt, Object_decl const& d1, Object_decl const& d2)
   };
 
   error(cxt, "redeclaration of {} with the same name", apply(d1, fn{}));
-  throw Declaration_error();
+  return false;
 }
 
 
-void
+bool
 check_declarations(Context& cxt, Function_decl const& d1, Function_decl const& d2)
 {
   // FIXME: Actually check overloading rules.
+  return true;
 }
 
 
-void
+bool
 check_declarations(Context& cxt, Type_decl const& d1, Type_decl const& d2)
 {
   Type const& t1 = d1.type();
@@ -142,14 +144,15 @@ check_declarations(Context& cxt, Type_decl const& d1, Type_decl const& d2)
   if (is_different(t1, t2)) {
     // TODO: Get the source location right.
     error(cxt, "declaration of '{}' as a different kind of type", d1.name());
-    note("'{}' previously declared as:", d1.name());
+    note(cxt, "'{}' previously declared as:", d1.name());
     
     // TODO: Don't print the definition. It's not germaine to
     // the error. If we have source locations, I wonder if we
     // can just point at the line.
-    note("{}", d1);
-    throw Declaration_error();
+    note(cxt, "{}", d1);
+    return false;
   }
+  return true;
 }
 
 
@@ -22,11 +22,12 @@ void declare(Context&, Scope&, Decl&);
 void declare_required_expression(Context&, Expr&);
 
 
-// Declaration checking.
-void check_declarations(Context& cxt, Decl const&, Decl const&);
-void check_declarations(Context& cxt, Object_decl const&, Object_decl const&);
-void check_declarations(Context& cxt, Function_decl const&, Function_decl const&);
-void check_declarations(Context& cxt, Type_decl const&, Type_decl const&);
+// Declaration checking. These diagnose conflicting declarations and
+// return false; they do not throw.
+bool check_declarations(Context& cxt, Decl const&, Decl const&);
+bool check_declarations(Context& cxt, Object_decl const&, Object_decl const&);
+bool check_declarations(Context& cxt, Function_decl const&, Function_decl const&);
+bool check_declarations(Context& cxt, Type_decl const&, Type_decl const&);
 
 
 } // namespace banjo
@@ -0,0 +1,34 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "diagnostic.hpp"
+
+
+namespace banjo
+{
+
+void
+emit_diagnostic(Diagnostic_kind k, Location loc, String const& msg)
+{
+  switch (k) {
+    case error_diag:
+      error(loc, "{}", msg);
+      break;
+    case warning_diag:
+      warning(loc, "{}", msg);
+      break;
+    default:
+      note(loc, "{}", msg);
+      break;
+  }
+}
+
+
+void
+emit_diagnostic(Lazy_diagnostic const& d)
+{
+  emit_diagnostic(d.kind, d.loc, d.message());
+}
+
+
+} // namespace banjo
@@ -0,0 +1,190 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_DIAGNOSTIC_HPP
+#define BANJO_DIAGNOSTIC_HPP
+
+// Lazily formatted diagnostics. Formatting a diagnostic often prints
+// whole declarations or types, and many diagnostics are issued during
+// speculative checks whose errors are discarded. A lazy diagnostic
+// captures its arguments and formats its message only when the message
+// is actually needed.
+
+#include <lingo/error.hpp>
+#include <lingo/location.hpp>
+#include <lingo/string.hpp>
+
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace banjo
+{
+
+using namespace lingo;
+
+
+struct Term;
+
+
+// Determines how an argument of a lazy diagnostic is captured. Terms
+// outlive any diagnostic and are captured by reference. All other
+// arguments are copied.
+template<typename T, bool = std::is_base_of<Term, T>::value>
+struct Diagnostic_arg
+{
+  using type = T;
+};
+
+
+template<typename T>
+struct Diagnostic_arg<T, true>
+{
+  using type = std::reference_wrapper<T const>;
+};
+
+
+// Character strings are copied, since a pointer may refer to a
+// temporary string that does not outlive the diagnostic.
+template<>
+struct Diagnostic_arg<char const*, false>
+{
+  using type = String;
+};
+
+
+template<>
+struct Diagnostic_arg<char*, false>
+{
+  using type = String;
+};
+
+
+// Note that string literals decay to pointers to const characters.
+template<typename T>
+using Diagnostic_arg_t = typename Diagnostic_arg<std::decay_t<T const>>::type;
+
+
+template<typename T>
+inline T const&
+diagnostic_arg(T const& x)
+{
+  return x;
+}
+
+
+template<typename T>
+inline T const&
+diagnostic_arg(std::reference_wrapper<T const> x)
+{
+  return x.get();
+}
+
+
+template<typename Tuple, std::size_t... I>
+inline String
+format_diagnostic(char const* msg, Tuple const& args, std::index_sequence<I...>)
+{
+  return format(msg, diagnostic_arg(std::get<I>(args))...);
+}
+
+
+// A diagnostic whose message is formatted on demand. The message
+// string is expected to be a literal.
+struct Lazy_diagnostic
+{
+  Lazy_diagnostic(Diagnostic_kind, Location, String const&);
+
+  template<typename... Args>
+  Lazy_diagnostic(Diagnostic_kind, Location, char const*, Args const&...);
+
+  String     message() const { return text(); }
+  Diagnostic diagnostic() const { return Diagnostic(kind, loc, text()); }
+
+  Diagnostic_kind         kind;
+  Location                loc;
+  std::function<String()> text;
+};
+
+
+// Initialize the diagnostic with an already formatted message.
+inline
+Lazy_diagnostic::Lazy_diagnostic(Diagnostic_kind k, Location l, String const& s)
+  : kind(k), loc(l), text([s]() { return s; })
+{ }
+
+
+template<typename... Args>
+inline
+Lazy_diagnostic::Lazy_diagnostic(Diagnostic_kind k, Location l, char const* msg, Args const&... args)
+  : kind(k), loc(l)
+{
+  using Tuple = std::tuple<Diagnostic_arg_t<Args>...>;
+  text = [msg, t = Tuple(args...)]() {
+    return format_diagnostic(msg, t, std::index_sequence_for<Args...>());
+  };
+}
+
+
+// A sequence of buffered diagnostics.
+using Diagnostic_list = std::vector<Lazy_diagnostic>;
+
+
+// Emit the diagnostic, formatting its message.
+void emit_diagnostic(Diagnostic_kind, Location, String const&);
+void emit_diagnostic(Lazy_diagnostic const&);
+
+
+// The diagnostic engine determines what happens to diagnostics issued
+// through a context. Normally, diagnostics are formatted and emitted
+// immediately. Within a speculative context (see Speculate_diagnostics),
+// they are captured in the innermost buffer, to be committed or discarded
+// when the context is left. When diagnostics are suppressed, they are
+// dropped before their arguments are even captured.
+struct Diagnostic_engine
+{
+  bool suppressed() const { return quiet; }
+  bool buffering() const  { return !buffers.empty(); }
+
+  template<typename... Args>
+  void report(Diagnostic_kind, Location, char const*, Args const&...);
+  void report(Lazy_diagnostic&&);
+
+  bool                          quiet = false; // True if suppressed
+  std::vector<Diagnostic_list*> buffers;       // Speculative buffers
+};
+
+
+template<typename... Args>
+inline void
+Diagnostic_engine::report(Diagnostic_kind k, Location loc, char const* msg, Args const&... args)
+{
+  if (quiet)
+    return;
+  if (buffering())
+    buffers.back()->emplace_back(k, loc, msg, args...);
+  else
+    emit_diagnostic(k, loc, format(msg, args...));
+}
+
+
+// Buffer or emit the diagnostic.
+inline void
+Diagnostic_engine::report(Lazy_diagnostic&& d)
+{
+  if (quiet)
+    return;
+  if (buffering())
+    buffers.back()->push_back(std::move(d));
+  else
+    emit_diagnostic(d);
+}
+
+
+} // namespace banjo
+
+
+#endif
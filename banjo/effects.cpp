@@ -0,0 +1,448 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "effects.hpp"
+#include "ast.hpp"
+
+
+namespace banjo
+{
+
+namespace
+{
+
+// Returns every effect.
+inline Effects
+all_effects()
+{
+  Effects fx;
+  fx.reads = fx.writes = fx.unwinds = fx.diverges = true;
+  return fx;
+}
+
+
+// Add the effects of b to a.
+inline void
+merge(Effects& a, Effects const& b)
+{
+  a.reads |= b.reads;
+  a.writes |= b.writes;
+  a.unwinds |= b.unwinds;
+  a.diverges |= b.diverges;
+}
+
+
+// By default, parameters declared with a passing mode might be passed
+// by address.
+bool
+has_passing_mode(Function_decl const&, Decl const& p)
+{
+  return p.specifiers() & (in_spec | out_spec | consume_spec | forward_spec);
+}
+
+
+// Accumulates the effects of a function definition. Objects declared
+// by the definition are local unless they are references or parameters
+// passed by address.
+struct Effect_walker
+{
+  using Self = Effect_walker;
+
+  void parameter(Function_decl const&, Decl const&);
+  void variable(Variable_decl const&);
+  void definition(Def const&);
+  void statement(Stmt const&);
+  void statement_seq(Stmt_list const&);
+  void expression(Expr const&);
+  void expression_seq(Expr_list const&);
+  void assignment(Assign_expr const&);
+  void object(Decl const&);
+  void call(Call_expr const&);
+  void unknown() { fx = all_effects(); }
+
+  Effect_analysis&                analysis;
+  Effects&                        fx;
+  std::unordered_set<Decl const*> locals;
+};
+
+
+void
+Effect_walker::parameter(Function_decl const& f, Decl const& p)
+{
+  if (!is_reference_type(p.type()) && !analysis.indirect(f, p))
+    locals.insert(&p);
+}
+
+
+void
+Effect_walker::variable(Variable_decl const& d)
+{
+  if (!is_reference_type(d.type()))
+    locals.insert(&d);
+  definition(d.initializer());
+}
+
+
+void
+Effect_walker::definition(Def const& d)
+{
+  struct fn
+  {
+    Self& w;
+    void operator()(Def const& d)            { w.unknown(); }
+    void operator()(Empty_def const& d)      { /* Do nothing. */ }
+    void operator()(Expression_def const& d) { w.expression(d.expression()); }
+    void operator()(Function_def const& d)   { w.statement(d.statement()); }
+  };
+  apply(d, fn{*this});
+}
+
+
+void
+Effect_walker::statement(Stmt const& s)
+{
+  struct fn
+  {
+    Self& w;
+    void operator()(Stmt const& s)            { w.unknown(); }
+    void operator()(Empty_stmt const& s)      { /* Do nothing. */ }
+    void operator()(Break_stmt const& s)      { /* Do nothing. */ }
+    void operator()(Continue_stmt const& s)   { /* Do nothing. */ }
+    void operator()(Compound_stmt const& s)   { w.statement_seq(s.statements()); }
+    void operator()(Return_stmt const& s)     { w.expression(s.expression()); }
+    void operator()(Expression_stmt const& s) { w.expression(s.expression()); }
+
+    void operator()(Declaration_stmt const& s)
+    {
+      if (Variable_decl const* v = as<Variable_decl>(&s.declaration()))
+        w.variable(*v);
+    }
+
+    void operator()(If_then_stmt const& s)
+    {
+      w.expression(s.condition());
+      w.statement(s.true_branch());
+    }
+
+    void operator()(If_else_stmt const& s)
+    {
+      w.expression(s.condition());
+      w.statement(s.true_branch());
+      w.statement(s.false_branch());
+    }
+
+    // We do not try to prove that loops terminate.
+    void operator()(While_stmt const& s)
+    {
+      w.fx.diverges = true;
+      w.expression(s.condition());
+      w.statement(s.body());
+    }
+  };
+  apply(s, fn{*this});
+}
+
+
+void
+Effect_walker::statement_seq(Stmt_list const& ss)
+{
+  for (Stmt const& s : ss)
+    statement(s);
+}
+
+
+void
+Effect_walker::expression(Expr const& e)
+{
+  struct fn
+  {
+    Self& w;
+    void operator()(Expr const& e)           { w.unknown(); }
+    void operator()(Boolean_expr const& e)   { /* Do nothing. */ }
+    void operator()(Integer_expr const& e)   { /* Do nothing. */ }
+    void operator()(Real_expr const& e)      { /* Do nothing. */ }
+    void operator()(Value_expr const& e)     { /* Do nothing. */ }
+    void operator()(Function_expr const& e)  { /* Do nothing. */ }
+    void operator()(Object_expr const& e)    { w.object(e.declaration()); }
+    void operator()(Field_expr const& e)     { w.expression(e.object()); }
+    void operator()(Tuple_expr const& e)     { w.expression_seq(e.elements()); }
+    void operator()(Unary_expr const& e)     { w.expression(e.operand()); }
+    void operator()(Assign_expr const& e)    { w.assignment(e); }
+    void operator()(Call_expr const& e)      { w.call(e); }
+    void operator()(Conv const& e)           { w.expression(e.source()); }
+    void operator()(Trivial_init const& e)   { /* Do nothing. */ }
+    void operator()(Copy_init const& e)      { w.expression(e.expression()); }
+    void operator()(Bind_init const& e)      { w.expression(e.expression()); }
+    void operator()(Aggregate_init const& e) { w.expression_seq(e.initializers()); }
+
+    void operator()(Binary_expr const& e)
+    {
+      w.expression(e.left());
+      w.expression(e.right());
+    }
+  };
+  apply(e, fn{*this});
+}
+
+
+void
+Effect_walker::expression_seq(Expr_list const& es)
+{
+  for (Expr const& e : es)
+    expression(e);
+}
+
+
+// An assignment writes the object at the root of its left operand.
+void
+Effect_walker::assignment(Assign_expr const& e)
+{
+  Expr const* obj = &e.left();
+  while (Field_expr const* f = as<Field_expr>(obj))
+    obj = &f->object();
+  if (Object_expr const* o = as<Object_expr>(obj)) {
+    if (!locals.count(&o->declaration()))
+      fx.writes = true;
+  } else {
+    fx.writes = true;
+    expression(e.left());
+  }
+  expression(e.right());
+}
+
+
+// Any use of a non-local object is assumed to read it.
+void
+Effect_walker::object(Decl const& d)
+{
+  if (!locals.count(&d))
+    fx.reads = true;
+}
+
+
+// A call has the effects of the called function.
+void
+Effect_walker::call(Call_expr const& e)
+{
+  Function_expr const* f = as<Function_expr>(&e.function());
+  if (!f)
+    return unknown();
+  merge(fx, analysis.get(f->declaration()));
+  expression_seq(e.arguments());
+}
+
+
+// Finds the parameters that a function definition might modify. A use
+// of an object only reads it when the use is the operand of a value
+// conversion, possibly through a sequence of member accesses. Any other
+// use (e.g., as the left operand of an assignment, or bound to a
+// reference) might modify the object.
+struct Modification_walker
+{
+  using Self = Modification_walker;
+
+  void definition(Def const&);
+  void statement(Stmt const&);
+  void statement_seq(Stmt_list const&);
+  void expression(Expr const&);
+  void expression_seq(Expr_list const&);
+  void value(Value_conv const&);
+  void unknown();
+
+  Function_decl const&             fn;
+  std::unordered_set<Decl const*>& mods;
+};
+
+
+void
+Modification_walker::definition(Def const& d)
+{
+  struct fn
+  {
+    Self& w;
+    void operator()(Def const& d)            { w.unknown(); }
+    void operator()(Empty_def const& d)      { /* Do nothing. */ }
+    void operator()(Expression_def const& d) { w.expression(d.expression()); }
+    void operator()(Function_def const& d)   { w.statement(d.statement()); }
+  };
+  apply(d, fn{*this});
+}
+
+
+void
+Modification_walker::statement(Stmt const& s)
+{
+  struct fn
+  {
+    Self& w;
+    void operator()(Stmt const& s)            { w.unknown(); }
+    void operator()(Empty_stmt const& s)      { /* Do nothing. */ }
+    void operator()(Break_stmt const& s)      { /* Do nothing. */ }
+    void operator()(Continue_stmt const& s)   { /* Do nothing. */ }
+    void operator()(Compound_stmt const& s)   { w.statement_seq(s.statements()); }
+    void operator()(Return_stmt const& s)     { w.expression(s.expression()); }
+    void operator()(Expression_stmt const& s) { w.expression(s.expression()); }
+
+    void operator()(Declaration_stmt const& s)
+    {
+      if (Variable_decl const* v = as<Variable_decl>(&s.declaration()))
+        w.definition(v->initializer());
+    }
+
+    void operator()(If_then_stmt const& s)
+    {
+      w.expression(s.condition());
+      w.statement(s.true_branch());
+    }
+
+    void operator()(If_else_stmt const& s)
+    {
+      w.expression(s.condition());
+      w.statement(s.true_branch());
+      w.statement(s.false_branch());
+    }
+
+    void operator()(While_stmt const& s)
+    {
+      w.expression(s.condition());
+      w.statement(s.body());
+    }
+  };
+  apply(s, fn{*this});
+}
+
+
+void
+Modification_walker::statement_seq(Stmt_list const& ss)
+{
+  for (Stmt const& s : ss)
+    statement(s);
+}
+
+
+void
+Modification_walker::expression(Expr const& e)
+{
+  struct fn
+  {
+    Self& w;
+    void operator()(Expr const& e)           { w.unknown(); }
+    void operator()(Boolean_expr const& e)   { /* Do nothing. */ }
+    void operator()(Integer_expr const& e)   { /* Do nothing. */ }
+    void operator()(Real_expr const& e)      { /* Do nothing. */ }
+    void operator()(Value_expr const& e)     { /* Do nothing. */ }
+    void operator()(Function_expr const& e)  { /* Do nothing. */ }
+    void operator()(Object_expr const& e)    { w.mods.insert(&e.declaration()); }
+    void operator()(Field_expr const& e)     { w.expression(e.object()); }
+    void operator()(Tuple_expr const& e)     { w.expression_seq(e.elements()); }
+    void operator()(Unary_expr const& e)     { w.expression(e.operand()); }
+    void operator()(Value_conv const& e)     { w.value(e); }
+    void operator()(Conv const& e)           { w.expression(e.source()); }
+    void operator()(Trivial_init const& e)   { /* Do nothing. */ }
+    void operator()(Copy_init const& e)      { w.expression(e.expression()); }
+    void operator()(Bind_init const& e)      { w.expression(e.expression()); }
+    void operator()(Aggregate_init const& e) { w.expression_seq(e.initializers()); }
+
+    void operator()(Binary_expr const& e)
+    {
+      w.expression(e.left());
+      w.expression(e.right());
+    }
+
+    void operator()(Call_expr const& e)
+    {
+      w.expression(e.function());
+      w.expression_seq(e.arguments());
+    }
+  };
+  apply(e, fn{*this});
+}
+
+
+void
+Modification_walker::expression_seq(Expr_list const& es)
+{
+  for (Expr const& e : es)
+    expression(e);
+}
+
+
+// Converting an object to a value only reads that object.
+void
+Modification_walker::value(Value_conv const& e)
+{
+  Expr const* obj = &e.source();
+  while (Field_expr const* f = as<Field_expr>(obj))
+    obj = &f->object();
+  if (!is<Object_expr>(obj))
+    expression(e.source());
+}
+
+
+// Any parameter might be modified by an unknown construct.
+void
+Modification_walker::unknown()
+{
+  for (Decl const& p : fn.parameters())
+    mods.insert(&p);
+}
+
+
+} // namespace
+
+
+Effect_analysis::Effect_analysis()
+  : indirect(has_passing_mode)
+{ }
+
+
+Effect_analysis::Effect_analysis(Indirect_fn f)
+  : indirect(f)
+{ }
+
+
+Effects const&
+Effect_analysis::get(Function_decl const& f)
+{
+  auto iter = cache.find(&f);
+  if (iter != cache.end())
+    return iter->second;
+
+  // A recursive call has unknown effects.
+  static Effects const worst = all_effects();
+  if (active.count(&f))
+    return worst;
+
+  Effects fx;
+  if (is<Method_decl>(f)) {
+    fx = all_effects();
+  } else {
+    active.insert(&f);
+    Effect_walker w {*this, fx, {}};
+    for (Decl const& p : f.parameters())
+      w.parameter(f, p);
+    if (is<Empty_def>(f.definition()))
+      w.unknown();
+    else
+      w.definition(f.definition());
+    active.erase(&f);
+  }
+  return cache[&f] = fx;
+}
+
+
+// Returns true if the function f might modify its parameter p.
+bool
+Effect_analysis::modifies(Function_decl const& f, Decl const& p)
+{
+  auto iter = modified.find(&f);
+  if (iter == modified.end()) {
+    iter = modified.emplace(&f, std::unordered_set<Decl const*>()).first;
+    Modification_walker w {f, iter->second};
+    w.definition(f.definition());
+  }
+  return iter->second.count(&p);
+}
+
+
+} // namespace banjo
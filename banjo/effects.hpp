@@ -0,0 +1,71 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_EFFECTS_HPP
+#define BANJO_EFFECTS_HPP
+
+// The effects of calling a function. Effects are inferred from the
+// elaborated definition of the function and the effects of the functions
+// it calls. They are used by code generators to describe functions to
+// the optimizer.
+
+#include "prelude.hpp"
+#include "language.hpp"
+
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+
+
+namespace banjo
+{
+
+// The effects of a call. Memory is non-local when it outlives the call:
+// global variables, objects referred to by references, and parameters
+// passed by address. Each flag is set when the effect is possible.
+struct Effects
+{
+  bool reads    = false; // Reads non-local memory
+  bool writes   = false; // Writes non-local memory
+  bool unwinds  = false; // Exits other than by returning
+  bool diverges = false; // Might not return (loops or recursion)
+};
+
+
+// Infers and caches the effects of functions. A function with no
+// definition, or a definition that cannot be analyzed, has every
+// effect.
+//
+// A function is assumed to have every effect while its definition is
+// being analyzed, so effects are never inferred for recursive functions.
+//
+// The analysis also determines which parameters a function might modify.
+// A parameter is unmodified only when every use of it reads its value.
+// That analysis does not depend on how parameters are passed.
+struct Effect_analysis
+{
+  // Returns true if the parameter of the function is passed by address.
+  using Indirect_fn = std::function<bool(Function_decl const&, Decl const&)>;
+
+  Effect_analysis();
+  explicit Effect_analysis(Indirect_fn);
+
+  Effects const& operator()(Function_decl const& f) { return get(f); }
+
+  Effects const& get(Function_decl const&);
+  bool           modifies(Function_decl const&, Decl const&);
+
+  Indirect_fn indirect;
+
+  std::unordered_map<Function_decl const*, Effects> cache;
+  std::unordered_set<Function_decl const*>          active;
+
+  // The parameters that each function might modify.
+  std::unordered_map<Function_decl const*, std::unordered_set<Decl const*>> modified;
+};
+
+
+} // namespace banjo
+
+
+#endif
@@ -7,6 +7,7 @@
 #include "printer.hpp"
 #include "ast.hpp"
 #include "declaration.hpp"
+#include "layout.hpp"
 
 #include <iostream>
 
@@ -178,12 +179,18 @@ Elaborate_classes::class_declaration(Class_decl& decl)
   for (Stmt& s : def.statements())
     partition_members(def, s);
 
-  // TODO: By the time this function completes, all compile-time properties
-  // of the class must be known (e.g., size, layout, alignment, etc).
-
   // Recursively analyze members.
   Enter_scope scope(cxt, decl);
   statement_seq(def.statements());
+
+  // By the time this function completes, all compile-time properties
+  // of the class must be known. Compute the layout and record the
+  // storage index of each field.
+  Class_layout const& layout = get_layout(cxt, decl);
+  for (Decl& d : def.objects()) {
+    Field_decl& f = cast<Field_decl>(d);
+    f.index_ = layout.member(f).index;
+  }
 }
 
 
@@ -0,0 +1,400 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "elab-constants.hpp"
+#include "parser.hpp"
+#include "ast.hpp"
+#include "evaluation.hpp"
+
+#include <vector>
+
+
+namespace banjo
+{
+
+Elaborate_constants::Elaborate_constants(Parser& p)
+  : parser(p), cxt(p.cxt), eval(nullptr)
+{ }
+
+
+// -------------------------------------------------------------------------- //
+// Statements
+
+// All constant expressions in the translation unit are evaluated by
+// the same evaluator. This saves copying the constant store for each
+// evaluation.
+void
+Elaborate_constants::translation_unit(Translation_unit& tu)
+{
+  Evaluator e(cxt);
+  eval = &e;
+  statement_seq(tu.statements());
+  eval = nullptr;
+}
+
+
+void
+Elaborate_constants::statement(Stmt& s)
+{
+  struct fn
+  {
+    Self& elab;
+    void operator()(Stmt& s)             { /* Do nothing. */ }
+    void operator()(Compound_stmt& s)    { elab.statement_seq(s.statements()); }
+    void operator()(Return_stmt& s)      { elab.return_statement(s); }
+    void operator()(Yield_stmt& s)       { elab.yield_statement(s); }
+    void operator()(If_then_stmt& s)     { elab.if_statement(s); }
+    void operator()(If_else_stmt& s)     { elab.if_statement(s); }
+    void operator()(While_stmt& s)       { elab.while_statement(s); }
+    void operator()(Declaration_stmt& s) { elab.declaration_statement(s); }
+    void operator()(Expression_stmt& s)  { elab.expression_statement(s); }
+  };
+  apply(s, fn{*this});
+}
+
+
+void
+Elaborate_constants::statement_seq(Stmt_list& ss)
+{
+  for (Stmt& s : ss)
+    statement(s);
+}
+
+
+void
+Elaborate_constants::return_statement(Return_stmt& s)
+{
+  s.expr_ = &expression(s.expression());
+}
+
+
+void
+Elaborate_constants::yield_statement(Yield_stmt& s)
+{
+  s.expr_ = &expression(s.expression());
+}
+
+
+void
+Elaborate_constants::if_statement(If_then_stmt& s)
+{
+  s.cond_ = &expression(s.condition());
+  statement(s.true_branch());
+}
+
+
+void
+Elaborate_constants::if_statement(If_else_stmt& s)
+{
+  s.cond_ = &expression(s.condition());
+  statement(s.true_branch());
+  statement(s.false_branch());
+}
+
+
+void
+Elaborate_constants::while_statement(While_stmt& s)
+{
+  s.cond_ = &expression(s.condition());
+  statement(s.body());
+}
+
+
+void
+Elaborate_constants::declaration_statement(Declaration_stmt& s)
+{
+  declaration(s.declaration());
+}
+
+
+void
+Elaborate_constants::expression_statement(Expression_stmt& s)
+{
+  s.expr_ = &expression(s.expression());
+}
+
+
+// -------------------------------------------------------------------------- //
+// Declarations
+
+void
+Elaborate_constants::declaration(Decl& d)
+{
+  struct fn
+  {
+    Self& elab;
+    void operator()(Decl& d)          { /* Do nothing. */ }
+    void operator()(Variable_decl& d) { elab.variable_declaration(d); }
+    void operator()(Constant_decl& d) { elab.constant_declaration(d); }
+    void operator()(Function_decl& d) { elab.function_declaration(d); }
+    void operator()(Class_decl& d)    { elab.class_declaration(d); }
+  };
+  apply(d, fn{*this});
+}
+
+
+void
+Elaborate_constants::variable_declaration(Variable_decl& d)
+{
+  if (Expression_def* def = as<Expression_def>(&d.initializer()))
+    def->expr_ = &expression(def->expression());
+}
+
+
+// The value of the constant was stored when its initializer was
+// elaborated. Replace the initializer with that value.
+void
+Elaborate_constants::constant_declaration(Constant_decl& d)
+{
+  if (Expression_def* def = as<Expression_def>(&d.initializer()))
+    def->expr_ = &expression(def->expression());
+}
+
+
+void
+Elaborate_constants::function_declaration(Function_decl& d)
+{
+  if (Expression_def* def = as<Expression_def>(&d.definition()))
+    def->expr_ = &expression(def->expression());
+  else if (Function_def* def = as<Function_def>(&d.definition()))
+    statement(def->statement());
+}
+
+
+void
+Elaborate_constants::class_declaration(Class_decl& d)
+{
+  if (Class_def* def = as<Class_def>(&d.definition()))
+    statement_seq(def->statements());
+}
+
+
+// -------------------------------------------------------------------------- //
+// Expressions
+
+namespace
+{
+
+// Returns true if e is an operator that can be evaluated.
+bool
+is_evaluable_operator(Expr const& e)
+{
+  switch (e.node_kind()) {
+    case Add_expr_kind:
+    case Sub_expr_kind:
+    case Mul_expr_kind:
+    case Div_expr_kind:
+    case Rem_expr_kind:
+    case Eq_expr_kind:
+    case Ne_expr_kind:
+    case Lt_expr_kind:
+    case Gt_expr_kind:
+    case Le_expr_kind:
+    case Ge_expr_kind:
+    case Cmp_expr_kind:
+    case And_expr_kind:
+    case Or_expr_kind:
+    case Neg_expr_kind:
+    case Pos_expr_kind:
+    case Not_expr_kind:
+      return true;
+    default:
+      return false;
+  }
+}
+
+
+// Returns true if values of type t can be folded into literals.
+inline bool
+is_foldable_type(Type const& t)
+{
+  return is_integer_type(t) || is_boolean_type(t);
+}
+
+
+// Returns true if d is a parameter of f.
+bool
+is_parameter(Function_decl const& f, Decl const& d)
+{
+  for (Decl const& p : f.parameters()) {
+    if (&p == &d)
+      return true;
+  }
+  return false;
+}
+
+} // namespace
+
+
+// Returns the folded form of e.
+Expr&
+Elaborate_constants::expression(Expr& e)
+{
+  if (is_constant(e))
+    return literal(e);
+  return e;
+}
+
+
+// Returns the literal denoting the value of the constant expression e.
+// If e cannot be evaluated, it is returned unchanged.
+Expr&
+Elaborate_constants::literal(Expr& e)
+{
+  if (is<Boolean_expr>(e) || is<Integer_expr>(e))
+    return e;
+  try {
+    Value v = eval->evaluate(e);
+    if (v.is_integer())
+      return lift_value(cxt, e.type(), v);
+  } catch (Compiler_error&) {
+    // Leave the expression to be evaluated at runtime.
+  }
+  return e;
+}
+
+
+// Returns true if e is a constant expression. If e is not constant,
+// its maximal constant subexpressions are replaced by literals.
+bool
+Elaborate_constants::is_constant(Expr& e)
+{
+  struct fn
+  {
+    Self& elab;
+    bool operator()(Expr& e)         { return false; }
+    bool operator()(Boolean_expr& e) { return true; }
+    bool operator()(Integer_expr& e) { return true; }
+    bool operator()(Value_expr& e)   { return true; }
+    bool operator()(Unary_expr& e)   { return elab.is_constant_unary(e); }
+    bool operator()(Binary_expr& e)  { return elab.is_constant_binary(e); }
+    bool operator()(Call_expr& e)    { return elab.is_constant_call(e); }
+  };
+  return apply(e, fn{*this}) && is_foldable_type(e.type());
+}
+
+
+bool
+Elaborate_constants::is_constant_unary(Unary_expr& e)
+{
+  if (!is_evaluable_operator(e)) {
+    e.first = &expression(*e.first);
+    return false;
+  }
+  return is_constant(*e.first);
+}
+
+
+bool
+Elaborate_constants::is_constant_binary(Binary_expr& e)
+{
+  bool c1 = is_constant(*e.first);
+  bool c2 = is_constant(*e.second);
+  if (c1 && c2 && is_evaluable_operator(e))
+    return true;
+  if (c1)
+    e.first = &literal(*e.first);
+  if (c2)
+    e.second = &literal(*e.second);
+  return false;
+}
+
+
+// A call is constant when it calls a foldable function with constant
+// arguments.
+bool
+Elaborate_constants::is_constant_call(Call_expr& e)
+{
+  Expr_list& args = e.arguments();
+  std::vector<bool> cs(args.size());
+  bool all = true;
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    cs[i] = is_constant(*args[i]);
+    all &= cs[i];
+  }
+
+  Function_expr* f = as<Function_expr>(&e.function());
+  if (all && f && is_foldable_type(e.type()) && is_foldable(f->declaration()))
+    return true;
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    if (cs[i])
+      args[i] = &literal(*args[i]);
+  }
+  return false;
+}
+
+
+// Returns true if f is defined by an expression that can be evaluated
+// when its arguments are constant.
+//
+// Note that a function is assumed not to be foldable while its own
+// definition is being checked. Recursive functions are never folded,
+// which guarantees that evaluation terminates.
+bool
+Elaborate_constants::is_foldable(Function_decl const& f)
+{
+  auto iter = funcs.find(&f);
+  if (iter != funcs.end())
+    return iter->second;
+  funcs.emplace(&f, false);
+
+  bool ok = false;
+  if (!is<Method_decl>(f)) {
+    if (Expression_def const* def = as<Expression_def>(&f.definition()))
+      ok = is_pure(f, def->expression());
+  }
+  funcs[&f] = ok;
+  return ok;
+}
+
+
+// Returns true if e, in the definition of f, depends only on constants
+// and the parameters of f.
+bool
+Elaborate_constants::is_pure(Function_decl const& f, Expr const& e)
+{
+  struct fn
+  {
+    Self&                elab;
+    Function_decl const& f;
+
+    bool operator()(Expr const& e)         { return false; }
+    bool operator()(Boolean_expr const& e) { return true; }
+    bool operator()(Integer_expr const& e) { return true; }
+    bool operator()(Value_expr const& e)   { return true; }
+
+    bool operator()(Value_conv const& e)
+    {
+      Object_expr const* obj = as<Object_expr>(&e.source());
+      return obj && is_parameter(f, obj->declaration());
+    }
+
+    bool operator()(Unary_expr const& e)
+    {
+      return is_evaluable_operator(e) && elab.is_pure(f, e.operand());
+    }
+
+    bool operator()(Binary_expr const& e)
+    {
+      return is_evaluable_operator(e)
+          && elab.is_pure(f, e.left())
+          && elab.is_pure(f, e.right());
+    }
+
+    bool operator()(Call_expr const& e)
+    {
+      Function_expr const* g = as<Function_expr>(&e.function());
+      if (!g || !elab.is_foldable(g->declaration()))
+        return false;
+      for (Expr const& a : e.arguments()) {
+        if (!elab.is_pure(f, a))
+          return false;
+      }
+      return true;
+    }
+  };
+  return apply(e, fn{*this, f});
+}
+
+
+} // namespace banjo
@@ -0,0 +1,77 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_ELAB_CONSTANTS_HPP
+#define BANJO_ELAB_CONSTANTS_HPP
+
+#include "language.hpp"
+
+#include <unordered_map>
+
+
+namespace banjo
+{
+
+struct Parser;
+struct Evaluator;
+
+
+// Replace constant expressions in the translation unit with literals.
+// An expression is constant when it is built from literals, references
+// to constants, the arithmetic, relational, and logical operators, and
+// calls to functions defined by expressions, all of whose arguments are
+// constant. Each maximal constant subexpression is evaluated and
+// replaced by the literal denoting its value.
+//
+// Only expressions of integer and boolean type are folded. An expression
+// whose evaluation fails (e.g., division by zero) is left unchanged, so
+// the failure happens at runtime.
+struct Elaborate_constants
+{
+  using Self = Elaborate_constants;
+
+  Elaborate_constants(Parser&);
+
+  void operator()(Translation_unit& s) { translation_unit(s); }
+
+  void translation_unit(Translation_unit&);
+
+  void statement(Stmt&);
+  void statement_seq(Stmt_list&);
+  void return_statement(Return_stmt&);
+  void yield_statement(Yield_stmt&);
+  void if_statement(If_then_stmt&);
+  void if_statement(If_else_stmt&);
+  void while_statement(While_stmt&);
+  void declaration_statement(Declaration_stmt&);
+  void expression_statement(Expression_stmt&);
+
+  void declaration(Decl&);
+  void variable_declaration(Variable_decl&);
+  void constant_declaration(Constant_decl&);
+  void function_declaration(Function_decl&);
+  void class_declaration(Class_decl&);
+
+  Expr& expression(Expr&);
+  Expr& literal(Expr&);
+
+  bool is_constant(Expr&);
+  bool is_constant_unary(Unary_expr&);
+  bool is_constant_binary(Binary_expr&);
+  bool is_constant_call(Call_expr&);
+  bool is_foldable(Function_decl const&);
+  bool is_pure(Function_decl const&, Expr const&);
+
+  Parser&    parser;
+  Context&   cxt;
+  Evaluator* eval;
+
+  // Caches whether calls to a function can be evaluated.
+  std::unordered_map<Function_decl const*, bool> funcs;
+};
+
+
+} // namespace banjo
+
+
+#endif
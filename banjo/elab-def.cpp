@@ -98,7 +98,7 @@ Parser::elaborate_coroutine_definition(Coroutine_decl &decl){
   Enter_scope scope(cxt);
   for(Decl& d: decl.parameters())
     declare(cxt, d);
-  Function_def* def = dynamic_cast<Function_def*>(&decl.definition());
+  Function_def* def = as<Function_def>(&decl.definition());
   if (def == nullptr){
     std::cout << "ERROR\n";
   }
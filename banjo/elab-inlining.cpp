@@ -0,0 +1,483 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "elab-inlining.hpp"
+#include "parser.hpp"
+#include "ast.hpp"
+
+
+namespace banjo
+{
+
+Elaborate_inlining::Elaborate_inlining(Parser& p)
+  : parser(p), cxt(p.cxt)
+{ }
+
+
+// -------------------------------------------------------------------------- //
+// Statements
+
+void
+Elaborate_inlining::translation_unit(Translation_unit& tu)
+{
+  statement_seq(tu.statements());
+}
+
+
+void
+Elaborate_inlining::statement(Stmt& s)
+{
+  struct fn
+  {
+    Self& elab;
+    void operator()(Stmt& s)             { /* Do nothing. */ }
+    void operator()(Compound_stmt& s)    { elab.statement_seq(s.statements()); }
+    void operator()(Return_stmt& s)      { elab.return_statement(s); }
+    void operator()(Yield_stmt& s)       { elab.yield_statement(s); }
+    void operator()(If_then_stmt& s)     { elab.if_statement(s); }
+    void operator()(If_else_stmt& s)     { elab.if_statement(s); }
+    void operator()(While_stmt& s)       { elab.while_statement(s); }
+    void operator()(Declaration_stmt& s) { elab.declaration_statement(s); }
+    void operator()(Expression_stmt& s)  { elab.expression_statement(s); }
+  };
+  apply(s, fn{*this});
+}
+
+
+void
+Elaborate_inlining::statement_seq(Stmt_list& ss)
+{
+  for (Stmt& s : ss)
+    statement(s);
+}
+
+
+void
+Elaborate_inlining::return_statement(Return_stmt& s)
+{
+  s.expr_ = &expression(s.expression());
+}
+
+
+void
+Elaborate_inlining::yield_statement(Yield_stmt& s)
+{
+  s.expr_ = &expression(s.expression());
+}
+
+
+void
+Elaborate_inlining::if_statement(If_then_stmt& s)
+{
+  s.cond_ = &expression(s.condition());
+  statement(s.true_branch());
+}
+
+
+void
+Elaborate_inlining::if_statement(If_else_stmt& s)
+{
+  s.cond_ = &expression(s.condition());
+  statement(s.true_branch());
+  statement(s.false_branch());
+}
+
+
+void
+Elaborate_inlining::while_statement(While_stmt& s)
+{
+  s.cond_ = &expression(s.condition());
+  statement(s.body());
+}
+
+
+void
+Elaborate_inlining::declaration_statement(Declaration_stmt& s)
+{
+  declaration(s.declaration());
+}
+
+
+void
+Elaborate_inlining::expression_statement(Expression_stmt& s)
+{
+  s.expr_ = &expression(s.expression());
+}
+
+
+// -------------------------------------------------------------------------- //
+// Declarations
+
+void
+Elaborate_inlining::declaration(Decl& d)
+{
+  struct fn
+  {
+    Self& elab;
+    void operator()(Decl& d)          { /* Do nothing. */ }
+    void operator()(Variable_decl& d) { elab.variable_declaration(d); }
+    void operator()(Function_decl& d) { elab.function_declaration(d); }
+    void operator()(Class_decl& d)    { elab.class_declaration(d); }
+  };
+  apply(d, fn{*this});
+}
+
+
+void
+Elaborate_inlining::variable_declaration(Variable_decl& d)
+{
+  if (Expression_def* def = as<Expression_def>(&d.initializer()))
+    def->expr_ = &expression(def->expression());
+}
+
+
+// The definition of a function defined by an expression may already
+// have been processed when a call to it was inlined.
+void
+Elaborate_inlining::function_declaration(Function_decl& d)
+{
+  if (is<Expression_def>(d.definition()))
+    inline_definition(d);
+  else if (Function_def* def = as<Function_def>(&d.definition()))
+    statement(def->statement());
+}
+
+
+void
+Elaborate_inlining::class_declaration(Class_decl& d)
+{
+  if (Class_def* def = as<Class_def>(&d.definition()))
+    statement_seq(def->statements());
+}
+
+
+// -------------------------------------------------------------------------- //
+// Expressions
+
+namespace
+{
+
+// Returns the index of the parameter of f declared by d, or -1 if d
+// is not a parameter of f.
+int
+parameter_index(Function_decl const& f, Decl const& d)
+{
+  Decl_list const& ps = f.parameters();
+  for (std::size_t i = 0; i < ps.size(); ++i) {
+    if (ps[i] == &d)
+      return i;
+  }
+  return -1;
+}
+
+
+// Returns true if e is a literal, a constant, or the value of an object.
+// Trivial expressions can be duplicated without changing the meaning
+// of the program.
+bool
+is_trivial(Expr const& e)
+{
+  switch (e.node_kind()) {
+    case Boolean_expr_kind:
+    case Integer_expr_kind:
+    case Value_expr_kind:
+      return true;
+    case Value_conv_kind:
+      return is<Object_expr>(cast<Value_conv>(e).source());
+    default:
+      return false;
+  }
+}
+
+
+// Returns true if e has no side effects.
+bool
+is_pure(Expr const& e)
+{
+  if (is_trivial(e))
+    return true;
+  if (Unary_expr const* u = as<Unary_expr>(&e))
+    return is_pure(u->operand());
+  if (Binary_expr const* b = as<Binary_expr>(&e))
+    return !is<Assign_expr>(e) && is_pure(b->left()) && is_pure(b->right());
+  return false;
+}
+
+
+// Returns true if e reads the value of an object.
+bool
+reads_objects(Expr const& e)
+{
+  if (is<Value_conv>(e))
+    return true;
+  if (Unary_expr const* u = as<Unary_expr>(&e))
+    return reads_objects(u->operand());
+  if (Binary_expr const* b = as<Binary_expr>(&e))
+    return reads_objects(b->left()) || reads_objects(b->right());
+  return false;
+}
+
+
+// Determines whether the definition e of f can be inlined, counting
+// its nodes in n and recording the uses of parameters and calls in def.
+bool
+is_inlinable(Function_decl const& f, Expr const& e, Inline_def& def, int& n)
+{
+  ++n;
+  switch (e.node_kind()) {
+    case Boolean_expr_kind:
+    case Integer_expr_kind:
+    case Value_expr_kind:
+      return true;
+
+    case Value_conv_kind: {
+      Object_expr const* obj = as<Object_expr>(&cast<Value_conv>(e).source());
+      int i = obj ? parameter_index(f, obj->declaration()) : -1;
+      if (i < 0)
+        return false;
+      ++def.uses[i];
+      return true;
+    }
+
+    case Call_expr_kind: {
+      Call_expr const& c = cast<Call_expr>(e);
+      if (!is<Function_expr>(c.function()))
+        return false;
+      def.calls = true;
+      for (Expr const& a : c.arguments()) {
+        if (!is_inlinable(f, a, def, n))
+          return false;
+      }
+      return true;
+    }
+
+    case Assign_expr_kind:
+      return false;
+
+    default:
+      break;
+  }
+
+  if (Unary_expr const* u = as<Unary_expr>(&e))
+    return is_inlinable(f, u->operand(), def, n);
+  if (Binary_expr const* b = as<Binary_expr>(&e))
+    return is_inlinable(f, b->left(), def, n)
+        && is_inlinable(f, b->right(), def, n);
+  return false;
+}
+
+
+// Returns the argument a converted to a value of type t, or nullptr if
+// a is neither a value of that type nor an object of that type.
+Expr*
+value_argument(Context& cxt, Expr& a, Type& t)
+{
+  if (is_equivalent(a.type(), t))
+    return &a;
+  if (is<Object_expr>(a) && is_equivalent(a.type().non_reference_type(), t))
+    return &cxt.make<Value_conv>(t, a);
+  return nullptr;
+}
+
+
+} // namespace
+
+
+Expr&
+Elaborate_inlining::expression(Expr& e)
+{
+  struct fn
+  {
+    Self& elab;
+
+    Expr& operator()(Expr& e) { return e; }
+
+    Expr& operator()(Unary_expr& e)
+    {
+      e.first = &elab.expression(*e.first);
+      return e;
+    }
+
+    Expr& operator()(Binary_expr& e)
+    {
+      e.first = &elab.expression(*e.first);
+      e.second = &elab.expression(*e.second);
+      return e;
+    }
+
+    Expr& operator()(Conv& e)
+    {
+      e.expr = &elab.expression(*e.expr);
+      return e;
+    }
+
+    Expr& operator()(Tuple_expr& e)
+    {
+      Expr_list& es = e.elements();
+      for (std::size_t i = 0; i < es.size(); ++i)
+        es[i] = &elab.expression(*es[i]);
+      return e;
+    }
+
+    Expr& operator()(Call_expr& e) { return elab.call(e); }
+  };
+  return apply(e, fn{*this});
+}
+
+
+// Replace a call to an inlinable function with its definition. Calls
+// in the arguments are inlined first.
+Expr&
+Elaborate_inlining::call(Call_expr& e)
+{
+  Expr_list& args = e.arguments();
+  for (std::size_t i = 0; i < args.size(); ++i)
+    args[i] = &expression(*args[i]);
+
+  Function_expr* fe = as<Function_expr>(&e.function());
+  if (!fe)
+    return e;
+  Function_decl& f = fe->declaration();
+  Inline_def const* def = inline_definition(f);
+  if (!def)
+    return e;
+
+  Decl_list& parms = f.parameters();
+  if (parms.size() != args.size())
+    return e;
+  if (!is_equivalent(def->expr->type(), e.type()))
+    return e;
+
+  Subst sub;
+  sub.reserve(args.size());
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    Type& t = parms[i]->type();
+    if (is_reference_type(t))
+      return e;
+    Expr* a = value_argument(cxt, *args[i], t);
+    if (!a || !is_pure(*a))
+      return e;
+    if (def->uses[i] > 1 && !is_trivial(*a))
+      return e;
+    if (def->calls && reads_objects(*a))
+      return e;
+    sub.emplace_back(parms[i], a);
+  }
+  return substitute(*def->expr, sub);
+}
+
+
+// Returns the inlinable definition of f, or nullptr if f cannot be
+// inlined. Calls within the definition of f are inlined first.
+//
+// Note that f has no inlinable definition while its own definition
+// is being processed, so recursive calls are never expanded.
+Inline_def const*
+Elaborate_inlining::inline_definition(Function_decl& f)
+{
+  auto iter = defs.find(&f);
+  if (iter != defs.end())
+    return iter->second.expr ? &iter->second : nullptr;
+  defs.emplace(&f, Inline_def());
+
+  Expression_def* def = as<Expression_def>(&f.definition());
+  if (!def)
+    return nullptr;
+  def->expr_ = &expression(def->expression());
+
+  if (is<Method_decl>(f))
+    return nullptr;
+  Inline_def d;
+  d.uses.resize(f.parameters().size());
+  int n = 0;
+  if (!is_inlinable(f, def->expression(), d, n) || n > inline_limit)
+    return nullptr;
+  d.expr = &def->expression();
+
+  Inline_def& ret = defs[&f];
+  ret = std::move(d);
+  return &ret;
+}
+
+
+// Returns a copy of e with each parameter replaced by its argument.
+// Operators are copied so that later passes can rewrite each expansion
+// independently; leaves are shared.
+Expr&
+Elaborate_inlining::substitute(Expr& e, Subst const& sub)
+{
+  switch (e.node_kind()) {
+    case Value_conv_kind: {
+      Value_conv& c = cast<Value_conv>(e);
+      if (Object_expr* obj = as<Object_expr>(&c.source())) {
+        for (auto const& p : sub) {
+          if (p.first == &obj->declaration())
+            return substitute(*p.second, {});
+        }
+      }
+      return cxt.make<Value_conv>(c.type(), c.source());
+    }
+
+    case Call_expr_kind:
+      return substitute_call(cast<Call_expr>(e), sub);
+
+    case Neg_expr_kind: return substitute_unary(cast<Neg_expr>(e), sub);
+    case Pos_expr_kind: return substitute_unary(cast<Pos_expr>(e), sub);
+    case Bit_not_expr_kind: return substitute_unary(cast<Bit_not_expr>(e), sub);
+    case Not_expr_kind: return substitute_unary(cast<Not_expr>(e), sub);
+
+    case Add_expr_kind: return substitute_binary(cast<Add_expr>(e), sub);
+    case Sub_expr_kind: return substitute_binary(cast<Sub_expr>(e), sub);
+    case Mul_expr_kind: return substitute_binary(cast<Mul_expr>(e), sub);
+    case Div_expr_kind: return substitute_binary(cast<Div_expr>(e), sub);
+    case Rem_expr_kind: return substitute_binary(cast<Rem_expr>(e), sub);
+    case Bit_or_expr_kind: return substitute_binary(cast<Bit_or_expr>(e), sub);
+    case Bit_xor_expr_kind: return substitute_binary(cast<Bit_xor_expr>(e), sub);
+    case Bit_and_expr_kind: return substitute_binary(cast<Bit_and_expr>(e), sub);
+    case Bit_lsh_expr_kind: return substitute_binary(cast<Bit_lsh_expr>(e), sub);
+    case Bit_rsh_expr_kind: return substitute_binary(cast<Bit_rsh_expr>(e), sub);
+    case Eq_expr_kind: return substitute_binary(cast<Eq_expr>(e), sub);
+    case Ne_expr_kind: return substitute_binary(cast<Ne_expr>(e), sub);
+    case Lt_expr_kind: return substitute_binary(cast<Lt_expr>(e), sub);
+    case Gt_expr_kind: return substitute_binary(cast<Gt_expr>(e), sub);
+    case Le_expr_kind: return substitute_binary(cast<Le_expr>(e), sub);
+    case Ge_expr_kind: return substitute_binary(cast<Ge_expr>(e), sub);
+    case Cmp_expr_kind: return substitute_binary(cast<Cmp_expr>(e), sub);
+    case And_expr_kind: return substitute_binary(cast<And_expr>(e), sub);
+    case Or_expr_kind: return substitute_binary(cast<Or_expr>(e), sub);
+
+    default:
+      return e;
+  }
+}
+
+
+template<typename T>
+Expr&
+Elaborate_inlining::substitute_unary(T& e, Subst const& sub)
+{
+  return cxt.make<T>(e.type(), substitute(e.operand(), sub));
+}
+
+
+template<typename T>
+Expr&
+Elaborate_inlining::substitute_binary(T& e, Subst const& sub)
+{
+  Expr& e1 = substitute(e.left(), sub);
+  Expr& e2 = substitute(e.right(), sub);
+  return cxt.make<T>(e.type(), e1, e2);
+}
+
+
+Expr&
+Elaborate_inlining::substitute_call(Call_expr& e, Subst const& sub)
+{
+  Expr_list args;
+  for (Expr& a : e.arguments())
+    args.push_back(substitute(a, sub));
+  return cxt.make_call(e.type(), e.function(), args);
+}
+
+
+} // namespace banjo
@@ -0,0 +1,95 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_ELAB_INLINING_HPP
+#define BANJO_ELAB_INLINING_HPP
+
+#include "language.hpp"
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace banjo
+{
+
+struct Parser;
+
+
+// The definition of an inlinable function.
+struct Inline_def
+{
+  Expr*            expr = nullptr; // The definition
+  std::vector<int> uses;           // The number of uses of each parameter
+  bool             calls = false;  // True if the definition has calls
+};
+
+
+// Replace calls to small functions defined by expressions with their
+// definitions, substituting arguments for parameters. This is done
+// before constant folding and code generation, so inlined calls cost
+// nothing even when the generated code is not optimized.
+//
+// A function can be inlined when its definition has no more than
+// inline_limit nodes, uses its parameters only as values, and contains
+// only literals, constants, operators, and calls. A recursive call is
+// never inlined into the function it calls.
+//
+// Each argument of an inlined call must be free of side effects. Only
+// trivial arguments (literals, constants, and object values) can be
+// substituted for a parameter that is used more than once. If the
+// definition still contains calls after inlining, the arguments must
+// not read objects, since those calls might modify them.
+struct Elaborate_inlining
+{
+  using Self  = Elaborate_inlining;
+  using Subst = std::vector<std::pair<Decl const*, Expr*>>;
+
+  static constexpr int inline_limit = 16;
+
+  Elaborate_inlining(Parser&);
+
+  void operator()(Translation_unit& s) { translation_unit(s); }
+
+  void translation_unit(Translation_unit&);
+
+  void statement(Stmt&);
+  void statement_seq(Stmt_list&);
+  void return_statement(Return_stmt&);
+  void yield_statement(Yield_stmt&);
+  void if_statement(If_then_stmt&);
+  void if_statement(If_else_stmt&);
+  void while_statement(While_stmt&);
+  void declaration_statement(Declaration_stmt&);
+  void expression_statement(Expression_stmt&);
+
+  void declaration(Decl&);
+  void variable_declaration(Variable_decl&);
+  void function_declaration(Function_decl&);
+  void class_declaration(Class_decl&);
+
+  Expr& expression(Expr&);
+  Expr& call(Call_expr&);
+
+  Inline_def const* inline_definition(Function_decl&);
+
+  Expr& substitute(Expr&, Subst const&);
+  template<typename T> Expr& substitute_unary(T&, Subst const&);
+  template<typename T> Expr& substitute_binary(T&, Subst const&);
+  Expr& substitute_call(Call_expr&, Subst const&);
+
+  Parser&  parser;
+  Context& cxt;
+
+  // The inlinable definitions of functions. A function that cannot be
+  // inlined has no definition, and neither does a function while its
+  // own definition is being processed.
+  std::unordered_map<Function_decl const*, Inline_def> defs;
+};
+
+
+} // namespace banjo
+
+
+#endif
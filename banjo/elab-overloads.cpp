@@ -70,17 +70,16 @@ Elaborate_overloads::declaration_statement(Declaration_stmt& s)
 // Declarations
 
 
+// Check the declaration against each subsequent declaration in the
+// overload set, diagnosing every conflict before failing.
 template<typename Iter>
 static void
 check_declarations(Context& cxt, Decl const& decl, Iter first, Iter last)
 {
   bool ok = true;
-   while (first != last) {
-    try {
-      check_declarations(cxt, decl, *first);
-    } catch (...) {
+  while (first != last) {
+    if (!check_declarations(cxt, decl, *first))
       ok = false;
-    }
     ++first;
   }
   if (!ok)
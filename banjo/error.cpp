@@ -28,7 +28,7 @@ Compiler_error::what() const noexcept
 {
   std::stringstream ss;
   ss.iword(ios_color_flag) = std::cerr.iword(ios_color_flag);
-  ss << diag;
+  ss << diag.diagnostic();
   buf = ss.str();
   return buf.c_str();
 }
@@ -5,6 +5,7 @@
 #define BANJO_ERROR_HPP
 
 #include "prelude.hpp"
+#include "diagnostic.hpp"
 
 namespace banjo
 {
@@ -13,6 +14,10 @@ namespace banjo
 // a compiler diagnostic. This overrides the what() function to provide
 // a textual represntation of that diagnostic.
 //
+// The diagnostic is formatted lazily, when what() is called, so that
+// errors thrown and caught during speculative checks do not pay for
+// formatting their messages.
+//
 // NOTE: Do not let compiler errors escape main(). The rendering of
 // of a diagnostic message requires that input buffers be in scope,
 // which may not be guaranteed at the point of termination.
@@ -25,34 +30,34 @@ struct Compiler_error : std::runtime_error
     : Compiler_error(error_diag, String("compiler error"))
   { }
 
-  Compiler_error(Diagnostic d)
-    : std::runtime_error(""), diag(d)
+  Compiler_error(Lazy_diagnostic d)
+    : std::runtime_error(""), diag(std::move(d))
   { }
 
   Compiler_error(Diagnostic_kind k, String const& s)
-    : Compiler_error(Diagnostic(k, Location(), s))
+    : Compiler_error(Lazy_diagnostic(k, Location(), s))
   { }
 
   Compiler_error(Diagnostic_kind k, Location loc, String const& s)
-    : Compiler_error(Diagnostic(k, loc, s))
+    : Compiler_error(Lazy_diagnostic(k, loc, s))
   { }
 
   Compiler_error(String const& s)
-    : Compiler_error(Diagnostic(error_diag, Location(), s))
+    : Compiler_error(Lazy_diagnostic(error_diag, Location(), s))
   { }
 
   Compiler_error(char const* s)
-    : Compiler_error(Diagnostic(error_diag, Location(), s))
+    : Compiler_error(Lazy_diagnostic(error_diag, Location(), String(s)))
   { }
 
   template<typename... Args>
   Compiler_error(char const* s, Args const&... args)
-    : Compiler_error(error_diag, format(s, args...))
+    : Compiler_error(Lazy_diagnostic(error_diag, Location(), s, args...))
   { }
 
   template<typename... Args>
   Compiler_error(Location loc, char const* s, Args const&... args)
-    : Compiler_error(error_diag, loc, format(s, args...))
+    : Compiler_error(Lazy_diagnostic(error_diag, loc, s, args...))
   { }
 
   template<typename... Args>
@@ -62,7 +67,7 @@ struct Compiler_error : std::runtime_error
 
   template<typename... Args>
   Compiler_error(Context& cxt, char const* s, Args const&... args)
-    : Compiler_error(error_diag, location(cxt), format(s, args...))
+    : Compiler_error(Lazy_diagnostic(error_diag, location(cxt), s, args...))
   { }
 
   virtual const char* what() const noexcept;
@@ -71,8 +76,8 @@ struct Compiler_error : std::runtime_error
   Location location(Context const&);
 
 
-  Diagnostic diag;    // The diagnostic
-  mutable String buf; // Guarantees ownership of 'what' text
+  Lazy_diagnostic diag; // The diagnostic
+  mutable String  buf;  // Guarantees ownership of 'what' text
 };
 
 
@@ -175,6 +180,20 @@ struct Limitation_error : Translation_error
 };
 
 
+// Represents an error reading or writing a precompiled module.
+struct Module_error : Translation_error
+{
+  using Translation_error::Translation_error;
+};
+
+
+// Represents an error reading a profile.
+struct Profile_error : Translation_error
+{
+  using Translation_error::Translation_error;
+};
+
+
 } // namespace banjo
 
 
@@ -6,6 +6,8 @@
 #include "builder.hpp"
 #include "printer.hpp"
 
+#include "gen/llvm/jit.hpp"
+
 #include <iostream>
 
 
@@ -29,8 +31,18 @@ Evaluator::alias(Decl const& d)
 Value
 Evaluator::load(Decl const& d)
 {
-  if (Object_decl const* var = as<Object_decl>(&d))
-    return stack.lookup(var)->second;
+  if (Object_decl const* var = as<Object_decl>(&d)) {
+    if (auto* ent = stack.lookup(var))
+      return ent->second;
+    throw Evaluation_error("object has no value");
+  }
+
+  // The values of constants are in the bottom frame.
+  if (Constant_decl const* c = as<Constant_decl>(&d)) {
+    if (auto* ent = stack.lookup(c))
+      return ent->second;
+    throw Evaluation_error("constant has no value");
+  }
 
   // What else?
   banjo_unhandled_case(d);
@@ -64,6 +76,8 @@ Evaluator::evaluate(Expr const& e)
     Value operator()(Integer_expr const& e) { return self.integer(e); }
     Value operator()(Tuple_expr const& e)   { return self.tuple(e); }
     Value operator()(Object_expr const& e)  { return self.object(e); }
+    Value operator()(Value_expr const& e)   { return self.constant(e); }
+    Value operator()(Function_expr const& e) { return self.function(e); }
     Value operator()(Call_expr const& e)    { return self.call(e); }
     Value operator()(And_expr const& e)     { return self.logical_and(e); }
     Value operator()(Or_expr const& e)      { return self.logical_or(e); }
@@ -84,6 +98,8 @@ Evaluator::evaluate(Expr const& e)
     Value operator()(Le_expr const& e)      { return self.le(e); }
     Value operator()(Ge_expr const& e)      { return self.ge(e); }
     Value operator()(Cmp_expr const& e)     { return self.cmp(e); }
+
+    Value operator()(Value_conv const& e)   { return self.to_value(e); }
   };
   return apply(e, fn{*this});
 }
@@ -96,12 +112,21 @@ Evaluator::boolean(Boolean_expr const& e)
 }
 
 
+static Integer_value wrap(Type const&, std::uint64_t);
+
+
+// Small literals are read directly from the expression. Otherwise, the
+// value is read according to the signedness of its type and wrapped to
+// its precision, as are the results of arithmetic.
 Value
 Evaluator::integer(Integer_expr const& e)
 {
-  // FIXME: Eh? Is this right? Does it matter? It wouldn't if the
-  // value contained an actual integer.
-  return Integer_value(e.value().getu());
+  if (e.is_small())
+    return Integer_value(e.small_value());
+  Integer_type const* t = as<Integer_type>(&e.type());
+  if (t && t->is_unsigned())
+    return wrap(e.type(), e.value().getu());
+  return wrap(e.type(), e.value().gets());
 }
 
 
@@ -125,6 +150,25 @@ Evaluator::object(Object_expr const& e)
 }
 
 
+// Returns the value of the constant referred to by e.
+Value
+Evaluator::constant(Value_expr const& e)
+{
+  return load(e.declaration());
+}
+
+
+// Returns a reference to the function referred to by e.
+Value
+Evaluator::function(Function_expr const& e)
+{
+  return alias(e.declaration());
+}
+
+
+// Evaluate the arguments of the call in the calling frame, and then
+// invoke the function. If a JIT is installed, and the function has
+// become hot, the call is executed natively instead.
 Value
 Evaluator::call(Call_expr const& e)
 {
@@ -133,6 +177,42 @@ Evaluator::call(Call_expr const& e)
   Value v = evaluate(e.function());
   Function_decl const& f = cast<Function_decl>(*v.get_reference());
 
+  // TODO: Parameters are copy-initialized.
+  Expr_list const& args = e.arguments();
+  Value_list vals;
+  vals.reserve(args.size());
+  for (Expr const& arg : args)
+    vals.push_back(evaluate(arg));
+
+  if (ll::Jit* jit = cxt.jit()) {
+    Value result;
+    if (jit->call(f, vals, result))
+      return result;
+  }
+  return invoke(f, vals);
+}
+
+
+// Interpret the function `f` with the given arguments.
+Value
+Evaluator::invoke(Function_decl const& f, Value_list const& args)
+{
+  // Each parameter is declared as a local variable within the
+  // function.
+  Enter_frame frame(*this);
+  Decl_list const& parms = f.parameters();
+  auto ai = args.begin();
+  auto pi = parms.begin();
+  while (ai != args.end() && pi != parms.end()) {
+    store(*pi, *ai);
+    ++ai;
+    ++pi;
+  }
+
+  // A function defined by an expression returns its value.
+  if (Expression_def const* def = as<Expression_def>(&f.definition()))
+    return evaluate(def->expression());
+
   // There should probably be a body for the function.
   //
   // FIXME: What if the function is = default. How do we determine
@@ -145,21 +225,6 @@ Evaluator::call(Call_expr const& e)
   if (!def)
     lingo_unreachable();
 
-  // Each parameter is declared as a local variable within the
-  // function.
-  Enter_frame frame(*this);
-  Expr_list const& args = e.arguments();
-  Decl_list const& parms = f.parameters();
-  auto ai = args.begin();
-  auto pi = parms.begin();
-  while (ai != args.end() && pi != parms.end()) {
-    Expr const& arg = *ai;
-    Decl const& parm = *pi;
-
-    // TODO: Parameters are copy-initialized. 
-    store(parm, evaluate(arg));
-  }
-
   // Evaluate the function definition.
   //
   // TODO: Check result in case we've thrown an exception.
@@ -207,18 +272,40 @@ Evaluator::logical_not(Not_expr const& e)
 // -------------------------------------------------------------------------- //
 // Evaluation of arithmetic expressions
 //
+// Integer arithmetic is performed with 64 bits, and each result is then
+// wrapped to the precision of the expression's type. This gives the same
+// values as generated code, which computes at the declared precision.
+//
 // TODO: This implementation assumes that all arithmetic operands have 
 // integer values. However, we'll need to dispatch based on the type.
 //
 // TODO: Check for various forms of undefined behavior and throw an
 // appropriate exception.
 
+// Returns n wrapped to the precision of the integer type t. Values of
+// other types are unchanged.
+static Integer_value
+wrap(Type const& t, std::uint64_t n)
+{
+  if (Integer_type const* z = as<Integer_type>(&t)) {
+    int p = z->precision();
+    if (p < 64) {
+      std::uint64_t m = (std::uint64_t(1) << p) - 1;
+      n &= m;
+      if (z->is_signed() && (n >> (p - 1)) != 0)
+        n |= ~m;
+    }
+  }
+  return Integer_value(n);
+}
+
+
 Value
 Evaluator::add(Add_expr const& e)
 {
   Value v1 = evaluate(e.left());
   Value v2 = evaluate(e.right());
-  return v1.get_integer() + v2.get_integer();
+  return wrap(e.type(), std::uint64_t(v1.get_integer()) + std::uint64_t(v2.get_integer()));
 }
 
 
@@ -227,7 +314,7 @@ Evaluator::sub(Sub_expr const& e)
 {
   Value v1 = evaluate(e.left());
   Value v2 = evaluate(e.right());
-  return v1.get_integer() - v2.get_integer();
+  return wrap(e.type(), std::uint64_t(v1.get_integer()) - std::uint64_t(v2.get_integer()));
 }
 
 
@@ -236,7 +323,7 @@ Evaluator::mul(Mul_expr const& e)
 {
   Value v1 = evaluate(e.left());
   Value v2 = evaluate(e.right());
-  return v1.get_integer() * v2.get_integer();
+  return wrap(e.type(), std::uint64_t(v1.get_integer()) * std::uint64_t(v2.get_integer()));
 }
 
 
@@ -245,7 +332,11 @@ Evaluator::div(Div_expr const& e)
 {
   Value v1 = evaluate(e.left());
   Value v2 = evaluate(e.right());
-  return v1.get_integer() / v2.get_integer();
+  if (v2.get_integer() == 0)
+    throw Evaluation_error("division by zero");
+  if (v2.get_integer() == -1)
+    return wrap(e.type(), -std::uint64_t(v1.get_integer()));
+  return wrap(e.type(), v1.get_integer() / v2.get_integer());
 }
 
 
@@ -254,7 +345,11 @@ Evaluator::rem(Rem_expr const& e)
 {
   Value v1 = evaluate(e.left());
   Value v2 = evaluate(e.right());
-  return v1.get_integer() % v2.get_integer();
+  if (v2.get_integer() == 0)
+    throw Evaluation_error("division by zero");
+  if (v2.get_integer() == -1)
+    return Integer_value(0);
+  return wrap(e.type(), v1.get_integer() % v2.get_integer());
 }
 
 
@@ -269,7 +364,7 @@ Value
 Evaluator::neg(Neg_expr const& e)
 {
   Value v = evaluate(e.operand());
-  return -v.get_integer();
+  return wrap(e.type(), -std::uint64_t(v.get_integer()));
 }
 
 
@@ -453,9 +548,6 @@ Evaluator::elaborate_object(Object_decl const& d)
 // -------------------------------------------------------------------------- //
 // Reduction
 
-static Expr& lift_value(Context&, Type&, Value const&);
-
-
 // FIXME: What is the location of this error?
 static Expr& 
 lift_error(Context& cxt, Type&, Error_value const& v) 
@@ -497,7 +589,8 @@ lift_tuple(Context& cxt, Type& t, Tuple_value const& v)
 }
 
 
-static Expr&
+// Construct an expression of type `t` that denotes the value `v`.
+Expr&
 lift_value(Context& cxt, Type& t, Value const& v)
 {
   struct fn
@@ -50,7 +50,10 @@ struct Evaluator
   Value integer(Integer_expr const&);
   Value tuple(Tuple_expr const&);
   Value object(Object_expr const&);
+  Value constant(Value_expr const&);
+  Value function(Function_expr const&);
   Value call(Call_expr const&);
+  Value invoke(Function_decl const&, Value_list const&);
   Value logical_and(And_expr const&);
   Value logical_or(Or_expr const&);
   Value logical_not(Not_expr const&);
@@ -147,6 +150,8 @@ evaluate(Context& cxt, Expr const& e)
 Expr const& reduce(Context&, Expr const&);
 Expr&       reduce(Context&, Expr&);
 
+Expr& lift_value(Context&, Type&, Value const&);
+
 
 } // namespace banjo
 
@@ -0,0 +1,122 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "fingerprint.hpp"
+#include "ast.hpp"
+#include "context.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+
+
+namespace banjo
+{
+
+// Incremented whenever a change to the compiler invalidates fingerprints
+// computed by an earlier version.
+constexpr std::size_t fingerprint_version = 2;
+
+
+// Sort and remove duplicate names.
+void
+Fingerprint::finish()
+{
+  std::sort(names.begin(), names.end());
+  names.erase(std::unique(names.begin(), names.end()), names.end());
+}
+
+
+namespace
+{
+
+// Maps simple names to the top-level declarations with that name.
+using Name_index = std::unordered_map<String, std::vector<Decl const*>>;
+
+
+// Returns a hash of the translation options and imported modules. These
+// are visible to every declaration in the unit.
+std::size_t
+hash_environment(Context const& cxt)
+{
+  std::size_t h = fingerprint_version;
+  boost::hash_combine(h, cxt.reorder_fields());
+
+  // Combine module hashes in path order so that the result does not
+  // depend on the order in which they were loaded.
+  std::vector<std::pair<String, std::size_t>> mods;
+  for (auto const& ent : cxt.modules()) {
+    Module const& m = *ent.second;
+    mods.emplace_back(m.path(), boost::hash_range(m.base, m.base + m.len));
+  }
+  std::sort(mods.begin(), mods.end());
+  for (auto const& m : mods)
+    boost::hash_combine(h, m);
+  return h;
+}
+
+
+// Returns the token hashes of the declarations named by `d`, directly
+// or indirectly, in ascending order. Note that `d` is not included.
+std::vector<std::size_t>
+dependencies(Fingerprint_map const& prints, Name_index const& index, Decl const& d)
+{
+  std::vector<std::size_t> deps;
+  std::unordered_set<Decl const*> seen {&d};
+  std::vector<Decl const*> work {&d};
+  while (!work.empty()) {
+    Decl const* x = work.back();
+    work.pop_back();
+    for (String const& n : prints.at(x).names) {
+      auto iter = index.find(n);
+      if (iter == index.end())
+        continue;
+      for (Decl const* y : iter->second) {
+        if (seen.insert(y).second) {
+          deps.push_back(prints.at(y).tokens);
+          work.push_back(y);
+        }
+      }
+    }
+  }
+  std::sort(deps.begin(), deps.end());
+  return deps;
+}
+
+} // namespace
+
+
+// Compute the fingerprints of the top-level declarations of the unit.
+// Declarations not recorded by the parser have no fingerprint.
+Digest_map
+fingerprint_declarations(Context& cxt, Translation_unit const& tu)
+{
+  Fingerprint_map const& prints = cxt.fingerprints();
+
+  // Index the recorded declarations of the unit by name.
+  Name_index index;
+  for (Stmt const& s : tu.statements()) {
+    if (Declaration_stmt const* ds = as<Declaration_stmt>(&s)) {
+      Decl const& d = ds->declaration();
+      if (!prints.count(&d))
+        continue;
+      if (Simple_id const* id = as<Simple_id>(&d.name()))
+        index[id->symbol().spelling()].push_back(&d);
+    }
+  }
+
+  std::size_t env = hash_environment(cxt);
+  Digest_map result;
+  for (auto const& ent : index) {
+    for (Decl const* d : ent.second) {
+      std::size_t h = env;
+      boost::hash_combine(h, prints.at(d).tokens);
+      for (std::size_t dep : dependencies(prints, index, *d))
+        boost::hash_combine(h, dep);
+      result.emplace(d, h);
+    }
+  }
+  return result;
+}
+
+
+} // namespace banjo
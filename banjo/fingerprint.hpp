@@ -0,0 +1,68 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_FINGERPRINT_HPP
+#define BANJO_FINGERPRINT_HPP
+
+// Fingerprints of top-level declarations. The parser records a hash of
+// the tokens of each top-level declaration and the identifiers that it
+// uses. A declaration's fingerprint combines its own token hash with
+// those of every top-level declaration it (transitively) names, so that
+// the fingerprint changes only when the declaration or something it
+// depends on is edited. Fingerprints are used to key the incremental
+// code generation cache.
+
+#include "prelude.hpp"
+#include "language.hpp"
+#include "token.hpp"
+
+#include <boost/functional/hash.hpp>
+
+#include <unordered_map>
+#include <vector>
+
+
+namespace banjo
+{
+
+// The token hash and used identifiers of a top-level declaration.
+//
+// Identifiers are recorded conservatively: parameters and members that
+// share the name of a top-level declaration become dependencies of the
+// declaration. This can only cause spurious invalidation.
+struct Fingerprint
+{
+  void add(Token const&);
+  void finish();
+
+  std::size_t         tokens = 0; // Hash of the declaration's tokens
+  std::vector<String> names;      // Identifiers used by the declaration
+};
+
+
+// Add the token to the fingerprint.
+inline void
+Fingerprint::add(Token const& tok)
+{
+  boost::hash_combine(tokens, tok.kind());
+  boost::hash_combine(tokens, tok.spelling());
+  if (tok.kind() == identifier_tok)
+    names.push_back(tok.spelling());
+}
+
+
+// Maps top-level declarations to the fingerprints recorded by the parser.
+using Fingerprint_map = std::unordered_map<Decl const*, Fingerprint>;
+
+
+// Maps top-level declarations to their dependency-aware fingerprints.
+using Digest_map = std::unordered_map<Decl const*, std::size_t>;
+
+
+Digest_map fingerprint_declarations(Context&, Translation_unit const&);
+
+
+} // namespace banjo
+
+
+#endif
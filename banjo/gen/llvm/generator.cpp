@@ -6,6 +6,7 @@
 #include <banjo/ast.hpp>
 #include <banjo/printer.hpp>
 #include <banjo/evaluation.hpp>
+#include <banjo/layout.hpp>
 
 #include <llvm/IR/Type.h>
 #include <llvm/IR/GlobalVariable.h>
@@ -13,9 +14,23 @@
 #include <llvm/IR/Constants.h>
 #include <llvm/IR/Instructions.h>
 #include <llvm/IR/Module.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_os_ostream.h>
 #include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/Transforms/Utils/ModuleUtils.h>
 
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <set>
+#include <sstream>
 
 
 namespace banjo
@@ -85,11 +100,12 @@ Generator::get_type(Boolean_type const&)
 }
 
 
-// FIXME: This isn't realistic.
+// Integers are represented by their precision. The size and alignment
+// that LLVM gives those types agree with those used for class layout.
 llvm::Type*
 Generator::get_type(Integer_type const& t)
 {
-  return build.getInt32Ty();
+  return build.getIntNTy(t.precision());
 }
 
 llvm::Type*
@@ -99,11 +115,18 @@ Generator::get_type(Byte_type const& t)
 }
 
 
-// FIXME: This isn't realistic.
+// Return the floating point type with the given precision. Each type
+// has exactly the size used for class layout. Other precisions are
+// represented as doubles.
 llvm::Type*
-Generator::get_type(Float_type const&)
+Generator::get_type(Float_type const& t)
 {
-  return build.getDoubleTy();
+  switch (t.precision()) {
+    case 16: return build.getHalfTy();
+    case 32: return build.getFloatTy();
+    case 128: return llvm::Type::getFP128Ty(cxt);
+    default: return build.getDoubleTy();
+  }
 }
 
 
@@ -138,16 +161,11 @@ Generator::get_type(Function_type const& t)
   return llvm::FunctionType::get(ret, parms, false);
 }
 
+// The type of a coroutine is its frame.
 llvm::Type*
 Generator::get_type(Coroutine_type const& t)
 {
-  auto const* bind = types.lookup(&t.declaration());
-  if(!bind)
-  {
-    gen(as<Coroutine_decl>(t.declaration()));
-    bind = types.lookup(&t.declaration());
-  }
-  return bind->second;
+  return get_coroutine_frame(cast<Coroutine_decl>(t.declaration()));
 }
 
 llvm::Type*
@@ -224,13 +242,17 @@ Generator::gen(Expr const& e)
     llvm::Value* operator()(And_expr const& e)     { return g.gen(e); }
     llvm::Value* operator()(Or_expr const& e)      { return g.gen(e); }
     llvm::Value* operator()(Not_expr const& e)     { return g.gen(e); }
+    llvm::Value* operator()(Assign_expr const& e)  { return g.gen(e); }
     llvm::Value* operator()(Tuple_expr const& e)   { return g.gen(e); }
     llvm::Value* operator()(Object_expr const& e)  { return g.gen(e); }
+    llvm::Value* operator()(Value_expr const& e)   { return g.gen(e); }
+    llvm::Value* operator()(Field_expr const& e)   { return g.gen(e); }
+    llvm::Value* operator()(Function_expr const& e) { return g.gen(e); }
+    llvm::Value* operator()(Call_expr const& e)    { return g.gen(e); }
 
     llvm::Value* operator()(Value_conv const& e)   { return g.gen(e); }
     llvm::Value* operator()(Boolean_conv const& e) { return g.gen(e); }
 
-    // llvm::Value* operator()(Call_expr const* e) const { return g.gen(e); }
     // llvm::Value* operator()(Dot_expr const* e) const { return g.gen(e); }
     // llvm::Value* operator()(Field_expr const* e) const { return g.gen(e); }
     // llvm::Value* operator()(Method_expr const* e) const { return g.gen(e); }
@@ -254,6 +276,8 @@ Generator::gen(Boolean_expr const& e)
 llvm::Value*
 Generator::gen(Integer_expr const& e)
 {
+  if (e.is_small())
+    return llvm::ConstantInt::get(get_type(e.type()), e.small_value(), true);
   return build.getInt(e.value().impl());
 }
 
@@ -322,6 +346,36 @@ Generator::gen(Object_expr const& e)
   return ret;
 }
 
+
+// A reference to a constant is replaced by the constant's value.
+// Note that most such references are folded during elaboration (see
+// elab-constants.hpp).
+llvm::Value*
+Generator::gen(Value_expr const& e)
+{
+  Value const& v = banjo.load(e.declaration());
+  return llvm::ConstantInt::get(get_type(e.type()), v.get_integer(), true);
+}
+
+
+// Returns the address of the field within its object. The index of
+// the field is its position in the class layout.
+llvm::Value*
+Generator::gen(Field_expr const& e)
+{
+  llvm::Value* obj = gen(e.object());
+  Field_decl const& f = cast<Field_decl>(e.declaration());
+  return build.CreateStructGEP(nullptr, obj, f.index());
+}
+
+
+// Return the function referred to by the expression.
+llvm::Value*
+Generator::gen(Function_expr const& e)
+{
+  return get_function(e.declaration());
+}
+
 #if 0
 
 llvm::Value*
@@ -542,6 +596,51 @@ Generator::gen(Not_expr const& e)
 }
 
 
+// -------------------------------------------------------------------------- //
+// Generation of assignments
+
+
+// Store the value of the right operand in the object denoted by the left
+// operand. The result is that object.
+llvm::Value*
+Generator::gen(Assign_expr const& e)
+{
+  llvm::Value* obj = gen(e.left());
+  llvm::Value* val = gen(e.right());
+  llvm::StoreInst* store = build.CreateStore(val, obj);
+  set_tbaa(store, e.left());
+  return obj;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Generation of function calls
+
+// Generate a direct call to a function. Arguments are evaluated from
+// left to right, and passed according to the parameters of the called
+// function (see get_passing).
+//
+// TODO: Support calls through function pointers and virtual calls.
+llvm::Value*
+Generator::gen(Call_expr const& e)
+{
+  llvm::Value* f = gen(e.function());
+  Expr_list const& xs = e.arguments();
+  std::vector<llvm::Value*> args;
+  args.reserve(xs.size());
+  if (Function_expr const* fe = as<Function_expr>(&e.function())) {
+    Function_decl const& d = fe->declaration();
+    Decl_list const& ps = d.parameters();
+    for (std::size_t i = 0; i < xs.size(); ++i)
+      args.push_back(gen_argument(*xs[i], get_passing(d, *ps[i])));
+  } else {
+    for (Expr const& a : xs)
+      args.push_back(gen(a));
+  }
+  return build.CreateCall(f, args);
+}
+
+
 // -------------------------------------------------------------------------- //
 // Generation of conversions
 
@@ -551,7 +650,9 @@ llvm::Value*
 Generator::gen(Value_conv const& e)
 {
   llvm::Value* v = gen(e.source());
-  return build.CreateLoad(v);
+  llvm::LoadInst* load = build.CreateLoad(v);
+  set_tbaa(load, e.source());
+  return load;
 }
 
 
@@ -707,7 +808,7 @@ Generator::gen(Promote_conv const* e)
   const Type * t = e->target();
 
   if(is<Integer_type>(t)) {
-    const Integer_type * t2 = dynamic_cast<const Integer_type*>(t);
+    const Integer_type * t2 = cast<Integer_type>(t);
     return build.CreateIntCast(v, get_type(t2), t2->is_signed());
   }
   else if (is<Float_type>(t) || is<Double_type>(t)) {
@@ -838,12 +939,22 @@ Generator::gen(Return_stmt const& s)
   build.CreateBr(exit);
 }
 
+// Store the yielded value in the coroutine frame, save the state
+// of the resumption point, and return to the caller. The code following
+// the yield is emitted into the block for that state.
 void
 Generator::gen(Yield_stmt const& s)
 {
   llvm::Value* v = gen(s.expression());
   build.CreateStore(v, ret);
-  build.CreateBr(leave);
+
+  llvm::ConstantInt* next = build.getInt32(resume->getNumCases());
+  build.CreateStore(next, state);
+  build.CreateRet(build.getTrue());
+
+  llvm::BasicBlock* b = llvm::BasicBlock::Create(cxt, "resume", fn);
+  resume->addCase(next, b);
+  build.SetInsertPoint(b);
 }
 
 
@@ -851,13 +962,15 @@ void
 Generator::gen(If_then_stmt const& s)
 {
   llvm::Value* cond = gen(s.condition());
+  std::size_t evals = gen_counter();
 
   llvm::BasicBlock* then = llvm::BasicBlock::Create(cxt, "if.then", fn);
   llvm::BasicBlock* done = llvm::BasicBlock::Create(cxt, "if.done", fn);
-  build.CreateCondBr(cond, then, done);
+  llvm::BranchInst* br = build.CreateCondBr(cond, then, done);
 
   // Emit the 'then' block
   build.SetInsertPoint(then);
+  set_branch_weights(br, evals, gen_counter());
   gen(s.true_branch());
   then = build.GetInsertBlock();
   if (!then->getTerminator())
@@ -872,14 +985,16 @@ void
 Generator::gen(If_else_stmt const& s)
 {
   llvm::Value* cond = gen(s.condition());
+  std::size_t evals = gen_counter();
 
   llvm::BasicBlock* then = llvm::BasicBlock::Create(cxt, "if.then", fn);
   llvm::BasicBlock* other = llvm::BasicBlock::Create(cxt, "if.else", fn);
   llvm::BasicBlock* done = llvm::BasicBlock::Create(cxt, "if.done", fn);
-  build.CreateCondBr(cond, then, other);
+  llvm::BranchInst* br = build.CreateCondBr(cond, then, other);
 
   // Emit the then block.
   build.SetInsertPoint(then);
+  set_branch_weights(br, evals, gen_counter());
   gen(s.true_branch());
   then = build.GetInsertBlock();
   if (!then->getTerminator())
@@ -913,10 +1028,12 @@ Generator::gen(While_stmt const& s)
   // Emit the condition test.
   build.SetInsertPoint(top);
   llvm::Value* cond = gen(s.condition());
-  build.CreateCondBr(cond, body, bot);
+  std::size_t evals = gen_counter();
+  llvm::BranchInst* br = build.CreateCondBr(cond, body, bot);
 
   // Emit the loop body.
   build.SetInsertPoint(body);
+  set_branch_weights(br, evals, gen_counter());
   gen(s.body());
   body = build.GetInsertBlock();
   if (!body->getTerminator())
@@ -997,6 +1114,7 @@ Generator::gen(Decl const& d)
     void operator()(Decl const& d)             { lingo_unhandled(d); }
     void operator()(Translation_unit const& d) { return g.gen(d); }
     void operator()(Variable_decl const& d)    { return g.gen(d); }
+    void operator()(Constant_decl const& d)    { /* Folded into uses. */ }
     void operator()(Function_decl const& d)    { return g.gen(d); }
     void operator()(Coroutine_decl const& d)   { return g.gen(d); }
 
@@ -1024,14 +1142,42 @@ Generator::gen(Translation_unit const& s)
   lingo_assert(!mod);
   mod = new llvm::Module("a.ll", cxt);
 
-  gen(s.statements());
-
-  // Dump the code to stdout.
+  // Functions, coroutines, and variables that are not reachable from
+  // exported declarations or main are not generated. They are recorded
+  // in the list of dropped declarations.
   //
-  // FIXME: This is stupid. Actually dump it to a specified output file.
-  std::error_code err;
-  llvm::raw_fd_ostream ofs(STDOUT_FILENO, false);
-  ofs << *mod;
+  // With a cache, each top-level function whose fingerprint is unchanged
+  // is linked from its cached fragment instead of being generated. Those
+  // functions are set aside, and fragments are linked only after all other
+  // declarations are generated, so that the types and globals they refer
+  // to are already defined by this module.
+  Decl_set live = reachable_declarations(s);
+  Digest_map prints;
+  if (!cache.empty() && !instrument && !trace && profile.empty())
+    prints = fingerprint_declarations(banjo, s);
+  Fingerprint_list incr;
+  for (Stmt const& stmt : s.statements()) {
+    if (Declaration_stmt const* ds = as<Declaration_stmt>(&stmt)) {
+      Decl const& d = ds->declaration();
+      if (is_removable(d) && !live.count(&d)) {
+        dropped.push_back(&d);
+        continue;
+      }
+      auto iter = prints.find(&d);
+      if (iter != prints.end() && is<Function_decl>(&d)) {
+        incr.emplace_back(&cast<Function_decl>(d), iter->second);
+        continue;
+      }
+    }
+    gen(stmt);
+  }
+  gen_incremental(incr);
+  if (instrument)
+    gen_profile_writer();
+
+  // Write the code to the output stream.
+  llvm::raw_os_ostream os(*output);
+  os << *mod;
 }
 
 
@@ -1044,18 +1190,25 @@ Generator::gen_local_variable(Variable_decl const& d)
   // Create the alloca instruction at the beginning of the function, and 
   // not at the point it is declare. That is automatic storage is allocated
   // at the beginning of the function. Initialization happens here.
-  llvm::BasicBlock& b = fn->getEntryBlock();
-  llvm::IRBuilder<> tmp(&b, b.begin());
-  llvm::Type* type = get_type(d.type());
-
-  // TODO: Between this and parameter names, I'm convinced I need
-  // an easier way to get non-mangled ids.
-  Simple_id const& id = cast<Simple_id>(d.name());
-  String name = id.symbol().spelling();
-  llvm::Value* ptr = tmp.CreateAlloca(type, nullptr, name);
-
-  // Save the decl binding.
-  declare(d, ptr);
+  //
+  // Locals of a coroutine are already bound to fields of its frame.
+  llvm::Value* ptr;
+  if (auto const* bind = stack.top().lookup(&d)) {
+    ptr = bind->second;
+  } else {
+    llvm::BasicBlock& b = fn->getEntryBlock();
+    llvm::IRBuilder<> tmp(&b, b.begin());
+    llvm::Type* type = get_type(d.type());
+
+    // TODO: Between this and parameter names, I'm convinced I need
+    // an easier way to get non-mangled ids.
+    Simple_id const& id = cast<Simple_id>(d.name());
+    String name = id.symbol().spelling();
+    ptr = tmp.CreateAlloca(type, nullptr, name);
+
+    // Save the decl binding.
+    declare(d, ptr);
+  }
 
   // Generate the initializer.
   gen_local_init(ptr, d.initializer());
@@ -1145,26 +1298,524 @@ void
 Generator::gen_init(llvm::Value* ptr, Expression_def const& e)
 {
   llvm::Value* init = gen(e.expression());
-  build.CreateStore(init, ptr);
+  llvm::StoreInst* store = build.CreateStore(init, ptr);
+  set_tbaa(store, e.expression().type());
 }
 
 
 // -------------------------------------------------------------------------- //
-// Function declarations
+// Parameter passing
+//
+// The passing mode of a parameter depends on its specifiers and the size
+// of its type. An out parameter is passed by the address of the object
+// it writes. Large in, consume, and forward parameters are passed by
+// address so that calls do not copy objects into registers; the callee
+// uses that object as its parameter. An in parameter is passed by the
+// address of the argument itself when the callee does not modify it;
+// otherwise, it is passed like a consume or forward parameter, by the
+// address of a temporary owned by the callee. All other parameters are
+// passed by value.
+
+// Objects larger than this many bytes are passed by address.
+constexpr std::size_t pass_by_value_limit = 2 * sizeof(void*);
+
 
+namespace
+{
+
+// Returns true if objects of type t should not be passed in registers.
+bool
+is_large(Context& cxt, Type const& t)
+{
+  if (is<Coroutine_type>(t))
+    return false;
+  if (is<Class_type>(t) || is<Tuple_type>(t) || is<Array_type>(t))
+    return size_of(cxt, t) > pass_by_value_limit;
+  return false;
+}
+
+} // namespace
+
+
+// Returns how the parameter p of the function f is passed. A large
+// input is passed by address only when f does not modify it. Otherwise,
+// f is given a copy.
+Passing
+Generator::get_passing(Function_decl const& f, Decl const& p)
+{
+  Specifier_set spec = p.specifiers();
+  if (is_reference_type(p.type()))
+    return pass_value;
+  if (spec & out_spec)
+    return pass_result;
+  if (!is_large(banjo, p.type()))
+    return pass_value;
+  if (spec & in_spec)
+    return effects.modifies(f, p) ? pass_owned : pass_readonly;
+  if (spec & (consume_spec | forward_spec))
+    return pass_owned;
+  return pass_value;
+}
+
+
+// Returns the type of the function d. Parameters not passed by value
+// are pointers.
+llvm::FunctionType*
+Generator::get_function_type(Function_decl const& d)
+{
+  std::vector<llvm::Type*> parms;
+  parms.reserve(d.parameters().size());
+  for (Decl const& p : d.parameters()) {
+    llvm::Type* t = get_type(p.type());
+    if (get_passing(d, p) != pass_value)
+      t = t->getPointerTo();
+    parms.push_back(t);
+  }
+  llvm::Type* ret = get_type(d.return_type());
+  return llvm::FunctionType::get(ret, parms, false);
+}
+
+
+// Describe the use of each parameter passed by address to the optimizer.
+// The callee never retains the address of an argument. Only a temporary
+// owned by the callee is known not to be referred to by any other
+// parameter or global; the argument of an in or out parameter may be
+// passed more than once, or be a global. An out parameter may be read
+// after it is written.
 void
-Generator::gen(Function_decl const& d)
+Generator::set_parameter_attributes(llvm::Function* f, Function_decl const& d)
+{
+  unsigned n = 1;
+  for (Decl const& p : d.parameters()) {
+    Passing m = get_passing(d, p);
+    if (m != pass_value)
+      f->addAttribute(n, llvm::Attribute::NoCapture);
+    if (m == pass_owned)
+      f->addAttribute(n, llvm::Attribute::NoAlias);
+    if (m == pass_readonly)
+      f->addAttribute(n, llvm::Attribute::ReadOnly);
+    ++n;
+  }
+}
+
+
+// Describe the inferred effects of the function to the optimizer (see
+// effects.hpp).
+//
+// Note that willreturn is available only in newer versions of LLVM.
+void
+Generator::set_function_attributes(llvm::Function* f, Function_decl const& d)
+{
+  Effects const& fx = effects(d);
+  if (!fx.unwinds)
+    f->addFnAttr(llvm::Attribute::NoUnwind);
+
+  // The memory effects of an instrumented or traced function include
+  // those of the counters and tracing hooks.
+  if (!trace && !instrument) {
+    if (!fx.reads && !fx.writes)
+      f->addFnAttr(llvm::Attribute::ReadNone);
+    else if (!fx.writes)
+      f->addFnAttr(llvm::Attribute::ReadOnly);
+  }
+}
+
+
+// Generate the argument a for a parameter passed as m. An object passed
+// by address is not loaded, even when the argument converts it to a value.
+// The argument of an out parameter must be an object, since a value
+// written to a temporary would be lost.
+llvm::Value*
+Generator::gen_argument(Expr const& a, Passing m)
+{
+  if (m == pass_value)
+    return gen(a);
+
+  Expr const* obj = &a;
+  if (Value_conv const* c = as<Value_conv>(&a))
+    obj = &c->source();
+  if (!is_reference_type(obj->type())) {
+    if (m == pass_result)
+      throw Translation_error("argument '{}' to an out parameter is not an object", a);
+    return gen_temporary(gen(a));
+  }
+
+  llvm::Value* ptr = gen(*obj);
+  if (m == pass_owned)
+    return gen_temporary(build.CreateLoad(ptr));
+  return ptr;
+}
+
+
+// Store v in a new temporary object in the current function and return
+// the address of that object.
+llvm::Value*
+Generator::gen_temporary(llvm::Value* v)
+{
+  llvm::BasicBlock& b = fn->getEntryBlock();
+  llvm::IRBuilder<> tmp(&b, b.begin());
+  llvm::Value* ptr = tmp.CreateAlloca(v->getType());
+  build.CreateStore(v, ptr);
+  return ptr;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Profiling
+//
+// Each function has a counter for its entries, and each branch has a
+// counter for the evaluations of its condition and one for the times
+// it is taken (see profile.hpp). With instrumentation, code is generated
+// to increment each counter. With a profile, the counters are used to
+// annotate functions with entry counts and branches with weights.
+
+// Create the next counter of the current function, generating code to
+// increment it when instrumenting. Returns the number of the counter
+// within the function.
+std::size_t
+Generator::gen_counter()
+{
+  String name = fn->getName().str();
+  std::vector<std::size_t>& cs = sites[name];
+  std::size_t n = cs.size();
+  cs.push_back(ncounters++);
+
+  // The counter array is declared with unknown bound until all counters
+  // have been created (see gen_profile_writer).
+  if (instrument) {
+    if (!counters) {
+      llvm::Type* t = llvm::ArrayType::get(build.getInt64Ty(), 0);
+      counters = new llvm::GlobalVariable(
+        *mod,                                  // owning module
+        t,                                     // type
+        false,                                 // is constant
+        llvm::GlobalVariable::ExternalLinkage, // linkage
+        nullptr,                               // initializer
+        "banjo.counters"                       // name
+      );
+    }
+    llvm::Value* ptr = build.CreateConstInBoundsGEP2_64(counters, 0, cs.back());
+    llvm::Value* v = build.CreateLoad(ptr);
+    build.CreateStore(build.CreateAdd(v, build.getInt64(1)), ptr);
+  }
+  return n;
+}
+
+
+// Record that br is weighted by the counters of the evaluations of its
+// condition and the number of times it was taken.
+void
+Generator::set_branch_weights(llvm::BranchInst* br, std::size_t evals, std::size_t taken)
+{
+  if (!profile.empty())
+    branches.push_back({br, evals, taken});
+}
+
+
+// Annotate the current function with the counts in the profile. When
+// entry is true, the first counter of the function counts its entries.
+// Weights are scaled to fit in 32 bits.
+//
+// The number of counters of a function serves as its checksum. If the
+// profile has a different number of counters than were created for the
+// function, then the function has changed since it was profiled, and its
+// counts are ignored.
+void
+Generator::apply_profile(bool entry)
+{
+  if (profile.empty())
+    return;
+  String name = fn->getName().str();
+  Counter_list const* pc = profile.counters(name);
+  if (pc && pc->size() == sites[name].size()) {
+    Counter_list const& cs = *pc;
+    if (entry)
+      fn->setEntryCount(cs[0]);
+    llvm::MDBuilder md(cxt);
+    for (Branch_site const& b : branches) {
+      std::uint64_t evals = cs[b.evals];
+      if (evals == 0)
+        continue;
+      std::uint64_t taken = std::min(cs[b.taken], evals);
+      std::uint64_t other = evals - taken;
+      while (std::max(taken, other) > UINT32_MAX) {
+        taken >>= 1;
+        other >>= 1;
+      }
+      b.br->setMetadata(llvm::LLVMContext::MD_prof, md.createBranchWeights(taken, other));
+    }
+  }
+  branches.clear();
+}
+
+
+// Define the counter array and generate a function that writes the
+// profile when the program exits. Note that each run of the program
+// replaces the profile.
+void
+Generator::gen_profile_writer()
+{
+  if (!counters)
+    return;
+
+  // Replace the declaration of the counters with their definition.
+  llvm::ArrayType* type = llvm::ArrayType::get(build.getInt64Ty(), ncounters);
+  llvm::GlobalVariable* arr = new llvm::GlobalVariable(
+    *mod,                                  // owning module
+    type,                                  // type
+    false,                                 // is constant
+    llvm::GlobalVariable::InternalLinkage, // linkage
+    llvm::Constant::getNullValue(type),    // initializer
+    ""                                     // name
+  );
+  counters->replaceAllUsesWith(llvm::ConstantExpr::getBitCast(arr, counters->getType()));
+  arr->takeName(counters);
+  counters->eraseFromParent();
+  counters = arr;
+
+  // Generate the profile header.
+  std::stringstream ss;
+  ss << "banjo-profile " << profile_version << '\n';
+  ss << ncounters << ' ' << sites.size() << '\n';
+  for (auto const& ent : sites) {
+    ss << ent.first << ' ' << ent.second.size();
+    for (std::size_t i : ent.second)
+      ss << ' ' << i;
+    ss << '\n';
+  }
+  String header = ss.str();
+
+  llvm::Type* i8p = build.getInt8PtrTy();
+  llvm::Type* i64 = build.getInt64Ty();
+  llvm::Constant* open = mod->getOrInsertFunction(
+    "fopen", i8p, i8p, i8p, nullptr);
+  llvm::Constant* write = mod->getOrInsertFunction(
+    "fwrite", i64, i8p, i64, i64, i8p, nullptr);
+  llvm::Constant* close = mod->getOrInsertFunction(
+    "fclose", build.getInt32Ty(), i8p, nullptr);
+
+  llvm::Function* f = llvm::Function::Create(
+    llvm::FunctionType::get(build.getVoidTy(), false),
+    llvm::Function::InternalLinkage,
+    "banjo.profile",
+    mod);
+  llvm::BasicBlock* b0 = llvm::BasicBlock::Create(cxt, "entry", f);
+  llvm::BasicBlock* b1 = llvm::BasicBlock::Create(cxt, "write", f);
+  llvm::BasicBlock* b2 = llvm::BasicBlock::Create(cxt, "done", f);
+
+  llvm::IRBuilder<> ib(b0);
+  llvm::Value* path = ib.CreateGlobalStringPtr(profile_file);
+  llvm::Value* mode = ib.CreateGlobalStringPtr("wb");
+  llvm::Value* file = ib.CreateCall(open, {path, mode});
+  ib.CreateCondBr(ib.CreateIsNull(file), b2, b1);
+
+  ib.SetInsertPoint(b1);
+  llvm::Value* text = ib.CreateGlobalStringPtr(header);
+  ib.CreateCall(write, {text, ib.getInt64(1), ib.getInt64(header.size()), file});
+  llvm::Value* data = ib.CreateBitCast(counters, i8p);
+  ib.CreateCall(write, {data, ib.getInt64(8), ib.getInt64(ncounters), file});
+  ib.CreateCall(close, {file});
+  ib.CreateBr(b2);
+
+  ib.SetInsertPoint(b2);
+  ib.CreateRetVoid();
+
+  llvm::appendToGlobalDtors(*mod, f, 0);
+}
+
+
+// -------------------------------------------------------------------------- //
+// Function tracing
+//
+// With tracing, each function calls __banjo_enter after its parameters
+// are initialized and __banjo_exit in its exit block. Both hooks take
+// the name of the function. They are defined by the tracing runtime,
+// which reports the calls to and time spent in each function when the
+// program exits.
+
+// Generate a call to the tracing hook for the current function.
+void
+Generator::gen_trace(char const* hook, llvm::Value* id)
+{
+  llvm::Constant* f = mod->getOrInsertFunction(
+    hook, build.getVoidTy(), build.getInt8PtrTy(), nullptr);
+  build.CreateCall(f, {id});
+}
+
+
+// -------------------------------------------------------------------------- //
+// Type-based alias analysis
+//
+// Loads and stores are tagged with TBAA metadata derived from the types
+// of the objects they access. Scalar types are described as children of the
+// byte type, since bytes may alias objects of any type. Integer types
+// of the same precision share a description regardless of sign. Each
+// class is described by the offsets and types of its members, so that
+// accesses to different fields of a class do not alias.
+
+// Returns the TBAA type description of t, or nullptr if accesses to
+// objects of type t are not described.
+llvm::MDNode*
+Generator::get_tbaa_type(Type const& t)
+{
+  Type const& u = t.unqualified_type();
+  if (Class_type const* c = as<Class_type>(&u)) {
+    if (Class_decl const* d = as<Class_decl>(&c->declaration()))
+      return get_tbaa_type(*d);
+    return nullptr;
+  }
+
+  String name;
+  if (is<Boolean_type>(u))
+    name = "bool";
+  else if (is<Byte_type>(u))
+    name = "byte";
+  else if (Integer_type const* i = as<Integer_type>(&u))
+    name = "int" + std::to_string(i->precision());
+  else if (Float_type const* f = as<Float_type>(&u))
+    name = "float" + std::to_string(f->precision());
+  else
+    return nullptr;
+
+  llvm::MDBuilder md(cxt);
+  if (!tbaa)
+    tbaa = md.createTBAARoot("Banjo TBAA");
+  llvm::MDNode*& byte = tbaa_scalars["byte"];
+  if (!byte)
+    byte = md.createTBAAScalarTypeNode("byte", tbaa);
+  llvm::MDNode*& node = tbaa_scalars[name];
+  if (!node)
+    node = md.createTBAAScalarTypeNode(name, byte);
+  return node;
+}
+
+
+// Returns the TBAA type description of the class d. Members whose types
+// are not described are omitted.
+llvm::MDNode*
+Generator::get_tbaa_type(Class_decl const& d)
+{
+  auto iter = tbaa_classes.find(&d);
+  if (iter != tbaa_classes.end())
+    return iter->second;
+
+  std::vector<std::pair<llvm::MDNode*, std::uint64_t>> mems;
+  for (Member_layout const& m : get_layout(banjo, d).members()) {
+    if (llvm::MDNode* n = get_tbaa_type(m.decl->type()))
+      mems.emplace_back(n, m.offset);
+  }
+  llvm::MDBuilder md(cxt);
+  llvm::MDNode* node = md.createTBAAStructTypeNode(get_name(d), mems);
+  tbaa_classes.emplace(&d, node);
+  return node;
+}
+
+
+// Returns the TBAA access tag for a scalar access to an object of type t,
+// or nullptr if the access is not described. A reference is stored as an
+// address, so accesses to references are not described.
+llvm::MDNode*
+Generator::get_tbaa_access(Type const& t)
+{
+  Type const& u = t.unqualified_type();
+  if (is<Class_type>(u))
+    return nullptr;
+  llvm::MDNode* access = get_tbaa_type(u);
+  if (!access)
+    return nullptr;
+  llvm::MDBuilder md(cxt);
+  return md.createTBAAStructTagNode(access, access, 0);
+}
+
+
+// Returns the TBAA access tag for a scalar access to the object denoted
+// by e, or nullptr if the access is not described. An access to a field
+// is tagged with its offset in the enclosing class.
+llvm::MDNode*
+Generator::get_tbaa_access(Expr const& e)
+{
+  Type const& t = e.type().non_reference_type();
+  llvm::MDNode* tag = get_tbaa_access(t);
+  if (!tag)
+    return nullptr;
+
+  if (Field_expr const* f = as<Field_expr>(&e)) {
+    Type const& ct = f->object().type().non_reference_type().unqualified_type();
+    if (Class_type const* c = as<Class_type>(&ct)) {
+      if (Class_decl const* d = as<Class_decl>(&c->declaration())) {
+        std::size_t off = get_layout(banjo, *d).member(f->declaration()).offset;
+        llvm::MDBuilder md(cxt);
+        return md.createTBAAStructTagNode(get_tbaa_type(*d), get_tbaa_type(t), off);
+      }
+    }
+  }
+  return tag;
+}
+
+
+// Attach the TBAA access tag for the object e to the instruction.
+void
+Generator::set_tbaa(llvm::Instruction* i, Expr const& e)
+{
+  if (llvm::MDNode* tag = get_tbaa_access(e))
+    i->setMetadata(llvm::LLVMContext::MD_tbaa, tag);
+}
+
+
+// Attach the TBAA access tag for an object of type t to the instruction.
+void
+Generator::set_tbaa(llvm::Instruction* i, Type const& t)
+{
+  if (llvm::MDNode* tag = get_tbaa_access(t))
+    i->setMetadata(llvm::LLVMContext::MD_tbaa, tag);
+}
+
+
+// -------------------------------------------------------------------------- //
+// Function declarations
+
+// Returns the LLVM function corresponding to the declaration `d`. If
+// no such function exists in the current module, a declaration is
+// created, and `d` is queued so that a definition can be generated
+// later (see gen_pending).
+llvm::Function*
+Generator::get_function(Function_decl const& d)
 {
   String name = get_name(d);
-  llvm::Type* type = get_type(d.type());
+  if (llvm::Function* f = mod->getFunction(name))
+    return f;
 
-  // Build the function.
-  llvm::FunctionType* ftype = llvm::cast<llvm::FunctionType>(type);
-  fn = llvm::Function::Create(
+  llvm::FunctionType* ftype = get_function_type(d);
+  llvm::Function* f = llvm::Function::Create(
     ftype,                           // function type
     llvm::Function::ExternalLinkage, // linkage
     name,                            // name
     mod);                            // owning module
+  set_function_attributes(f, d);
+  set_parameter_attributes(f, d);
+  pending.push_back(&d);
+  return f;
+}
+
+
+void
+Generator::gen(Function_decl const& d)
+{
+  String name = get_name(d);
+
+  // Build the function. If the function was previously referenced,
+  // then complete its existing declaration.
+  llvm::FunctionType* ftype = get_function_type(d);
+  fn = mod->getFunction(name);
+  if (!fn) {
+    fn = llvm::Function::Create(
+      ftype,                           // function type
+      llvm::Function::ExternalLinkage, // linkage
+      name,                            // name
+      mod);                            // owning module
+    set_function_attributes(fn, d);
+    set_parameter_attributes(fn, d);
+  }
 
   // Create a new binding for the variable.
   declare(d, fn);
@@ -1203,7 +1854,8 @@ Generator::gen(Function_decl const& d)
     ret = nullptr;
 
   // Allocate storage for each parameter and cause its argument value
-  // to be copied to storage.
+  // to be copied to storage. A parameter passed by address denotes the
+  // object at that address.
   {
     auto ai = fn->arg_begin();
     auto pi = d.parameters().begin();
@@ -1211,11 +1863,19 @@ Generator::gen(Function_decl const& d)
       Decl const& p = *pi;
       llvm::Argument* arg = &*ai;
 
+      if (get_passing(d, p) != pass_value) {
+        declare(p, arg);
+        ++ai;
+        ++pi;
+        continue;
+      }
+
       // Create a local variable for the argument, and store copy
       // the argument into that storage.
       llvm::Type* t = arg->getType();
       llvm::Value* var = build.CreateAlloca(t);
-      build.CreateStore(arg, var);
+      llvm::StoreInst* store = build.CreateStore(arg, var);
+      set_tbaa(store, p.type());
 
       // Bind the parameter to the allocated variable.
       declare(p, var);
@@ -1225,6 +1885,16 @@ Generator::gen(Function_decl const& d)
     }
   }
   
+  // Count calls to the function.
+  gen_counter();
+
+  // Trace entry to the function. The same name is passed on exit.
+  llvm::Value* id = nullptr;
+  if (trace) {
+    id = build.CreateGlobalStringPtr(name);
+    gen_trace("__banjo_enter", id);
+  }
+
   // Generate the body.
   gen_function_definition(d.definition());
   
@@ -1237,82 +1907,368 @@ Generator::gen(Function_decl const& d)
   // return statement,
   fn->getBasicBlockList().push_back(exit);
   build.SetInsertPoint(exit);
+  if (trace)
+    gen_trace("__banjo_exit", id);
 
   // Load and return the returned value.
   if (ret)
     build.CreateRet(build.CreateLoad(ret));
   else
     build.CreateRetVoid();
+  apply_profile(true);
 
   // Reset stateful info.
   ret = nullptr;
   fn = nullptr;
 }
 
+// -------------------------------------------------------------------------- //
+// Coroutines
+//
+// A coroutine is lowered to a stackless state machine over an explicit
+// frame. For a coroutine `c` with yield type `T`, the frame is the struct
+//
+//    %c = type { i32 state, T value, <parameters>, <locals> }
+//
+// and the following functions are generated:
+//
+//    void c.init(%c* frame, <parameters>)   -- initialize a frame
+//    i1   c.resume(%c* frame)               -- run to the next yield
+//    %c*  c.create(<parameters>)            -- allocate and initialize
+//                                              (aborts if out of memory)
+//    void c.destroy(%c* frame)              -- deallocate
+//
+// Resuming a coroutine switches on the state to the point following the
+// last yield. Each yield stores its value in the frame, records the next
+// state, and returns true. Falling off the end (or returning) sets the
+// done state and returns false. Because every parameter and local lives
+// in the frame and is addressed from the frame pointer on each resume,
+// frames hold no pointers into themselves and can be placed anywhere.
+//
+// A frame whose lifetime is bounded by its caller is allocated in the
+// caller's stack frame (see gen_coroutine_frame); the heap is only used
+// for frames that escape. There is no escape analysis yet, so whether
+// a frame escapes is decided by the code that creates it.
+
+// The indexes of the fixed fields of a coroutine frame.
+enum {
+  frame_state = 0,
+  frame_value = 1,
+  frame_first = 2, // The first parameter or local
+};
+
+
+// The resume state of a finished coroutine.
+static constexpr int done_state = -1;
+
+
+// Append the local variables declared in s to vars.
+static void
+collect_locals(Stmt const& s, std::vector<Variable_decl const*>& vars)
+{
+  struct fn
+  {
+    std::vector<Variable_decl const*>& vars;
+    void operator()(Stmt const& s)         { }
+    void operator()(Compound_stmt const& s)
+    {
+      for (Stmt const& s1 : s.statements())
+        collect_locals(s1, vars);
+    }
+    void operator()(If_then_stmt const& s)
+    {
+      collect_locals(s.true_branch(), vars);
+    }
+    void operator()(If_else_stmt const& s)
+    {
+      collect_locals(s.true_branch(), vars);
+      collect_locals(s.false_branch(), vars);
+    }
+    void operator()(While_stmt const& s)
+    {
+      collect_locals(s.body(), vars);
+    }
+    void operator()(Declaration_stmt const& s)
+    {
+      if (Variable_decl const* v = as<Variable_decl>(&s.declaration()))
+        vars.push_back(v);
+    }
+  };
+  apply(s, fn{vars});
+}
+
+
+// Returns the local variables of a coroutine in declaration order.
+static std::vector<Variable_decl const*>
+get_locals(Coroutine_decl const& d)
+{
+  std::vector<Variable_decl const*> vars;
+  if (Function_def const* def = as<Function_def>(&d.definition()))
+    collect_locals(def->statement(), vars);
+  return vars;
+}
+
+
+// Returns the frame type of the coroutine, creating it if needed.
+llvm::StructType*
+Generator::get_coroutine_frame(Coroutine_decl const& d)
+{
+  if (auto const* bind = types.lookup(&d))
+    return llvm::cast<llvm::StructType>(bind->second);
+
+  // Bind the (opaque) frame first so that recursive references to the
+  // coroutine type terminate.
+  llvm::StructType* t = llvm::StructType::create(cxt, get_name(d));
+  types.bind(&d, t);
+
+  std::vector<llvm::Type*> ts;
+  ts.push_back(build.getInt32Ty());
+  if (is<Void_type>(d.return_type()))
+    ts.push_back(build.getInt8Ty());
+  else
+    ts.push_back(get_type(d.return_type()));
+  for (Decl const& p : d.parameters())
+    ts.push_back(get_type(p.type()));
+  for (Variable_decl const* v : get_locals(d))
+    ts.push_back(get_type(v->type()));
+  t->setBody(ts);
+  return t;
+}
+
+
+// Returns the coroutine function named `d.suffix`, creating a
+// declaration if needed.
+llvm::Function*
+Generator::get_coroutine_function(Coroutine_decl const& d, char const* suffix)
+{
+  String name = get_name(d) + '.' + suffix;
+  if (llvm::Function* f = mod->getFunction(name))
+    return f;
+
+  llvm::StructType* frame = get_coroutine_frame(d);
+  llvm::Type* ptr = frame->getPointerTo();
+  std::vector<llvm::Type*> parms;
+  for (Decl const& p : d.parameters())
+    parms.push_back(get_type(p.type()));
+
+  llvm::FunctionType* ftype;
+  if (!std::strcmp(suffix, "init")) {
+    parms.insert(parms.begin(), ptr);
+    ftype = llvm::FunctionType::get(build.getVoidTy(), parms, false);
+  } else if (!std::strcmp(suffix, "resume")) {
+    ftype = llvm::FunctionType::get(build.getInt1Ty(), {ptr}, false);
+  } else if (!std::strcmp(suffix, "create")) {
+    ftype = llvm::FunctionType::get(ptr, parms, false);
+  } else if (!std::strcmp(suffix, "destroy")) {
+    ftype = llvm::FunctionType::get(build.getVoidTy(), {ptr}, false);
+  } else {
+    lingo_unreachable();
+  }
+  return llvm::Function::Create(
+    ftype,                           // function type
+    llvm::Function::ExternalLinkage, // linkage
+    name,                            // name
+    mod);                            // owning module
+}
+
+
 void
 Generator::gen(Coroutine_decl const& d)
 {
-  String name = get_name(d);
-  // llvm::Type* type = get_type(d.type());
-  
-  // This will hold the labels and use an indirect branch inst;
-  std::vector<llvm::BlockAddress*> labels; 
+  // Generate these in a new function context so that we don't disturb
+  // the function (if any) in which the coroutine type was referenced.
+  llvm::Function*   f = fn;
+  llvm::Value*      r = ret;
+  llvm::BasicBlock* e = entry;
+  llvm::BasicBlock* x = exit;
+  llvm::BasicBlock* b = build.GetInsertBlock();
 
-  // The parameters of the coroutine become members of the class, should 
-  // also probably grab them from the definition.
-  std::vector<llvm::Type*> ts;
-  for(auto &mem : d.parameters())
-    ts.push_back(get_type(mem.type()));
-
-  // Create a member variable that stores the execution state of
-  // the coroutne.
-  first = llvm::Type::getInt1Ty(cxt);
-  ts.push_back(first); // This will need to be set in the constructor.
-  llvm::Type* t = llvm::StructType::create(cxt, ts, get_name(d));
-  types.bind(&d, t);
+  gen_coroutine_init(d);
+  gen_coroutine_resume(d);
+  gen_coroutine_create(d);
+  gen_coroutine_destroy(d);
+
+  fn = f;
+  ret = r;
+  entry = e;
+  exit = x;
+  if (b)
+    build.SetInsertPoint(b);
+}
+
+
+// Generate the function that initializes a frame: copy the arguments
+// into the frame and set the initial state.
+void
+Generator::gen_coroutine_init(Coroutine_decl const& d)
+{
+  fn = get_coroutine_function(d, "init");
+  if (!fn->isDeclaration())
+    return;
+  entry = llvm::BasicBlock::Create(cxt, "entry", fn);
+  build.SetInsertPoint(entry);
 
-  // Generate the call function
-  Function_def def = as<Function_def>(d.definition());
+  auto ai = fn->arg_begin();
+  llvm::Value* frame = &*ai++;
+  build.CreateStore(build.getInt32(0), build.CreateStructGEP(nullptr, frame, frame_state));
+  for (unsigned n = frame_first; ai != fn->arg_end(); ++ai, ++n)
+    build.CreateStore(&*ai, build.CreateStructGEP(nullptr, frame, n));
+  build.CreateRetVoid();
+}
+
+
+// Generate the resume function. Parameters and locals are bound to their
+// fields in the frame. The state is dispatched by a switch in the entry
+// block whose cases are added by each yield statement.
+void
+Generator::gen_coroutine_resume(Coroutine_decl const& d)
+{
+  fn = get_coroutine_function(d, "resume");
+  if (!fn->isDeclaration())
+    return;
 
-  gen_coroutine_definition(def, d.type());
+  Enter_context scope(*this, function_cxt);
+  entry = llvm::BasicBlock::Create(cxt, "entry", fn);
+  exit = llvm::BasicBlock::Create(cxt, "exit");
+  llvm::BasicBlock* start = llvm::BasicBlock::Create(cxt, "start", fn);
+  build.SetInsertPoint(entry);
+
+  llvm::Value* frame = &*fn->arg_begin();
+  frame->setName("frame");
+  state = build.CreateStructGEP(nullptr, frame, frame_state);
+  ret = build.CreateStructGEP(nullptr, frame, frame_value);
+  unsigned n = frame_first;
+  for (Decl const& p : d.parameters())
+    declare(p, build.CreateStructGEP(nullptr, frame, n++));
+  for (Variable_decl const* v : get_locals(d))
+    declare(*v, build.CreateStructGEP(nullptr, frame, n++));
+
+  // Dispatch on the current state. Unknown states (i.e., done) go
+  // directly to the exit.
+  resume = build.CreateSwitch(build.CreateLoad(state), exit);
+  resume->addCase(build.getInt32(0), start);
+
+  build.SetInsertPoint(start);
+  gen_coroutine_definition(d.definition());
+  if (!build.GetInsertBlock()->getTerminator())
+    build.CreateBr(exit);
+
+  // The coroutine is finished.
+  fn->getBasicBlockList().push_back(exit);
+  build.SetInsertPoint(exit);
+  build.CreateStore(build.getInt32(done_state), state);
+  build.CreateRet(build.getFalse());
+  apply_profile(false);
 
+  resume = nullptr;
+  state = nullptr;
   ret = nullptr;
   fn = nullptr;
 }
 
-// Probably need all of the variables in the def to add them as members 
-// of the struct.
+
+// Allocate a frame on the heap and initialize it.
 void
-Generator::gen_coroutine_definition(Function_def const& d, Type const& t)
+Generator::gen_coroutine_create(Coroutine_decl const& d)
 {
-  // Probably need to do something else here since yield should set 
-  // a label pointer
-  String name = "call";
-  llvm::Type* type = get_type(t);
-  type->dump();
-  llvm::FunctionType* ftype = llvm::FunctionType::get(get_type(t),false);
-  fn = llvm::Function::Create(
-    ftype,                           // function type
-    llvm::Function::ExternalLinkage, // linkage
-    name,                            // name
-    mod);                            // owning module
+  fn = get_coroutine_function(d, "create");
+  if (!fn->isDeclaration())
+    return;
+  entry = llvm::BasicBlock::Create(cxt, "entry", fn);
+  build.SetInsertPoint(entry);
 
-  // Build the entry and exit blocks for the function.
+  llvm::StructType* type = get_coroutine_frame(d);
+  llvm::Constant* alloc = mod->getOrInsertFunction(
+    "malloc", build.getInt8PtrTy(), build.getInt64Ty(), nullptr);
+  llvm::Value* size = build.CreatePtrToInt(
+    llvm::ConstantExpr::getSizeOf(type), build.getInt64Ty());
+  llvm::Value* mem = build.CreateCall(alloc, {size});
+
+  // Abort if the frame cannot be allocated.
+  llvm::BasicBlock* fail = llvm::BasicBlock::Create(cxt, "fail", fn);
+  llvm::BasicBlock* init = llvm::BasicBlock::Create(cxt, "init", fn);
+  build.CreateCondBr(build.CreateIsNull(mem), fail, init);
+  build.SetInsertPoint(fail);
+  llvm::Constant* halt = mod->getOrInsertFunction(
+    "abort", build.getVoidTy(), nullptr);
+  build.CreateCall(halt, {});
+  build.CreateUnreachable();
+
+  build.SetInsertPoint(init);
+  llvm::Value* frame = build.CreateBitCast(mem, type->getPointerTo());
+  std::vector<llvm::Value*> args {frame};
+  for (auto ai = fn->arg_begin(); ai != fn->arg_end(); ++ai)
+    args.push_back(&*ai);
+  build.CreateCall(get_coroutine_function(d, "init"), args);
+  build.CreateRet(frame);
+}
+
+
+// Deallocate a frame created by create.
+void
+Generator::gen_coroutine_destroy(Coroutine_decl const& d)
+{
+  fn = get_coroutine_function(d, "destroy");
+  if (!fn->isDeclaration())
+    return;
   entry = llvm::BasicBlock::Create(cxt, "entry", fn);
-  exit  = llvm::BasicBlock::Create(cxt, "exit");
-  leave = llvm::BasicBlock::Create(cxt, "leave");
-  reenter = llvm::BasicBlock::Create(cxt, "reenter");
   build.SetInsertPoint(entry);
-  if (!is<Void_type>(t))
-    ret = build.CreateAlloca(fn->getReturnType());
-  else
-    ret = nullptr;
 
-  // Create a new binding for the variable.
-  gen_function_definition(d);
+  llvm::Constant* dealloc = mod->getOrInsertFunction(
+    "free", build.getVoidTy(), build.getInt8PtrTy(), nullptr);
+  llvm::Value* frame = &*fn->arg_begin();
+  build.CreateCall(dealloc, {build.CreateBitCast(frame, build.getInt8PtrTy())});
+  build.CreateRetVoid();
 }
 
 
+void
+Generator::gen_coroutine_definition(Def const& d)
+{
+  if (Function_def const* f = as<Function_def>(&d))
+    return gen_function_definition(*f);
+  lingo_unhandled(d);
+}
+
+
+// Returns a pointer to a new, initialized frame for the coroutine `d`
+// in the current function.
+//
+// If the frame does not escape the current function, then it is
+// allocated in the function's entry block, exactly like a local
+// variable. This elides the heap allocation entirely and allows the
+// optimizer to promote the fields of the frame to registers once init
+// and resume are inlined. Otherwise, the frame is allocated on the heap
+// and must be released by gen_coroutine_release.
+llvm::Value*
+Generator::gen_coroutine_frame(Coroutine_decl const& d, std::vector<llvm::Value*> const& args, bool escapes)
+{
+  if (escapes)
+    return build.CreateCall(get_coroutine_function(d, "create"), args);
+
+  llvm::BasicBlock& b = fn->getEntryBlock();
+  llvm::IRBuilder<> tmp(&b, b.begin());
+  llvm::Value* frame = tmp.CreateAlloca(get_coroutine_frame(d), nullptr, "frame");
+  std::vector<llvm::Value*> init {frame};
+  init.insert(init.end(), args.begin(), args.end());
+  build.CreateCall(get_coroutine_function(d, "init"), init);
+  return frame;
+}
+
+
+// Release a frame allocated by gen_coroutine_frame.
+void
+Generator::gen_coroutine_release(Coroutine_decl const& d, llvm::Value* frame, bool escapes)
+{
+  if (escapes)
+    build.CreateCall(get_coroutine_function(d, "destroy"), {frame});
+}
+
+
+// Generate the struct type for a class. The elements of the struct are
+// the base class sub-objects and fields of the class in the storage
+// order determined by its layout. Because the layout uses natural
+// alignment, LLVM places each element at the offset in the layout.
 void
 Generator::gen(Class_decl const& d)
 {
@@ -1320,26 +2276,27 @@ Generator::gen(Class_decl const& d)
   if (types.lookup(&d))
     return;
 
-  // Holds the types and also the super classes.
-  // Super classes should be put at the head of the vector
-  std::vector<llvm::Type*> ts;
-
-  // Check for parent classes and add them to ts
-  Class_def def = as<Class_def>(d.definition());
+  // Bind the (opaque) type first so that references to the class
+  // within its members terminate.
+  llvm::StructType* t = llvm::StructType::create(cxt, get_name(d));
+  types.bind(&d, t);
 
-  // Construct the type over only the fields. If the record
-  // is empty, generate a struct with exactly one  byte so that
+  // Construct the type over the bases and fields. If the class
+  // is empty, generate a struct with exactly one byte so that
   // we never have a type with 0 size.
-  if (def.objects().empty()) {
+  Class_layout const& layout = get_layout(banjo, d);
+  std::vector<llvm::Type*> ts;
+  if (layout.members().empty()) {
     ts.push_back(build.getInt8Ty());
   } else {
-    for (Decl const& mem : def.objects())
-      ts.push_back(get_type(mem.type()));
+    for (Member_layout const& m : layout.members()) {
+      if (Super_decl const* s = as<Super_decl>(m.decl))
+        ts.push_back(get_type(s->type()));
+      else
+        ts.push_back(get_type(cast<Field_decl>(m.decl)->type()));
+    }
   }
-
-  // Create the llvm type
-  llvm::Type* t = llvm::StructType::create(cxt, ts, get_name(d));
-  types.bind(&d,t);
+  t->setBody(ts);
 
   // Now, generate code for all other members.
   // FIXME: Re-enable the emission of methods, and functions for
@@ -1356,9 +2313,11 @@ Generator::gen(Class_decl const& d)
 void 
 Generator::gen_function_definition(Def const& d)
 {
-  // At this point, we only have function definitions.
+  // At this point, we only have function and expression definitions.
   if (Function_def const* f = as<Function_def>(&d))
     return gen_function_definition(*f);
+  if (Expression_def const* e = as<Expression_def>(&d))
+    return gen_function_definition(*e);
   lingo_unreachable();
 }
 
@@ -1370,6 +2329,189 @@ Generator::gen_function_definition(Function_def const& d)
 }
 
 
+// An expression definition is generated like a return statement: the
+// value is stored in the return value and we branch to the exit.
+void
+Generator::gen_function_definition(Expression_def const& d)
+{
+  llvm::Value* v = gen(d.expression());
+  build.CreateStore(v, ret);
+  build.CreateBr(exit);
+}
+
+
+// Generate definitions for each function that has been referenced, but
+// not defined, in the current module.
+void
+Generator::gen_pending()
+{
+  while (!pending.empty()) {
+    Function_decl const& d = *pending.back();
+    pending.pop_back();
+    if (get_function(d)->isDeclaration())
+      gen(d);
+  }
+}
+
+
+// -------------------------------------------------------------------------- //
+// Incremental generation
+//
+// A fragment is a bitcode module containing the definition of a single
+// function and declarations of the globals it references. Fragments are
+// stored in the cache directory, named by the fingerprint of the function
+// (see fingerprint.hpp).
+
+// Returns the path of the fragment with the given fingerprint.
+String
+Generator::fragment_path(std::size_t fp) const
+{
+  std::stringstream ss;
+  ss << cache << '/' << std::hex << std::setw(16) << std::setfill('0') << fp << ".bc";
+  return ss.str();
+}
+
+
+// Generate or link the given functions and their fingerprints. Cached
+// fragments are read first. The functions without fragments are then
+// generated and saved, and the fragments are linked last. Note that a
+// fragment that cannot be linked is generated again.
+void
+Generator::gen_incremental(Fingerprint_list const& fns)
+{
+  std::vector<Function_decl const*> hits;
+  std::vector<std::unique_ptr<llvm::Module>> frags;
+  for (auto const& f : fns) {
+    if (std::unique_ptr<llvm::Module> m = load_fragment(f.second)) {
+      hits.push_back(f.first);
+      frags.push_back(std::move(m));
+    } else {
+      gen(*f.first);
+      save_fragment(*f.first, f.second);
+    }
+  }
+  for (std::size_t i = 0; i < frags.size(); ++i) {
+    if (llvm::Linker::linkModules(*mod, std::move(frags[i])))
+      gen(*hits[i]);
+  }
+}
+
+
+// Read the cached fragment with the given fingerprint. Returns nullptr if
+// there is no such fragment or if it cannot be read.
+std::unique_ptr<llvm::Module>
+Generator::load_fragment(std::size_t fp)
+{
+  auto buf = llvm::MemoryBuffer::getFile(fragment_path(fp));
+  if (!buf)
+    return nullptr;
+  auto frag = llvm::parseBitcodeFile(**buf, cxt);
+  if (!frag) {
+    llvm::consumeError(frag.takeError());
+    return nullptr;
+  }
+  return std::move(*frag);
+}
+
+
+namespace
+{
+
+// Add the globals referenced by the value v to gs. Constant expressions
+// and aggregates are searched for the globals they use.
+void
+collect_globals(llvm::Value const* v, std::set<llvm::GlobalValue const*>& gs)
+{
+  if (llvm::GlobalValue const* g = llvm::dyn_cast<llvm::GlobalValue>(v)) {
+    gs.insert(g);
+    return;
+  }
+  if (llvm::Constant const* c = llvm::dyn_cast<llvm::Constant>(v)) {
+    for (llvm::Use const& u : c->operands())
+      collect_globals(u.get(), gs);
+  }
+}
+
+
+// Declare the global g in the module m.
+llvm::GlobalValue*
+declare_global(llvm::Module& m, llvm::GlobalValue const* g)
+{
+  if (llvm::Function const* f = llvm::dyn_cast<llvm::Function>(g)) {
+    llvm::Function* d = llvm::Function::Create(
+      f->getFunctionType(), llvm::GlobalValue::ExternalLinkage, f->getName(), &m);
+    d->copyAttributesFrom(f);
+    d->setLinkage(llvm::GlobalValue::ExternalLinkage);
+    return d;
+  }
+  llvm::GlobalVariable const* v = llvm::cast<llvm::GlobalVariable>(g);
+  return new llvm::GlobalVariable(
+    m,                                     // owning module
+    v->getValueType(),                     // type
+    v->isConstant(),                       // is constant
+    llvm::GlobalValue::ExternalLinkage,    // linkage
+    nullptr,                               // initializer
+    v->getName()                           // name
+  );
+}
+
+} // namespace
+
+
+// Save the generated definition of `d` as a fragment. Fragments are
+// written to a temporary file and renamed, so that a concurrent build
+// never reads a partial fragment.
+//
+// The fragment is built from the function alone: its body is cloned
+// into a new module along with declarations of the globals it
+// references. This keeps the cost of saving a fragment proportional to
+// the size of the function and not the module.
+void
+Generator::save_fragment(Function_decl const& d, std::size_t fp)
+{
+  llvm::Function* f = mod->getFunction(get_name(d));
+  if (!f || f->isDeclaration())
+    return;
+
+  std::unique_ptr<llvm::Module> frag(new llvm::Module(mod->getModuleIdentifier(), cxt));
+  frag->setDataLayout(mod->getDataLayout());
+  frag->setTargetTriple(mod->getTargetTriple());
+
+  // Declare the referenced globals.
+  std::set<llvm::GlobalValue const*> gs;
+  for (llvm::BasicBlock const& b : *f)
+    for (llvm::Instruction const& i : b)
+      for (llvm::Use const& u : i.operands())
+        collect_globals(u.get(), gs);
+  llvm::ValueToValueMapTy map;
+  for (llvm::GlobalValue const* g : gs) {
+    if (g != f)
+      map[g] = declare_global(*frag, g);
+  }
+
+  // Clone the definition.
+  llvm::Function* g = llvm::Function::Create(
+    f->getFunctionType(), f->getLinkage(), f->getName(), frag.get());
+  auto ai = g->arg_begin();
+  for (llvm::Argument const& a : f->args())
+    map[&a] = &*ai++;
+  map[f] = g;
+  llvm::SmallVector<llvm::ReturnInst*, 4> rets;
+  llvm::CloneFunctionInto(g, f, map, true, rets);
+
+  String path = fragment_path(fp);
+  String tmp = path + ".tmp";
+  std::error_code err;
+  {
+    llvm::raw_fd_ostream os(tmp, err, llvm::sys::fs::F_None);
+    if (err)
+      return;
+    llvm::WriteBitcodeToFile(frag.get(), os);
+  }
+  std::rename(tmp.c_str(), path.c_str());
+}
+
+
 #if 0
 
 
@@ -1570,6 +2712,272 @@ Generator::operator()(Decl const& d)
 }
 
 
+// -------------------------------------------------------------------------- //
+// Standalone entry points
+//
+// A thunk is an entry point with the signature `i64 (i64*)`. Arguments
+// are unpacked from the array and narrowed to their declared types, and
+// the result is widened to 64 bits. This allows generated code to be
+// called without knowing its signature statically (e.g., by the JIT).
+//
+// Each thunk is generated into a new module, which also contains every
+// function it (transitively) calls. Ownership of the module is passed
+// to the caller.
+
+
+// Create the thunk function in the current module and position the
+// builder in its entry block.
+llvm::Function*
+Generator::start_thunk(String const& name)
+{
+  llvm::Type* i64 = build.getInt64Ty();
+  llvm::FunctionType* ftype = llvm::FunctionType::get(i64, {i64->getPointerTo()}, false);
+  fn = llvm::Function::Create(
+    ftype,                           // function type
+    llvm::Function::ExternalLinkage, // linkage
+    name,                            // name
+    mod);                            // owning module
+  entry = llvm::BasicBlock::Create(cxt, "entry", fn);
+  build.SetInsertPoint(entry);
+  return fn;
+}
+
+
+// Widen a scalar value of type `t` to a 64-bit integer.
+llvm::Value*
+Generator::gen_widen(llvm::Value* v, Type const& t)
+{
+  bool sgn = false;
+  if (Integer_type const* i = as<Integer_type>(&t))
+    sgn = i->is_signed();
+  return build.CreateIntCast(v, build.getInt64Ty(), sgn);
+}
+
+
+// Narrow a 64-bit integer to a scalar value of type `t`.
+llvm::Value*
+Generator::gen_narrow(llvm::Value* v, Type const& t)
+{
+  bool sgn = false;
+  if (Integer_type const* i = as<Integer_type>(&t))
+    sgn = i->is_signed();
+  return build.CreateIntCast(v, get_type(t), sgn);
+}
+
+
+// Generate a module containing a thunk that calls the function `f`.
+// The module is owned by the thunk generator until it is returned so
+// that it is deleted if generation fails.
+llvm::Module*
+Generator::gen_thunk(String const& name, Function_decl const& f)
+{
+  Enter_context dc(*this, global_cxt);
+  lingo_assert(!mod);
+  mod = new llvm::Module(name, cxt);
+  std::unique_ptr<llvm::Module> m(mod);
+
+  // Generate the target and everything it calls.
+  llvm::Function* target = get_function(f);
+  gen_pending();
+
+  // Unpack the arguments and call the target.
+  llvm::Function* thunk = start_thunk(name);
+  llvm::Value* argv = &*thunk->arg_begin();
+  std::vector<llvm::Value*> args;
+  int n = 0;
+  for (Decl const& p : f.parameters()) {
+    llvm::Value* ptr = build.CreateConstGEP1_32(argv, n++);
+    llvm::Value* arg = gen_narrow(build.CreateLoad(ptr), p.type());
+    if (get_passing(f, p) != pass_value)
+      arg = gen_temporary(arg);
+    args.push_back(arg);
+  }
+  llvm::Value* result = build.CreateCall(target, args);
+  build.CreateRet(gen_widen(result, f.return_type()));
+
+  reset();
+  return m.release();
+}
+
+
+// Generate a module containing a thunk that calls the function `f`
+// repeatedly. The first argument is a number of calls, and the remaining
+// arguments are passed to `f`. The thunk returns the sum of the results.
+llvm::Module*
+Generator::gen_driver(String const& name, Function_decl const& f)
+{
+  Enter_context dc(*this, global_cxt);
+  lingo_assert(!mod);
+  mod = new llvm::Module(name, cxt);
+  std::unique_ptr<llvm::Module> m(mod);
+
+  // Generate the target and everything it calls.
+  llvm::Function* target = get_function(f);
+  gen_pending();
+
+  // Unpack the arguments.
+  llvm::Function* thunk = start_thunk(name);
+  llvm::Value* argv = &*thunk->arg_begin();
+  llvm::Value* calls = build.CreateLoad(argv);
+  std::vector<llvm::Value*> args;
+  int n = 1;
+  for (Decl const& p : f.parameters()) {
+    llvm::Value* ptr = build.CreateConstGEP1_32(argv, n++);
+    llvm::Value* arg = gen_narrow(build.CreateLoad(ptr), p.type());
+    if (get_passing(f, p) != pass_value)
+      arg = gen_temporary(arg);
+    args.push_back(arg);
+  }
+  llvm::Type* i64 = build.getInt64Ty();
+  llvm::Value* sum = build.CreateAlloca(i64);
+  llvm::Value* iter = build.CreateAlloca(i64);
+  build.CreateStore(build.getInt64(0), sum);
+  build.CreateStore(build.getInt64(0), iter);
+
+  llvm::BasicBlock* loop = llvm::BasicBlock::Create(cxt, "loop", fn);
+  llvm::BasicBlock* body = llvm::BasicBlock::Create(cxt, "body", fn);
+  llvm::BasicBlock* done = llvm::BasicBlock::Create(cxt, "done", fn);
+  build.CreateBr(loop);
+
+  // Call the target once per iteration, accumulating its results.
+  build.SetInsertPoint(loop);
+  llvm::Value* i = build.CreateLoad(iter);
+  build.CreateCondBr(build.CreateICmpSLT(i, calls), body, done);
+
+  build.SetInsertPoint(body);
+  llvm::Value* v = build.CreateCall(target, args);
+  v = gen_widen(v, f.return_type());
+  build.CreateStore(build.CreateAdd(build.CreateLoad(sum), v), sum);
+  build.CreateStore(build.CreateAdd(i, build.getInt64(1)), iter);
+  build.CreateBr(loop);
+
+  build.SetInsertPoint(done);
+  build.CreateRet(build.CreateLoad(sum));
+
+  reset();
+  return m.release();
+}
+
+
+// Generate a module containing a thunk that evaluates the expression
+// `e`. The thunk ignores its arguments.
+llvm::Module*
+Generator::gen_thunk(String const& name, Expr const& e)
+{
+  Enter_context dc(*this, global_cxt);
+  lingo_assert(!mod);
+  mod = new llvm::Module(name, cxt);
+  std::unique_ptr<llvm::Module> m(mod);
+
+  // Generate the expression in the thunk.
+  start_thunk(name);
+  llvm::Value* result = gen(e);
+  build.CreateRet(gen_widen(result, e.type()));
+
+  // Generate the functions called by the expression. This must follow
+  // the completion of the thunk since it repositions the builder.
+  gen_pending();
+
+  reset();
+  return m.release();
+}
+
+
+// Generate a module containing a thunk that drives the coroutine `d`.
+// The first argument is a number of rounds, and the remaining arguments
+// are passed to the coroutine. Each round creates a frame and resumes
+// it until it is done. The thunk returns the sum of all yielded values.
+//
+// When `escapes` is false, the frame is allocated in the thunk's stack
+// frame. Otherwise, it is allocated on the heap.
+llvm::Module*
+Generator::gen_thunk(String const& name, Coroutine_decl const& d, bool escapes)
+{
+  Enter_context dc(*this, global_cxt);
+  lingo_assert(!mod);
+  mod = new llvm::Module(name, cxt);
+  std::unique_ptr<llvm::Module> m(mod);
+
+  // Generate the coroutine and everything it calls.
+  gen(d);
+  gen_pending();
+
+  // Unpack the arguments.
+  llvm::Function* thunk = start_thunk(name);
+  llvm::Value* argv = &*thunk->arg_begin();
+  llvm::Value* rounds = build.CreateLoad(argv);
+  std::vector<llvm::Value*> args;
+  int n = 1;
+  for (Decl const& p : d.parameters()) {
+    llvm::Value* ptr = build.CreateConstGEP1_32(argv, n++);
+    args.push_back(gen_narrow(build.CreateLoad(ptr), p.type()));
+  }
+  llvm::Type* i64 = build.getInt64Ty();
+  llvm::Value* sum = build.CreateAlloca(i64);
+  llvm::Value* iter = build.CreateAlloca(i64);
+  build.CreateStore(build.getInt64(0), sum);
+  build.CreateStore(build.getInt64(0), iter);
+
+  llvm::BasicBlock* outer = llvm::BasicBlock::Create(cxt, "outer", fn);
+  llvm::BasicBlock* body = llvm::BasicBlock::Create(cxt, "body", fn);
+  llvm::BasicBlock* inner = llvm::BasicBlock::Create(cxt, "inner", fn);
+  llvm::BasicBlock* value = llvm::BasicBlock::Create(cxt, "value", fn);
+  llvm::BasicBlock* next = llvm::BasicBlock::Create(cxt, "next", fn);
+  llvm::BasicBlock* done = llvm::BasicBlock::Create(cxt, "done", fn);
+  build.CreateBr(outer);
+
+  // Repeat for each round.
+  build.SetInsertPoint(outer);
+  llvm::Value* i = build.CreateLoad(iter);
+  build.CreateCondBr(build.CreateICmpSLT(i, rounds), body, done);
+
+  build.SetInsertPoint(body);
+  llvm::Value* frame = gen_coroutine_frame(d, args, escapes);
+  build.CreateBr(inner);
+
+  // Resume until done, accumulating yielded values.
+  build.SetInsertPoint(inner);
+  llvm::Value* more = build.CreateCall(get_coroutine_function(d, "resume"), {frame});
+  build.CreateCondBr(more, value, next);
+
+  build.SetInsertPoint(value);
+  llvm::Value* v = build.CreateLoad(build.CreateStructGEP(nullptr, frame, frame_value));
+  v = gen_widen(v, d.return_type());
+  build.CreateStore(build.CreateAdd(build.CreateLoad(sum), v), sum);
+  build.CreateBr(inner);
+
+  build.SetInsertPoint(next);
+  gen_coroutine_release(d, frame, escapes);
+  build.CreateStore(build.CreateAdd(i, build.getInt64(1)), iter);
+  build.CreateBr(outer);
+
+  build.SetInsertPoint(done);
+  build.CreateRet(build.CreateLoad(sum));
+
+  reset();
+  return m.release();
+}
+
+
+// Reset the generator so that a new module can be generated. Note that
+// this does not delete the current module.
+void
+Generator::reset()
+{
+  mod = nullptr;
+  fn = nullptr;
+  ret = nullptr;
+  state = nullptr;
+  resume = nullptr;
+  pending.clear();
+  counters = nullptr;
+  ncounters = 0;
+  sites.clear();
+  branches.clear();
+  build.ClearInsertionPoint();
+}
+
+
 } // namespace ll
 
 } // namespace banjo
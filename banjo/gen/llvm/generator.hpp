@@ -8,13 +8,23 @@
 
 #include <banjo/language.hpp>
 #include <banjo/ast.hpp>
+#include <banjo/fingerprint.hpp>
+#include <banjo/reachability.hpp>
+#include <banjo/effects.hpp>
+
+#include "profile.hpp"
 
 #include <lingo/environment.hpp>
 
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/MDBuilder.h>
 
+#include <iostream>
+#include <map>
+#include <memory>
 #include <stack>
+#include <unordered_map>
 
 
 namespace banjo
@@ -46,6 +56,18 @@ using Symbol_stack = Stack<Symbol_env>;
 using Type_env = Environment<Decl const*, llvm::Type*>;
 
 
+// The ways in which an argument is passed to a parameter. Small values
+// are passed in registers. Large objects and the targets of out
+// parameters are passed by address (see Generator::get_passing).
+enum Passing
+{
+  pass_value,    // The argument value
+  pass_readonly, // The address of an object the callee only reads
+  pass_owned,    // The address of an object owned by the callee
+  pass_result,   // The address of an object the callee writes
+};
+
+
 struct Generator
 {
   Generator(Context&);
@@ -73,6 +95,8 @@ struct Generator
   llvm::Value* gen(Integer_expr const&);
   llvm::Value* gen(Tuple_expr const&);
   llvm::Value* gen(Object_expr const&);
+  llvm::Value* gen(Value_expr const&);
+  llvm::Value* gen(Field_expr const&);
 
   // Arithmetic expressions
   llvm::Value* gen(Real_expr const&);
@@ -97,7 +121,11 @@ struct Generator
   llvm::Value* gen(And_expr const&);
   llvm::Value* gen(Or_expr const&);
   llvm::Value* gen(Not_expr const&);
+
+  // Assignment
+  llvm::Value* gen(Assign_expr const&);
   llvm::Value* gen(Call_expr const&);
+  llvm::Value* gen(Function_expr const&);
 
   // Conversions
   llvm::Value* gen(Value_conv const&);
@@ -130,15 +158,70 @@ struct Generator
   void gen(Function_decl const&);
   void gen_function_definition(Def const&);
   void gen_function_definition(Function_def const&);
+  void gen_function_definition(Expression_def const&);
   void gen(Type_decl const&);
   void gen(Object_parm const&);
   void gen(Coroutine_decl const&);
   void gen(Class_decl const&);
-  void gen_coroutine_definition(Function_def const&, Type const&);
+  void gen_pending();
+
+  // Parameter passing
+  Passing             get_passing(Function_decl const&, Decl const&);
+  llvm::FunctionType* get_function_type(Function_decl const&);
+  void                set_parameter_attributes(llvm::Function*, Function_decl const&);
+  llvm::Value*        gen_argument(Expr const&, Passing);
+  llvm::Value*        gen_temporary(llvm::Value*);
+  void                set_function_attributes(llvm::Function*, Function_decl const&);
+
+  // Profiling
+  std::size_t gen_counter();
+  void        set_branch_weights(llvm::BranchInst*, std::size_t, std::size_t);
+  void        apply_profile(bool);
+  void        gen_profile_writer();
+
+  // Function tracing
+  void gen_trace(char const*, llvm::Value*);
+
+  // Type-based alias analysis
+  llvm::MDNode* get_tbaa_type(Type const&);
+  llvm::MDNode* get_tbaa_type(Class_decl const&);
+  llvm::MDNode* get_tbaa_access(Type const&);
+  llvm::MDNode* get_tbaa_access(Expr const&);
+  void          set_tbaa(llvm::Instruction*, Expr const&);
+  void          set_tbaa(llvm::Instruction*, Type const&);
+
+  // Coroutines
+  llvm::StructType* get_coroutine_frame(Coroutine_decl const&);
+  llvm::Function*   get_coroutine_function(Coroutine_decl const&, char const*);
+  void              gen_coroutine_init(Coroutine_decl const&);
+  void              gen_coroutine_resume(Coroutine_decl const&);
+  void              gen_coroutine_create(Coroutine_decl const&);
+  void              gen_coroutine_destroy(Coroutine_decl const&);
+  void              gen_coroutine_definition(Def const&);
+  llvm::Value*      gen_coroutine_frame(Coroutine_decl const&, std::vector<llvm::Value*> const&, bool);
+  void              gen_coroutine_release(Coroutine_decl const&, llvm::Value*, bool);
+
+  // Standalone entry points
+  llvm::Module*   gen_thunk(String const&, Function_decl const&);
+  llvm::Module*   gen_thunk(String const&, Expr const&);
+  llvm::Module*   gen_thunk(String const&, Coroutine_decl const&, bool);
+  llvm::Module*   gen_driver(String const&, Function_decl const&);
+  llvm::Function* start_thunk(String const&);
+  llvm::Value*    gen_widen(llvm::Value*, Type const&);
+  llvm::Value*    gen_narrow(llvm::Value*, Type const&);
+  void            reset();
+
+  // Incremental generation
+  using Fingerprint_list = std::vector<std::pair<Function_decl const*, std::size_t>>;
+  void                          gen_incremental(Fingerprint_list const&);
+  String                        fragment_path(std::size_t) const;
+  std::unique_ptr<llvm::Module> load_fragment(std::size_t);
+  void                          save_fragment(Function_decl const&, std::size_t);
 
   // Name  bindings
   void declare(Decl const&, llvm::Value*);
   llvm::Value* lookup(Decl const&);
+  llvm::Function* get_function(Function_decl const&);
 
   // The Banjo context.
   Context& banjo; 
@@ -158,17 +241,63 @@ struct Generator
   llvm::BasicBlock* top;   // Loop top
   llvm::BasicBlock* bot;   // Loop bottom
 
-  // Information about coroutines
-  llvm::BasicBlock* leave;   // Coroutine yield
-  llvm::BasicBlock* reenter; // Should be where the corouitine goes.
-  llvm::Type*       first;   // First call
-  std::vector<llvm::BasicBlock*> blocks; // Holds all of the blocks between yield statments
+  // Information about the current coroutine. Note that ret points
+  // to the yielded value in the frame.
+  llvm::Value*      state;  // The resume state in the frame
+  llvm::SwitchInst* resume; // Dispatch on the resume state
 
   // Environment.
   int           declcxt; // The current declaration context
   Symbol_stack  stack;   // Local symbol names
   Type_env      types;   // Declared types
 
+  // Functions referenced, but not yet generated, in the current module.
+  std::vector<Function_decl const*> pending;
+
+  // The directory of cached function fragments. Code generation for
+  // translation units is incremental when this is non-empty.
+  String cache;
+
+  // Inferred effects of functions.
+  Effect_analysis effects;
+
+  // The TBAA root, and the type descriptors of scalar types (by name)
+  // and classes.
+  llvm::MDNode*                                  tbaa;
+  std::unordered_map<String, llvm::MDNode*>      tbaa_scalars;
+  std::unordered_map<Decl const*, llvm::MDNode*> tbaa_classes;
+
+  // Profiling. When instrumenting, every counter is an element of a
+  // single array in the module. The counters created for each function
+  // are recorded so that the profile header can be generated and so
+  // that profile data can be matched to the counters. The branches
+  // of the current function are annotated only after its body has been
+  // generated (see apply_profile).
+  struct Branch_site
+  {
+    llvm::BranchInst* br;
+    std::size_t       evals;
+    std::size_t       taken;
+  };
+
+  bool                                       instrument;
+  Profile                                    profile;
+  llvm::GlobalVariable*                      counters;
+  std::size_t                                ncounters;
+  std::map<String, std::vector<std::size_t>> sites;
+  std::vector<Branch_site>                   branches;
+
+  // When tracing, every generated function calls the hooks of the
+  // tracing runtime on entry and exit (see runtime/trace.cpp).
+  bool trace;
+
+  // Top-level declarations that were not generated because they are
+  // unreachable (see reachable_declarations).
+  std::vector<Decl const*> dropped;
+
+  // The stream to which generated translation units are written.
+  std::ostream* output;
+
   struct Enter_context;
   struct Enter_loop;
 };
@@ -176,7 +305,15 @@ struct Generator
 
 inline
 Generator::Generator(Context& bc)
-  : banjo(bc), cxt(), build(cxt), mod(nullptr), declcxt(invalid_cxt)
+  : banjo(bc), cxt(), build(cxt), mod(nullptr)
+  , state(nullptr), resume(nullptr), declcxt(invalid_cxt)
+  , effects([this](Function_decl const& f, Decl const& p) {
+      return get_passing(f, p) != pass_value;
+    })
+  , tbaa(nullptr)
+  , instrument(false), counters(nullptr), ncounters(0)
+  , trace(false)
+  , output(&std::cout)
 { }
 
 
@@ -0,0 +1,260 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "jit.hpp"
+
+#include <banjo/ast.hpp>
+#include <banjo/context.hpp>
+
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Mangler.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/DynamicLibrary.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+
+
+namespace banjo
+{
+
+namespace ll
+{
+
+// Initialize the native target (once) and select a target machine for
+// the host.
+static llvm::TargetMachine*
+make_host_target()
+{
+  static bool init = false;
+  if (!init) {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    llvm::InitializeNativeTargetAsmParser();
+    init = true;
+  }
+  return llvm::EngineBuilder().selectTarget();
+}
+
+
+Jit::Jit(Context& cxt)
+  : banjo(cxt)
+  , gen(cxt)
+  , target(make_host_target())
+  , layout(target->createDataLayout())
+  , objects()
+  , compiler(objects, llvm::orc::SimpleCompiler(*target))
+  , id(0)
+{
+  // Make symbols in the host process visible to compiled code.
+  llvm::sys::DynamicLibrary::LoadLibraryPermanently(nullptr);
+}
+
+
+// Returns a fresh name for an entry thunk.
+String
+Jit::get_thunk_name()
+{
+  return "__banjo_jit_" + std::to_string(id++);
+}
+
+
+// Returns true if `t` can be passed to or returned from a compiled
+// function.
+static bool
+is_jit_type(Type const& t)
+{
+  return is_integer_type(t) || is_boolean_type(t);
+}
+
+
+// Returns true if the function's signature can be compiled.
+static bool
+is_jit_function(Function_decl const& f)
+{
+  if (!is_jit_type(f.return_type()))
+    return false;
+  for (Decl const& p : f.parameters())
+    if (!is_jit_type(p.type()))
+      return false;
+  return true;
+}
+
+
+// Record a call to `f` with the given arguments. If `f` has become hot,
+// compile it (if needed), call it natively, and store its result in `r`.
+// Returns false if the call must be interpreted.
+bool
+Jit::call(Function_decl const& f, Value_list const& args, Value& r)
+{
+  Jit_entry& ent = funcs[&f];
+  if (ent.failed)
+    return false;
+
+  // Only integer values can be passed, so calls with other arguments
+  // are not counted.
+  for (Value const& v : args) {
+    if (!v.is_integer())
+      return false;
+  }
+
+  if (!ent.thunk) {
+    if (!is_jit_function(f)) {
+      ent.failed = true;
+      return false;
+    }
+    if (++ent.calls < hot_threshold)
+      return false;
+    if (!(ent.thunk = compile(f))) {
+      ent.failed = true;
+      return false;
+    }
+  }
+
+  std::vector<std::int64_t> buf;
+  buf.reserve(args.size());
+  for (Value const& v : args)
+    buf.push_back(v.get_integer());
+
+  r = Integer_value(ent.thunk(buf.data()));
+  return true;
+}
+
+
+// Compile the expression `e` and evaluate it natively, storing the result
+// in `r`. Returns false if the expression cannot be compiled.
+bool
+Jit::evaluate(Expr const& e, Value& r)
+{
+  if (!is_jit_type(e.type()))
+    return false;
+  if (Thunk t = compile(e)) {
+    r = Integer_value(t(nullptr));
+    return true;
+  }
+  return false;
+}
+
+
+// Generate and link a module containing the function `f`, returning its
+// entry thunk. Returns nullptr if the function could not be generated.
+Thunk
+Jit::compile(Function_decl const& f)
+{
+  String name = get_thunk_name();
+  try {
+    std::unique_ptr<llvm::Module> m(gen.gen_thunk(name, f));
+    return link(std::move(m), name);
+  } catch (std::exception&) {
+    gen.reset();
+    return nullptr;
+  }
+}
+
+
+// Generate and link a module that evaluates `e`, returning its entry
+// thunk. Returns nullptr if the expression could not be generated.
+Thunk
+Jit::compile(Expr const& e)
+{
+  String name = get_thunk_name();
+  try {
+    std::unique_ptr<llvm::Module> m(gen.gen_thunk(name, e));
+    return link(std::move(m), name);
+  } catch (std::exception&) {
+    gen.reset();
+    return nullptr;
+  }
+}
+
+
+// Generate and link a module that drives the coroutine `d`, returning
+// its entry thunk (see Generator::gen_thunk). When `escapes` is true,
+// coroutine frames are allocated on the heap rather than the stack.
+// Returns nullptr if the coroutine could not be generated.
+Thunk
+Jit::compile(Coroutine_decl const& d, bool escapes)
+{
+  if (!is_integer_type(d.return_type()))
+    return nullptr;
+  for (Decl const& p : d.parameters())
+    if (!is_jit_type(p.type()))
+      return nullptr;
+
+  String name = get_thunk_name();
+  try {
+    std::unique_ptr<llvm::Module> m(gen.gen_thunk(name, d, escapes));
+    return link(std::move(m), name);
+  } catch (std::exception&) {
+    gen.reset();
+    return nullptr;
+  }
+}
+
+
+// Generate and link a module that calls the function `f` repeatedly,
+// returning its entry thunk (see Generator::gen_driver). Returns nullptr
+// if the function could not be generated.
+Thunk
+Jit::compile_driver(Function_decl const& f)
+{
+  if (!is_jit_function(f))
+    return nullptr;
+
+  String name = get_thunk_name();
+  try {
+    std::unique_ptr<llvm::Module> m(gen.gen_driver(name, f));
+    return link(std::move(m), name);
+  } catch (std::exception&) {
+    gen.reset();
+    return nullptr;
+  }
+}
+
+
+// Compile the module for the host and return the address of the thunk.
+//
+// Every function other than the thunk is given internal linkage so that
+// functions regenerated for different thunks do not collide when linked.
+Thunk
+Jit::link(std::unique_ptr<llvm::Module> m, String const& name)
+{
+  m->setDataLayout(layout);
+  for (llvm::Function& f : *m)
+    if (!f.isDeclaration() && f.getName() != name)
+      f.setLinkage(llvm::Function::InternalLinkage);
+
+  // Resolve symbols against previously compiled modules, and then
+  // against the host process.
+  auto resolver = llvm::orc::createLambdaResolver(
+    [this](std::string const& sym) {
+      if (auto s = compiler.findSymbol(sym, false))
+        return s;
+      return llvm::JITSymbol(nullptr);
+    },
+    [](std::string const& sym) {
+      if (auto addr = llvm::RTDyldMemoryManager::getSymbolAddressInProcess(sym))
+        return llvm::JITSymbol(addr, llvm::JITSymbolFlags::Exported);
+      return llvm::JITSymbol(nullptr);
+    }
+  );
+
+  std::vector<std::unique_ptr<llvm::Module>> ms;
+  ms.push_back(std::move(m));
+  compiler.addModuleSet(std::move(ms),
+                        llvm::make_unique<llvm::SectionMemoryManager>(),
+                        std::move(resolver));
+
+  // Look up the (mangled) name of the thunk.
+  String mangled;
+  llvm::raw_string_ostream os(mangled);
+  llvm::Mangler::getNameWithPrefix(os, name, layout);
+  llvm::JITSymbol sym = compiler.findSymbol(os.str(), true);
+  if (!sym)
+    return nullptr;
+  return reinterpret_cast<Thunk>(static_cast<std::uintptr_t>(sym.getAddress()));
+}
+
+
+} // namespace ll
+
+} // namespace banjo
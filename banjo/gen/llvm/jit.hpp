@@ -0,0 +1,101 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_LLVM_JIT_HPP
+#define BANJO_LLVM_JIT_HPP
+
+// An in-process native compiler for Banjo functions built on the LLVM
+// ORC layers. Functions are lowered by the LLVM generator, compiled for
+// the host, and called directly. This is used by the constant evaluator
+// to run hot functions natively, and by banjo-calc to evaluate input
+// expressions on demand.
+
+#include "generator.hpp"
+
+#include <banjo/value.hpp>
+
+#include <llvm/ExecutionEngine/ExecutionEngine.h>
+#include <llvm/ExecutionEngine/JITSymbol.h>
+#include <llvm/ExecutionEngine/RTDyldMemoryManager.h>
+#include <llvm/ExecutionEngine/SectionMemoryManager.h>
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/ExecutionEngine/Orc/IRCompileLayer.h>
+#include <llvm/ExecutionEngine/Orc/LambdaResolver.h>
+#include <llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h>
+#include <llvm/Target/TargetMachine.h>
+
+#include <memory>
+#include <unordered_map>
+
+
+namespace banjo
+{
+
+namespace ll
+{
+
+// The signature of every compiled entry point. Arguments are passed
+// as an array of 64-bit integers, and the result is returned as a
+// 64-bit integer, regardless of the declared types of the function.
+using Thunk = std::int64_t (*)(std::int64_t const*);
+
+
+// Information about the native compilation of a function.
+struct Jit_entry
+{
+  int   calls = 0;       // The number of interpreted calls
+  bool  failed = false;  // True if the function cannot be compiled
+  Thunk thunk = nullptr; // The compiled entry point
+};
+
+
+// Maps declarations to their compilation state.
+using Jit_map = std::unordered_map<Decl const*, Jit_entry>;
+
+
+// The JIT owns a code generator (and its LLVM context) and a stack of
+// ORC layers that compile and link generated modules in this process.
+//
+// Only functions whose parameter and return types are scalars (integers
+// and booleans) can be compiled. Each compiled function is wrapped in a
+// thunk that unpacks its arguments from an array, so that it can be
+// called without knowing its signature statically.
+struct Jit
+{
+  using Object_layer  = llvm::orc::ObjectLinkingLayer<>;
+  using Compile_layer = llvm::orc::IRCompileLayer<Object_layer>;
+
+  Jit(Context&);
+
+  bool call(Function_decl const&, Value_list const&, Value&);
+  bool evaluate(Expr const&, Value&);
+
+  Thunk compile(Function_decl const&);
+  Thunk compile(Expr const&);
+  Thunk compile(Coroutine_decl const&, bool);
+  Thunk compile_driver(Function_decl const&);
+  Thunk link(std::unique_ptr<llvm::Module>, String const&);
+
+  String get_thunk_name();
+
+  // The number of interpreted calls after which a function is
+  // compiled natively.
+  static constexpr int hot_threshold = 64;
+
+  Context&                             banjo;
+  Generator                            gen;
+  std::unique_ptr<llvm::TargetMachine> target;
+  llvm::DataLayout                     layout;
+  Object_layer                         objects;
+  Compile_layer                        compiler;
+  Jit_map                              funcs;
+  int                                  id;
+};
+
+
+} // namespace ll
+
+} // namespace banjo
+
+
+#endif
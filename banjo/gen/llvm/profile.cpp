@@ -0,0 +1,87 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "profile.hpp"
+
+#include <banjo/error.hpp>
+
+#include <fstream>
+#include <sstream>
+
+
+namespace banjo
+{
+
+namespace ll
+{
+
+// Read the profile file at path. Throws a Profile_error if the file
+// cannot be read or is not a profile.
+//
+// Every size in the header is bounded by the length of the file before
+// anything is allocated, so that a corrupt profile cannot cause huge
+// allocations.
+Profile
+read_profile(String const& path)
+{
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs)
+    throw Profile_error("cannot open profile '{}'", path);
+  ifs.seekg(0, std::ios::end);
+  std::size_t len = ifs.tellg();
+  ifs.seekg(0, std::ios::beg);
+
+  // Read the header.
+  String magic;
+  int version;
+  std::size_t ncounters, nfns;
+  ifs >> magic >> version >> ncounters >> nfns;
+  if (!ifs || magic != "banjo-profile")
+    throw Profile_error("'{}' is not a profile", path);
+  if (version != profile_version)
+    throw Profile_error("unsupported version of profile '{}'", path);
+
+  // Each function takes at least four characters of the header, and
+  // each counter eight bytes of the file.
+  if (nfns > len / 4 || ncounters > len / sizeof(std::uint64_t))
+    throw Profile_error("invalid header in profile '{}'", path);
+
+  // Each index of a counter takes at least two characters.
+  std::vector<std::pair<String, std::vector<std::size_t>>> fns(nfns);
+  for (auto& f : fns) {
+    std::size_t n;
+    ifs >> f.first >> n;
+    if (!ifs || n > len / 2)
+      throw Profile_error("invalid header in profile '{}'", path);
+    f.second.resize(n);
+    for (std::size_t& i : f.second)
+      ifs >> i;
+  }
+  if (!ifs || ifs.get() != '\n')
+    throw Profile_error("invalid header in profile '{}'", path);
+
+  // Read the counters.
+  std::size_t pos = ifs.tellg();
+  if (len - pos != ncounters * sizeof(std::uint64_t))
+    throw Profile_error("invalid length of profile '{}'", path);
+  Counter_list cs(ncounters);
+  ifs.read(reinterpret_cast<char*>(cs.data()), ncounters * sizeof(std::uint64_t));
+  if (!ifs)
+    throw Profile_error("unexpected end of profile '{}'", path);
+
+  Profile prof;
+  for (auto& f : fns) {
+    Counter_list& fcs = prof.fns[f.first];
+    for (std::size_t i : f.second) {
+      if (i >= ncounters)
+        throw Profile_error("invalid counter in profile '{}'", path);
+      fcs.push_back(cs[i]);
+    }
+  }
+  return prof;
+}
+
+
+} // namespace ll
+
+} // namespace banjo
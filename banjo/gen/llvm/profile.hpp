@@ -0,0 +1,78 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_LLVM_PROFILE_HPP
+#define BANJO_LLVM_PROFILE_HPP
+
+// Execution profiles. An instrumented program counts the entries to
+// each function and the evaluations and outcomes of each branch, and
+// writes those counters to a profile file when it exits. The file is
+// read back to guide the optimization of a later translation.
+//
+// The profile file has a text header followed by the counters:
+//
+//    banjo-profile <version>
+//    <number of counters> <number of functions>
+//    <function> <number of counters> <index>...   -- per function
+//    <counters>                                  -- 64-bit, host order
+//
+// The header is generated by the compiler, and the counters are written
+// by the program. The counters of a function are listed in the order
+// in which the generator created them. The number of counters of a
+// function is its checksum: the counts of a function whose number of
+// counters has changed since it was profiled are ignored.
+
+#include <banjo/prelude.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+
+namespace banjo
+{
+
+namespace ll
+{
+
+// The default name of the profile file.
+constexpr char const* profile_file = "banjo.prof";
+
+
+// The version of the profile format.
+constexpr int profile_version = 1;
+
+
+using Counter_list = std::vector<std::uint64_t>;
+
+
+// The counters of each function in a profile, by name.
+struct Profile
+{
+  bool empty() const { return fns.empty(); }
+
+  Counter_list const* counters(String const&) const;
+
+  std::unordered_map<String, Counter_list> fns;
+};
+
+
+// Returns the counters of the function named n, or nullptr if the
+// function was not profiled.
+inline Counter_list const*
+Profile::counters(String const& n) const
+{
+  auto iter = fns.find(n);
+  return iter != fns.end() ? &iter->second : nullptr;
+}
+
+
+Profile read_profile(String const&);
+
+
+} // namespace ll
+
+} // namespace banjo
+
+
+#endif
@@ -164,6 +164,38 @@ copy_initialize(Context& cxt, Type& t, Expr& e)
 }
 
 
+// Try to copy initialize an object or reference of type `t` by an
+// expression `e`, returning nullptr if the initialization is invalid.
+//
+// Array and tuple initialization defer to copy_initialize, and may
+// still throw.
+Expr*
+try_copy_initialize(Context& cxt, Type& t, Expr& e)
+{
+  if (is_reference_type(t))
+    return try_reference_initialize(cxt, cast<Reference_type>(t), e);
+
+  if (is_dependent_type(t)) {
+    if (Expr* c = try_dependent_conversion(cxt, e, t))
+      return &cxt.make_copy_init(t, *c);
+    return nullptr;
+  }
+
+  if (is_array_type(t) || is_tuple_type(t))
+    return &copy_initialize(cxt, t, e);
+
+  if (is_dependent_type(e.type())) {
+    if (Expr* c = try_dependent_conversion(cxt, e, t))
+      return &cxt.make_copy_init(t, *c);
+    return nullptr;
+  }
+
+  if (Expr* c = try_standard_conversion(e, t))
+    return &cxt.make_copy_init(t, *c);
+  return nullptr;
+}
+
+
 //array compared with array or tuple
 Expr&
 array_initialize(Type& t, Expr& e)
@@ -349,7 +381,7 @@ is_reference_compatible(Type const& t1, Type const& t2)
 
 
 // Select an initialization of the refernce type `t1` by an expression
-// `e`.
+// `e`. Returns nullptr if the reference cannot be bound.
 //
 // NOTE: This doesn't currently handle rvalue references (because the
 // language doesn't define them).
@@ -359,8 +391,8 @@ is_reference_compatible(Type const& t1, Type const& t2)
 // these aren't conversions in the standard sense.
 //
 // TODO: Finish implementing me.
-Expr&
-reference_initialize(Context& cxt, Reference_type& t1, Expr& e)
+Expr*
+try_reference_initialize(Context& cxt, Reference_type& t1, Expr& e)
 {
   Type& r1 = t1.non_reference_type();
 
@@ -376,7 +408,7 @@ reference_initialize(Context& cxt, Reference_type& t1, Expr& e)
     // base class conversion in order to explicitly adjust pointer
     // offsets.
     if (is_reference_compatible(r1, r2))
-      return cxt.make_bind_init(t1, e);
+      return &cxt.make_bind_init(t1, e);
   }
 
   // The reference must be a const reference.
@@ -388,6 +420,17 @@ reference_initialize(Context& cxt, Reference_type& t1, Expr& e)
 
   // TODO: Handle bindings to temporaries.
 
+  return nullptr;
+}
+
+
+// Initialize the reference type `t1` by an expression `e`. Throws an
+// exception if the reference cannot be bound.
+Expr&
+reference_initialize(Context& cxt, Reference_type& t1, Expr& e)
+{
+  if (Expr* i = try_reference_initialize(cxt, t1, e))
+    return *i;
   throw Type_error("reference binding");
 }
 
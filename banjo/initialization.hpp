@@ -24,6 +24,11 @@ Expr& tuple_initialize(Type&, Expr&);
 Expr& tuple_array_init(Type&, Expr&);
 Expr& array_tuple_init(Type&, Expr&);
 
+// Non-throwing initialization. These return nullptr when initialization
+// is not possible, and are intended for speculative checks.
+Expr* try_copy_initialize(Context&, Type&, Expr&);
+Expr* try_reference_initialize(Context&, Reference_type&, Expr&);
+
 
 } // namespace banjo
 
@@ -176,7 +176,9 @@ Debug_printer::literal(Boolean_expr const& e)
 void
 Debug_printer::literal(Integer_expr const& e)
 {
-  debug_literal(*this, e);
+  Sexpr sentinel(*this, e);
+  space();
+  value(e.value());
 }
 
 
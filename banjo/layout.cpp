@@ -0,0 +1,233 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "layout.hpp"
+#include "ast-type.hpp"
+#include "ast-decl.hpp"
+#include "ast-def.hpp"
+#include "context.hpp"
+#include "evaluation.hpp"
+
+#include <algorithm>
+
+
+namespace banjo
+{
+
+// The size (and alignment) of pointers and references.
+static constexpr std::size_t pointer_size = sizeof(void*);
+
+
+// The strictest alignment of integers. Wider integers are aligned to
+// this boundary.
+static constexpr std::size_t max_integer_align = 8;
+
+
+// Returns the smallest offset not less than n that is a multiple
+// of the alignment a.
+static inline std::size_t
+align_to(std::size_t n, std::size_t a)
+{
+  return (n + a - 1) / a * a;
+}
+
+
+// Returns the alignment of an integer with the given number of bits.
+// This is the smallest power of two number of bytes that can store the
+// integer, up to the strictest integer alignment.
+static std::size_t
+integer_align(int bits)
+{
+  std::size_t n = 1;
+  while (n * 8 < std::size_t(bits) && n < max_integer_align)
+    n *= 2;
+  return n;
+}
+
+
+// Returns the number of bytes needed to store an integer with the given
+// number of bits, rounded up to its alignment.
+static std::size_t
+integer_size(int bits)
+{
+  return align_to((bits + 7) / 8, integer_align(bits));
+}
+
+
+// Returns the size (and alignment) of a floating point type with the
+// given precision. Precisions other than 16, 32, and 128 bits are
+// represented as 64-bit values (see Generator::get_type).
+static std::size_t
+float_size(int bits)
+{
+  switch (bits) {
+    case 16: return 2;
+    case 32: return 4;
+    case 128: return 16;
+    default: return 8;
+  }
+}
+
+
+static std::size_t
+array_extent(Context& cxt, Expr const& e)
+{
+  Value v = evaluate(cxt, e);
+  return v.get_integer();
+}
+
+
+// -------------------------------------------------------------------------- //
+// Size and alignment
+
+std::size_t
+size_of(Context& cxt, Type const& t)
+{
+  struct fn
+  {
+    Context& cxt;
+    std::size_t operator()(Type const& t)           { banjo_unhandled_case(t); }
+    std::size_t operator()(Boolean_type const& t)   { return 1; }
+    std::size_t operator()(Byte_type const& t)      { return 1; }
+    std::size_t operator()(Integer_type const& t)   { return integer_size(t.precision()); }
+    std::size_t operator()(Float_type const& t)     { return float_size(t.precision()); }
+    std::size_t operator()(Pointer_type const& t)   { return pointer_size; }
+    std::size_t operator()(Reference_type const& t) { return pointer_size; }
+    std::size_t operator()(Qualified_type const& t) { return size_of(cxt, t.type()); }
+    std::size_t operator()(Class_type const& t)     { return get_layout(cxt, cast<Class_decl>(t.declaration())).size(); }
+    std::size_t operator()(Coroutine_type const& t) { banjo_unhandled_case(t); }
+
+    std::size_t operator()(Array_type const& t)
+    {
+      return size_of(cxt, t.type()) * array_extent(cxt, t.extent());
+    }
+
+    // A tuple is laid out like a class whose fields are its elements.
+    std::size_t operator()(Tuple_type const& t)
+    {
+      std::size_t n = 0;
+      for (Type const& t1 : t.element_types())
+        n = align_to(n, align_of(cxt, t1)) + size_of(cxt, t1);
+      return std::max<std::size_t>(align_to(n, align_of(cxt, t)), 1);
+    }
+  };
+  return apply(t, fn{cxt});
+}
+
+
+std::size_t
+align_of(Context& cxt, Type const& t)
+{
+  struct fn
+  {
+    Context& cxt;
+    std::size_t operator()(Type const& t)           { return size_of(cxt, t); }
+    std::size_t operator()(Integer_type const& t)   { return integer_align(t.precision()); }
+    std::size_t operator()(Qualified_type const& t) { return align_of(cxt, t.type()); }
+    std::size_t operator()(Array_type const& t)     { return align_of(cxt, t.type()); }
+    std::size_t operator()(Class_type const& t)     { return get_layout(cxt, cast<Class_decl>(t.declaration())).alignment(); }
+
+    std::size_t operator()(Tuple_type const& t)
+    {
+      std::size_t a = 1;
+      for (Type const& t1 : t.element_types())
+        a = std::max(a, align_of(cxt, t1));
+      return a;
+    }
+  };
+  return apply(t, fn{cxt});
+}
+
+
+// -------------------------------------------------------------------------- //
+// Class layout
+
+Member_layout const&
+Class_layout::member(Decl const& d) const
+{
+  for (Member_layout const& m : mems_)
+    if (m.decl == &d)
+      return m;
+  lingo_unreachable();
+}
+
+
+std::size_t
+Class_layout::padding() const
+{
+  std::size_t n = size_;
+  for (Member_layout const& m : mems_)
+    n -= m.size;
+  return n;
+}
+
+
+// Returns the type of a base or field.
+static Type const&
+member_type(Decl const& d)
+{
+  if (Super_decl const* s = as<Super_decl>(&d))
+    return s->type();
+  return cast<Field_decl>(d).type();
+}
+
+
+// Compute the layout of the class d.
+static Class_layout
+make_layout(Context& cxt, Class_decl const& d)
+{
+  Class_layout l {&d, 0, 1, {}, cxt.reorder_fields()};
+  Class_def const& def = cast<Class_def>(d.definition());
+
+  auto add = [&](Decl const& m) {
+    Type const& t = member_type(m);
+    l.mems_.push_back({&m, 0, 0, size_of(cxt, t), align_of(cxt, t)});
+  };
+  for (Decl const& b : def.base_classes())
+    add(b);
+  std::size_t nbases = l.mems_.size();
+  for (Decl const& f : def.objects())
+    add(f);
+
+  // Sort the fields (but not bases) so that more strictly aligned fields
+  // come first. Since alignments are powers of two, each field then
+  // starts at an offset suitable for it without padding.
+  if (l.reorder_) {
+    auto cmp = [](Member_layout const& a, Member_layout const& b) {
+      if (a.align != b.align)
+        return a.align > b.align;
+      return a.size > b.size;
+    };
+    std::stable_sort(l.mems_.begin() + nbases, l.mems_.end(), cmp);
+  }
+
+  // Assign offsets.
+  std::size_t n = 0;
+  for (std::size_t i = 0; i < l.mems_.size(); ++i) {
+    Member_layout& m = l.mems_[i];
+    m.index = i;
+    m.offset = align_to(n, m.align);
+    n = m.offset + m.size;
+    l.align_ = std::max(l.align_, m.align);
+  }
+
+  // An empty class has size 1 so that distinct objects have distinct
+  // addresses.
+  l.size_ = std::max<std::size_t>(align_to(n, l.align_), 1);
+  return l;
+}
+
+
+// Returns the layout of the class d, computing it if needed.
+Class_layout const&
+get_layout(Context& cxt, Class_decl const& d)
+{
+  Layout_map& map = cxt.layouts();
+  auto iter = map.find(&d);
+  if (iter == map.end())
+    iter = map.emplace(&d, make_layout(cxt, d)).first;
+  return iter->second;
+}
+
+
+} // namespace banjo
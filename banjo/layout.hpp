@@ -0,0 +1,91 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_LAYOUT_HPP
+#define BANJO_LAYOUT_HPP
+
+// The layout of objects in memory. This computes the size and alignment
+// of types and the placement of base class sub-objects and fields within
+// classes. Layouts are computed once per class and cached in the context
+// so that code generation, evaluation, and printing agree on where each
+// member lives.
+
+#include "prelude.hpp"
+#include "language.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+
+namespace banjo
+{
+
+// The placement of a sub-object (a base class or a field) within a
+// class. The index is the position of the sub-object in storage order.
+struct Member_layout
+{
+  Decl const* decl;
+  std::size_t index;
+  std::size_t offset;
+  std::size_t size;
+  std::size_t align;
+};
+
+
+using Member_layout_list = std::vector<Member_layout>;
+
+
+// The layout of a class. Base class sub-objects are placed first, in
+// declaration order, followed by fields. Fields are normally placed in
+// declaration order. When fields are reordered, they are sorted by
+// decreasing alignment (and then size), which minimizes the padding
+// between them.
+//
+// Note that sizes and alignments follow the rules of the LLVM data
+// layout for x86-64: integers are aligned to the smallest power of two
+// number of bytes that holds them, but to no more than 8 bytes, and each
+// floating point type is lowered to an LLVM type of exactly its size.
+// The generated LLVM struct type (with elements in storage order)
+// therefore has the same layout.
+struct Class_layout
+{
+  // Returns the size of the class, including tail padding.
+  std::size_t size() const { return size_; }
+
+  // Returns the alignment of the class.
+  std::size_t alignment() const { return align_; }
+
+  // Returns the sub-objects of the class in storage order.
+  Member_layout_list const& members() const { return mems_; }
+
+  // Returns the layout of the member `d`.
+  Member_layout const& member(Decl const&) const;
+
+  // Returns the number of bytes of padding in the class.
+  std::size_t padding() const;
+
+  // Returns true if fields were reordered.
+  bool is_reordered() const { return reorder_; }
+
+  Class_decl const*  decl_;
+  std::size_t        size_;
+  std::size_t        align_;
+  Member_layout_list mems_;
+  bool               reorder_;
+};
+
+
+// Maps classes to their computed layouts.
+using Layout_map = std::unordered_map<Decl const*, Class_layout>;
+
+
+std::size_t size_of(Context&, Type const&);
+std::size_t align_of(Context&, Type const&);
+
+Class_layout const& get_layout(Context&, Class_decl const&);
+
+
+} // namespace banjo
+
+
+#endif
@@ -11,6 +11,7 @@
 #include <cctype>
 #include <string>
 #include <iostream>
+#include <mutex>
 
 namespace banjo
 {
@@ -27,6 +28,27 @@ void
 Lexer::get()
 {
   buf_.put(cs_.get());
+  ++off_;
+}
+
+
+// Discard the current character.
+void
+Lexer::ignore()
+{
+  cs_.ignore();
+  ++off_;
+}
+
+
+// Returns the source location of the next character, or an invalid
+// location if the text is not a source file.
+Source_location
+Lexer::location() const
+{
+  if (!file_)
+    return {};
+  return cxt_.sources().location(*file_, file_->first + off_);
 }
 
 
@@ -45,6 +67,7 @@ Lexer::scan()
     space();
 
     loc_ = cs_.location();
+    src_ = location();
     switch (lookahead()) {
     case '\0': return eof();
 
@@ -156,10 +179,16 @@ Lexer::scan()
 }
 
 
+// Serializes the emission of diagnostics from concurrent lexers.
+static std::mutex diagnostic_lock;
+
+
 void
 Lexer::error()
 {
+  std::lock_guard<std::mutex> lock(diagnostic_lock);
   lingo::error(loc_, "unrecognized character '{}'", cs_.get());
+  ++off_;
 }
 
 
@@ -167,7 +196,7 @@ void
 Lexer::space()
 {
   while (is_space(cs_.peek()))
-    cs_.ignore();
+    ignore();
 }
 
 
@@ -177,7 +206,7 @@ void
 Lexer::comment()
 {
   while (lookahead() != '\n')
-    cs_.ignore();
+    ignore();
   buf_.clear();
 }
 
@@ -246,10 +275,20 @@ Lexer::integer()
 }
 
 
+// Note that the symbol table is shared by lexers running concurrently
+// on different inputs. Each lexer caches the symbols it has seen, so
+// that the table is only locked the first time a spelling is seen in
+// an input.
+
 Token
 Lexer::on_symbol()
 {
-  Symbol const* sym = symbols().get(buf_.take());
+  String str = buf_.take();
+  Symbol const*& sym = cache_[str];
+  if (!sym) {
+    std::lock_guard<std::mutex> lock(cxt_.symbol_lock());
+    sym = symbols().get(str);
+  }
   return Token(loc_, sym);
 }
 
@@ -260,9 +299,13 @@ Token
 Lexer::on_word()
 {
   String str = buf_.take();
-  Symbol const* sym = symbols().get(str);
-  if (!sym)
-    sym = symbols().put_identifier(identifier_tok, str);
+  Symbol const*& sym = cache_[str];
+  if (!sym) {
+    std::lock_guard<std::mutex> lock(cxt_.symbol_lock());
+    sym = symbols().get(str);
+    if (!sym)
+      sym = symbols().put_identifier(identifier_tok, str);
+  }
   return Token(loc_, sym);
 }
 
@@ -271,8 +314,12 @@ Token
 Lexer::on_integer()
 {
   String str = buf_.take();
-  int n = string_to_int<int>(str, 10);
-  Symbol* sym = symbols().put_integer(integer_tok, str, n);
+  Symbol const*& sym = cache_[str];
+  if (!sym) {
+    int n = string_to_int<int>(str, 10);
+    std::lock_guard<std::mutex> lock(cxt_.symbol_lock());
+    sym = symbols().put_integer(integer_tok, str, n);
+  }
   return Token(loc_, sym);
 }
 
@@ -280,8 +327,10 @@ Lexer::on_integer()
 void
 Lexer::operator()()
 {
-  while (Token tok = scan())
+  while (Token tok = scan()) {
     ts_.put(tok);
+    locs_.push_back(src_);
+  }
 }
 
 
@@ -5,11 +5,15 @@
 #define BANJO_LEXER_HPP
 
 #include "prelude.hpp"
+#include "source.hpp"
 
 #include <lingo/symbol.hpp>
 #include <lingo/token.hpp>
 #include <lingo/character.hpp>
 
+#include <unordered_map>
+#include <vector>
+
 
 namespace banjo
 {
@@ -17,17 +21,28 @@ namespace banjo
 struct Context;
 
 
+// Maps spellings to the symbols previously found for them.
+using Symbol_cache = std::unordered_map<String, Symbol const*>;
+
+
 // The Lexer is a facility that translates sequences of
 // characters into tokens. This is primarily a callback
 // interface for the lexing function for the language.
 //
+// When the characters are the text of a source file, the lexer also
+// records the source location of each token (see source.hpp).
+//
 // TODO: Make this take a context instead of just the symbol
 // table? That would allow us to pass configuration information
 // and diagnostics into the lexer.
 struct Lexer
 {
   Lexer(Context& cxt, Character_stream& cs, Token_stream& ts)
-    : cxt_(cxt), cs_(cs), ts_(ts)
+    : cxt_(cxt), cs_(cs), ts_(ts), file_(nullptr), off_(0)
+  { }
+
+  Lexer(Context& cxt, Source_file const& f, Character_stream& cs, Token_stream& ts)
+    : cxt_(cxt), cs_(cs), ts_(ts), file_(&f), off_(0)
   { }
 
   void operator()();
@@ -43,6 +58,7 @@ struct Lexer
   void error();
   void space();
   void comment();
+  void ignore();
   void letter();
   void digit();
 
@@ -54,6 +70,8 @@ struct Lexer
   char lookahead() const;
   void get();
 
+  Source_location location() const;
+
   Symbol_table& symbols();
 
   Context&          cxt_;
@@ -61,6 +79,17 @@ struct Lexer
   Token_stream&     ts_;
   String_builder    buf_;
   Location          loc_;
+  Symbol_cache      cache_;
+
+  // The file being lexed, if any, and the offset of the next character
+  // in that file.
+  Source_file const* file_;
+  std::uint32_t      off_;
+
+  // The location of the current token, and of each token put into the
+  // token stream.
+  Source_location              src_;
+  std::vector<Source_location> locs_;
 };
 
 
@@ -19,15 +19,15 @@ namespace banjo
 // they can be neither qualified nor template-ids.
 
 
-// Returns the non-empty set of declarations for give (unqualified) id.
-// Throws an exception if no matching declarations are found.
+// Returns the set of declarations for the given (unqualified) id, or
+// an empty list if no declarations are found.
 //
 // Lookup ends as soon as a declaration is found for the given name.
 //
 // TODO: How should we handle non-simple id's like operator-ids
 // and conversion function ids.
 Decl_list
-unqualified_lookup(Context& cxt, Name const& name)
+try_unqualified_lookup(Context& cxt, Name const& name)
 {
   Scope* p = &cxt.current_scope();
   while (p) {
@@ -42,9 +42,33 @@ unqualified_lookup(Context& cxt, Name const& name)
 
     p = p->enclosing_scope();
   }
+  return {};
+}
+
 
-  error(cxt, "no matching declaration for '{}'", name);
-  throw Lookup_error("no matching declaration");
+// Returns the non-empty set of declarations for give (unqualified) id.
+// Throws an exception if no matching declarations are found.
+Decl_list
+unqualified_lookup(Context& cxt, Name const& name)
+{
+  Decl_list result = try_unqualified_lookup(cxt, name);
+  if (result.empty()) {
+    error(cxt, "no matching declaration for '{}'", name);
+    throw Lookup_error("no matching declaration");
+  }
+  return result;
+}
+
+
+// Returns the single declaration associated with the name, or nullptr
+// if the name is undeclared or lookup is ambiguous.
+Decl*
+try_simple_lookup(Context& cxt, Name const& name)
+{
+  Decl_list result = try_unqualified_lookup(cxt, name);
+  if (result.size() != 1)
+    return nullptr;
+  return &result.front();
 }
 
 
@@ -53,27 +77,26 @@ unqualified_lookup(Context& cxt, Name const& name)
 Decl&
 simple_lookup(Context& cxt, Name const& name)
 {
-  Decl_list result = unqualified_lookup(cxt, name);
+  if (Decl* d = try_simple_lookup(cxt, name))
+    return *d;
 
+  // Lookup failed. Determine why.
+  //
   // TODO: Can we find names that are similar to name in order to support 
   // better diagnostics? As in "did you mean...?".
+  Decl_list result = try_unqualified_lookup(cxt, name);
   if (result.empty()) {
     error(cxt, "no matching declaration for '{}'", name);
     throw Lookup_error("no matching declaration");
   }
 
   // TODO: List candidates.
-  if (result.size() > 1) {
-    if(is<Extension_decl>(&result.front())){
-      error(cxt, "lookup of '{}' results in only extension(s)", name);
-      throw Lookup_error("no main class is defined");
-    }
-
-    error(cxt, "lookup of '{}' is ambiguous", name);
-    throw Lookup_error("ambiguous lookup");
+  if(is<Extension_decl>(&result.front())){
+    error(cxt, "lookup of '{}' results in only extension(s)", name);
+    throw Lookup_error("no main class is defined");
   }
-
-  return result.front();
+  error(cxt, "lookup of '{}' is ambiguous", name);
+  throw Lookup_error("ambiguous lookup");
 }
 
 
@@ -206,7 +229,7 @@ requirement_lookup(Context& cxt, Expr& e)
   Type_list t1 = get_operand_types(e); // Yuck.
   for (Expr& e2 : s.exprs) {
     // Expressions of different kinds are not comparable.
-    if (typeid(e) != typeid(e2))
+    if (e.node_kind() != e2.node_kind())
       continue;
 
     // Compare the types of operands.
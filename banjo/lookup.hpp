@@ -16,6 +16,11 @@ Decl& simple_lookup(Context&, Name const&);
 Decl_list unqualified_lookup(Context&, Name const&);
 Decl_list qualified_lookup(Context&, Type&, Name const&);
 
+// Non-throwing lookup. These neither diagnose nor throw on failure, and
+// are intended for speculative checks.
+Decl* try_simple_lookup(Context&, Name const&);
+Decl_list try_unqualified_lookup(Context&, Name const&);
+
 // Decl_list argument_dependent_lookup(Scope&, Expr_list&);
 
 Expr* requirement_lookup(Context& cxt, Expr&);
@@ -5,14 +5,27 @@
 #include "lexer.hpp"
 #include "parser.hpp"
 #include "printer.hpp"
+#include "module.hpp"
 
 #include "gen/llvm/generator.hpp"
+#include "gen/llvm/jit.hpp"
 
 #include <lingo/file.hpp>
 #include <lingo/io.hpp>
 #include <lingo/error.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 
 using namespace lingo;
@@ -20,6 +33,9 @@ using namespace banjo;
 
 
 using File_seq = std::vector<File*>;
+using Path_seq = std::vector<String>;
+using Source_seq = std::vector<Source_file const*>;
+using Location_seq = std::vector<Source_location>;
 
 
 struct Options
@@ -27,6 +43,18 @@ struct Options
   ~Options();
 
   String   emit    = "banjo";
+  String   output  = "";
+  String   server  = "";
+  String   client  = "";
+  String   dir     = "";
+  String   cache   = "";
+  bool     reorder = false;
+  bool     dropped = false;
+  bool     profgen = false;
+  bool     profuse = false;
+  bool     trace   = false;
+  bool     jit     = false;
+  Path_seq paths   = {};
   File_seq inputs  = {};
 };
 
@@ -40,33 +68,179 @@ Options::~Options()
 
 
 
-using Parse_fn = void (*)(int&, int, char**, Options&);
+using Parse_fn = bool (*)(int&, int, char**, Options&);
 using Options_map = std::unordered_map<String, Parse_fn>;
 
 
-void
+// Returns the path resolved against the directory of the options. The
+// compile server resolves the paths of a request against the client's
+// working directory.
+String
+resolve_path(Options const& opts, String const& path)
+{
+  if (opts.dir.empty() || path.empty() || path[0] == '/')
+    return path;
+  return opts.dir + '/' + path;
+}
+
+
+bool
 parse_emit(int& argn, int argc, char* argv[], Options& opts)
 {
-  if (argn == argc) {
-    error("expected one of 'banjo|cxx|llvm' after '-emit'");
-    exit(1);
+  if (argn + 1 == argc) {
+    error("expected one of 'banjo|cxx|llvm|layout|module' after '-emit'");
+    return false;
   }
   opts.emit = argv[++argn];
+  return true;
 }
 
 
-void
+// The output file. This is currently used only for modules.
+bool
+parse_output(int& argn, int argc, char* argv[], Options& opts)
+{
+  if (argn + 1 == argc) {
+    error("expected file name after '-o'");
+    return false;
+  }
+  opts.output = resolve_path(opts, argv[++argn]);
+  return true;
+}
+
+
+// Reorder the fields of classes to minimize padding.
+bool
+parse_reorder_fields(int& argn, int argc, char* argv[], Options& opts)
+{
+  opts.reorder = true;
+  return true;
+}
+
+
+// Generate code incrementally, caching the code generated for each
+// top-level function in the given directory.
+bool
+parse_cache(int& argn, int argc, char* argv[], Options& opts)
+{
+  if (argn + 1 == argc) {
+    error("expected directory after '-cache'");
+    return false;
+  }
+  opts.cache = resolve_path(opts, argv[++argn]);
+  return true;
+}
+
+
+// Report the declarations omitted from generated code because they
+// are unreachable.
+bool
+parse_report_dropped(int& argn, int argc, char* argv[], Options& opts)
+{
+  opts.dropped = true;
+  return true;
+}
+
+
+// Instrument generated code to write an execution profile when the
+// program exits.
+bool
+parse_profile_generate(int& argn, int argc, char* argv[], Options& opts)
+{
+  opts.profgen = true;
+  return true;
+}
+
+
+// Optimize generated code using the profile written by an instrumented
+// program.
+bool
+parse_profile_use(int& argn, int argc, char* argv[], Options& opts)
+{
+  opts.profuse = true;
+  return true;
+}
+
+
+// Instrument generated functions to call the hooks of the tracing
+// runtime on entry and exit. The program must be linked with the
+// banjo-trace library.
+bool
+parse_instrument_functions(int& argn, int argc, char* argv[], Options& opts)
+{
+  opts.trace = true;
+  return true;
+}
+
+
+// Allow hot functions to be compiled and executed natively during
+// constant evaluation.
+bool
+parse_jit(int& argn, int argc, char* argv[], Options& opts)
+{
+  opts.jit = true;
+  return true;
+}
+
+
+// Run as a compile server listening on the given socket.
+bool
+parse_server(int& argn, int argc, char* argv[], Options& opts)
+{
+  if (argn + 1 == argc) {
+    error("expected socket path after '-server'");
+    return false;
+  }
+  opts.server = argv[++argn];
+  return true;
+}
+
+
+// Forward the other arguments to the compile server listening on the
+// given socket.
+bool
+parse_client(int& argn, int argc, char* argv[], Options& opts)
+{
+  if (argn + 1 == argc) {
+    error("expected socket path after '-client'");
+    return false;
+  }
+  opts.client = argv[++argn];
+  return true;
+}
+
+
+// Inputs are read when they are translated.
+bool
 parse_positional(int& argn, int argc, char* argv[], Options& opts)
 {
-  opts.inputs.push_back(new File(argv[argn]));
+  String path = resolve_path(opts, argv[argn]);
+
+  // By default, a module is named for its first input.
+  if (opts.paths.empty() && opts.output.empty())
+    opts.output = path.substr(0, path.rfind('.')) + module_extension;
+  opts.paths.push_back(path);
+  return true;
 }
 
 
-void
+// Parse the command line arguments. Returns false if the arguments
+// are invalid.
+bool
 parse_args(int argc, char* argv[], Options& opts)
 {
   static Options_map all {
-    {"-emit", parse_emit}
+    {"-emit", parse_emit},
+    {"-o", parse_output},
+    {"-cache", parse_cache},
+    {"-reorder-fields", parse_reorder_fields},
+    {"-report-dropped", parse_report_dropped},
+    {"-fprofile-generate", parse_profile_generate},
+    {"-fprofile-use", parse_profile_use},
+    {"-finstrument-functions", parse_instrument_functions},
+    {"-fjit", parse_jit},
+    {"-server", parse_server},
+    {"-client", parse_client}
   };
 
 
@@ -76,58 +250,550 @@ parse_args(int argc, char* argv[], Options& opts)
       auto iter = all.find(arg);
       if (iter == all.end()) {
         error("unknown option '{}'", argv[i]);
-        exit(1);
+        return false;
       }
-      iter->second(i, argc, argv, opts);
+      if (!iter->second(i, argc, argv, opts))
+        return false;
     } else {
-      parse_positional(i, argc, argv, opts);
+      if (!parse_positional(i, argc, argv, opts))
+        return false;
     }
   }
+  return true;
 }
 
 
 
-int
-main(int argc, char* argv[])
+// Lex each input file into its own token stream, and then splice the
+// streams together in input order. Inputs are lexed concurrently by a
+// pool of threads that take the next unlexed input until none remain.
+// Because each input has its own stream, the resulting sequence of
+// tokens does not depend on scheduling. The source location of each
+// token is appended to locs.
+bool
+lex_inputs(Context& cxt, File_seq const& inputs, Source_seq const& srcs,
+           Token_seq& toks, Location_seq& locs)
 {
-  Context cxt;
+  std::vector<Token_stream> streams(inputs.size());
+  std::vector<Location_seq> where(inputs.size());
+  std::atomic<std::size_t> next(0);
+  auto errs = error_count();
+  auto work = [&]() {
+    std::size_t i;
+    while ((i = next++) < inputs.size()) {
+      Character_stream cs(*inputs[i]);
+      Lexer lex(cxt, *srcs[i], cs, streams[i]);
+      lex();
+      where[i] = std::move(lex.locs_);
+    }
+  };
 
-  Options opts;
-  parse_args(argc, argv, opts);
+  // The calling thread is also a worker.
+  std::size_t n = std::thread::hardware_concurrency();
+  n = std::max<std::size_t>(1, std::min(n, inputs.size()));
+  std::vector<std::thread> pool;
+  for (std::size_t i = 1; i < n; ++i)
+    pool.emplace_back(work);
+  work();
+  for (std::thread& t : pool)
+    t.join();
+
+  if (error_count() != errs)
+    return false;
+  for (Token_stream& ts : streams)
+    toks.splice(toks.end(), ts.buf_);
+  for (Location_seq& ls : where)
+    locs.insert(locs.end(), ls.begin(), ls.end());
+  return true;
+}
 
-  // Check post-configuration options.
-  if (opts.inputs.empty()) {
-    error("no input files given");
-    return -1;
-  }
 
-  // Initial file processing.
+// Lex, parse, and elaborate the inputs, returning the translation unit
+// or nullptr if lexical analysis failed.
+Decl*
+translate(Context& cxt, Options& opts)
+{
+  cxt.reorder_fields(opts.reorder);
+  cxt.module_directory(opts.dir);
+
+  // Read the inputs.
+  for (String const& p : opts.paths)
+    opts.inputs.push_back(new File(p));
+
+  // Map the inputs into the source offset space. This must be done
+  // before they are lexed concurrently.
+  Source_seq srcs;
+  for (std::size_t i = 0; i < opts.inputs.size(); ++i) {
+    File const& f = *opts.inputs[i];
+    srcs.push_back(&cxt.sources().add(opts.paths[i], f.begin(), f.end()));
+  }
 
   // Perform character and lexical analysis.
   Token_seq toks;
-  for (File* f : opts.inputs) {
-    Character_stream cs(*f);
-    Token_stream ts;
-    Lexer lex(cxt, cs, ts);
-
-    // Lex tokens.
-    lex();
-    if (error_count())
-      return 1;
-    toks.splice(toks.end(), ts.buf_);
-  }
+  Location_seq locs;
+  if (!lex_inputs(cxt, opts.inputs, srcs, toks, locs))
+    return nullptr;
 
   // Perform syntactic analysis.
   Token_stream ts(toks);
   Parser parse(cxt, ts);
-  Decl& tu = parse();
+  parse.locs = &locs;
+  return &parse();
+}
+
+
+// Print the location and name of each declaration that was dropped
+// from the generated code.
+void
+report_dropped(Context& cxt, ll::Generator const& gen, std::ostream& err)
+{
+  for (Decl const* d : gen.dropped) {
+    err << cxt.sources().position(d->location()) << ": "
+        << "dropped unreachable declaration '" << d->name() << "'\n";
+  }
+  err << gen.dropped.size() << " declaration(s) dropped\n";
+}
+
 
+// Write the requested output for the translation unit to out. Reports
+// are written to err.
+void
+emit(Context& cxt, Options& opts, Decl& tu, std::ostream& out, std::ostream& err)
+{
   if (opts.emit == "banjo") {
-    std::cout << tu << '\n';
+    out << tu << '\n';
   }
   else if (opts.emit == "llvm") {
     ll::Generator gen(cxt);
+    gen.output = &out;
+    gen.cache = opts.cache;
+    gen.instrument = opts.profgen;
+    gen.trace = opts.trace;
+    if (opts.profuse)
+      gen.profile = ll::read_profile(resolve_path(opts, ll::profile_file));
     gen(tu);
+    if (opts.dropped)
+      report_dropped(cxt, gen, err);
+  }
+  else if (opts.emit == "layout") {
+    for (Stmt& s : banjo::cast<Translation_unit>(tu).statements()) {
+      if (Declaration_stmt* d = banjo::as<Declaration_stmt>(&s))
+        if (Class_decl* c = banjo::as<Class_decl>(&d->declaration()))
+          out << get_layout(cxt, *c) << '\n';
+    }
+  }
+  else if (opts.emit == "module") {
+    write_module(cxt, banjo::cast<Translation_unit>(tu), opts.output);
+  }
+}
+
+
+// -------------------------------------------------------------------------- //
+// Compile server
+//
+// With '-server <socket>', banjo-compile listens on a Unix domain socket
+// and services compile requests in a single, long-lived context. Symbols
+// and tokens are initialized once, and a translation unit whose inputs
+// (and imported modules) are unchanged since the previous request for
+// the same inputs is emitted again without being re-elaborated. Loaded
+// modules are retained for the units that refer to them, and are
+// reloaded only when their files change.
+//
+// With '-client <socket>', banjo-compile forwards its other arguments to
+// a server and prints its response.
+//
+// A request is the client's working directory followed by its arguments,
+// each terminated by a null character. The client closes its end of the
+// connection after sending the request. The response is a single status
+// byte followed by the output and diagnostics of the compilation. Paths
+// in the request are resolved against the client's working directory.
+
+
+// Returns a hash of the file contents, or 0 if the file cannot be read.
+std::size_t
+hash_file(String const& path)
+{
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs)
+    return 0;
+  std::stringstream ss;
+  ss << ifs.rdbuf();
+  return std::hash<String>()(ss.str());
+}
+
+
+// A file and the hash of its contents.
+using File_hash = std::pair<String, std::size_t>;
+
+
+// A translation unit retained by the server, and the fingerprints of
+// the files from which it was produced.
+struct Unit_entry
+{
+  Decl*                  tu;
+  bool                   reorder;
+  std::vector<File_hash> inputs;
+  std::vector<File_hash> modules;
+};
+
+
+// Maps a sequence of input paths (joined by null characters) to the
+// unit most recently produced for them.
+using Unit_map = std::unordered_map<String, Unit_entry>;
+
+
+// The state of the compile server.
+struct Server
+{
+  Server(Context& c)
+    : cxt(c)
+  { }
+
+  int compile(Options&, std::ostream&);
+  Decl* translate(Options&);
+  Unit_map::iterator evict(Unit_map::iterator);
+  void drop_stale_units();
+  void drop_stale_modules();
+
+  Context& cxt;
+  Unit_map units;
+};
+
+
+// Returns true if each of the files has the recorded contents.
+static bool
+is_unchanged(std::vector<File_hash> const& files)
+{
+  for (File_hash const& f : files)
+    if (hash_file(f.first) != f.second)
+      return false;
+  return true;
+}
+
+
+// Returns true if the unit was produced from the current contents of
+// its files. The source manager must also hold that text, since the
+// locations of the unit refer to it.
+static bool
+is_current(Context& cxt, Unit_entry const& ent, Options const& opts)
+{
+  if (ent.reorder != opts.reorder)
+    return false;
+  if (!is_unchanged(ent.inputs) || !is_unchanged(ent.modules))
+    return false;
+  for (File_hash const& f : ent.inputs) {
+    Source_file const* src = cxt.sources().find(f.first);
+    if (!src || std::hash<String>()(src->text) != f.second)
+      return false;
+  }
+  return true;
+}
+
+
+// Returns the translation unit for the inputs, reusing the previous
+// result if its files have not changed.
+Decl*
+Server::translate(Options& opts)
+{
+  // Cached layouts depend on whether fields are reordered.
+  if (opts.reorder != cxt.reorder_fields()) {
+    cxt.layouts().clear();
+    cxt.reorder_fields(opts.reorder);
+  }
+
+  String key;
+  for (String const& p : opts.paths)
+    key += p + '\0';
+  auto iter = units.find(key);
+  if (iter != units.end()) {
+    if (is_current(cxt, iter->second, opts))
+      return iter->second.tu;
+    evict(iter);
+  }
+
+  // Discard the units whose inputs have changed, and observe changes to
+  // module files by reloading those modules.
+  drop_stale_units();
+  drop_stale_modules();
+
+  Unit_entry ent;
+  ent.reorder = opts.reorder;
+  for (String const& p : opts.paths)
+    ent.inputs.emplace_back(p, hash_file(p));
+  ent.tu = ::translate(cxt, opts);
+  if (!ent.tu)
+    return nullptr;
+  for (auto const& m : cxt.modules())
+    ent.modules.emplace_back(m.first, hash_file(m.first));
+  return units.emplace(key, std::move(ent)).first->second.tu;
+}
+
+
+// Discard the unit, along with the fingerprints and layouts recorded
+// for its declarations. Returns the iterator following the unit.
+//
+// Note that the nodes of the unit are not freed, since the builder
+// does not record their ownership.
+Unit_map::iterator
+Server::evict(Unit_map::iterator iter)
+{
+  Decl* tu = iter->second.tu;
+  for (Stmt& s : banjo::cast<Translation_unit>(*tu).statements()) {
+    if (Declaration_stmt* d = banjo::as<Declaration_stmt>(&s)) {
+      cxt.fingerprints().erase(&d->declaration());
+      cxt.layouts().erase(&d->declaration());
+    }
+  }
+  return units.erase(iter);
+}
+
+
+// Discard each unit whose inputs have changed since it was translated.
+void
+Server::drop_stale_units()
+{
+  for (auto iter = units.begin(); iter != units.end(); ) {
+    if (is_unchanged(iter->second.inputs))
+      ++iter;
+    else
+      iter = evict(iter);
+  }
+}
+
+
+// Unload each module whose file has changed since it was loaded. The
+// declarations of retained units may refer to a module, so every unit
+// that was translated while the module was loaded is discarded with it.
+void
+Server::drop_stale_modules()
+{
+  Module_map& mods = cxt.modules();
+  for (auto iter = mods.begin(); iter != mods.end(); ) {
+    Module const& m = *iter->second;
+    if (hash_file(iter->first) == std::hash<String>()(String(m.base, m.len))) {
+      ++iter;
+      continue;
+    }
+    for (auto u = units.begin(); u != units.end(); ) {
+      auto const& ms = u->second.modules;
+      auto refers = [&](File_hash const& p) { return p.first == iter->first; };
+      if (std::any_of(ms.begin(), ms.end(), refers))
+        u = evict(u);
+      else
+        ++u;
+    }
+    iter = mods.erase(iter);
+  }
+}
+
+
+// Compile a single request, writing its output to out. Returns the exit
+// status of the request.
+int
+Server::compile(Options& opts, std::ostream& out)
+{
+  if (opts.paths.empty()) {
+    error("no input files given");
+    return 1;
+  }
+  auto errs = error_count();
+  try {
+    Decl* tu = translate(opts);
+    if (!tu)
+      return 1;
+    emit(cxt, opts, *tu, out, out);
+  } catch (std::exception& ex) {
+    out << ex.what() << '\n';
+    return 1;
+  }
+  return error_count() != errs;
+}
+
+
+// Read from the socket until the peer closes its end.
+static String
+read_all(int fd)
+{
+  String buf;
+  char tmp[4096];
+  ssize_t n;
+  while ((n = ::read(fd, tmp, sizeof(tmp))) > 0)
+    buf.append(tmp, n);
+  return buf;
+}
+
+
+static bool
+write_all(int fd, char const* p, std::size_t n)
+{
+  while (n) {
+    ssize_t k = ::write(fd, p, n);
+    if (k <= 0)
+      return false;
+    p += k;
+    n -= k;
+  }
+  return true;
+}
+
+
+// Returns the address of the socket at `path`.
+static sockaddr_un
+socket_address(String const& path)
+{
+  sockaddr_un addr {};
+  addr.sun_family = AF_UNIX;
+  std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  return addr;
+}
+
+
+// Service a single connection.
+static void
+serve_request(Server& srv, int fd)
+{
+  String req = read_all(fd);
+  std::vector<String> args;
+  std::size_t pos = 0;
+  while (pos < req.size()) {
+    std::size_t end = req.find('\0', pos);
+    if (end == String::npos)
+      end = req.size();
+    args.push_back(req.substr(pos, end - pos));
+    pos = end + 1;
+  }
+
+  // Output is written directly to the response. Diagnostics are always
+  // written to std::cerr, so it is redirected while the request is
+  // compiled.
+  std::stringstream out;
+  std::streambuf* cerr = std::cerr.rdbuf(out.rdbuf());
+
+  int status = 1;
+  if (args.empty() || args[0].empty() || args[0][0] != '/') {
+    error("invalid request");
+  } else {
+    // Rebuild an argument vector. The first argument (the working
+    // directory) stands in for the program name.
+    std::vector<char*> argv;
+    for (String& a : args)
+      argv.push_back(&a[0]);
+    try {
+      Options opts;
+      opts.dir = args[0];
+      if (parse_args(argv.size(), argv.data(), opts))
+        status = srv.compile(opts, out);
+    } catch (std::exception& ex) {
+      out << ex.what() << '\n';
+    }
+  }
+
+  std::cerr.rdbuf(cerr);
+
+  char code = status;
+  String res = out.str();
+  write_all(fd, &code, 1);
+  write_all(fd, res.data(), res.size());
+}
+
+
+// Accept and service requests until the process is terminated.
+int
+serve(Context& cxt, String const& path)
+{
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un addr = socket_address(path);
+  ::unlink(path.c_str());
+  if (fd < 0
+      || ::bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0
+      || ::listen(fd, 16) != 0) {
+    error("cannot listen on '{}'", path);
+    return 1;
+  }
+
+  Server srv(cxt);
+  while (true) {
+    int conn = ::accept(fd, nullptr, nullptr);
+    if (conn < 0)
+      continue;
+    serve_request(srv, conn);
+    ::close(conn);
+  }
+}
+
+
+// Send the arguments, other than '-client' and its socket, to the server
+// at `path` and print the response. Returns the status of the remote
+// compilation.
+int
+request(String const& path, int argc, char* argv[])
+{
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un addr = socket_address(path);
+  if (fd < 0 || ::connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+    error("cannot connect to '{}'", path);
+    return 1;
+  }
+
+  char cwd[4096];
+  if (!::getcwd(cwd, sizeof(cwd))) {
+    error("cannot determine the working directory");
+    return 1;
+  }
+  String req = String(cwd) + '\0';
+  for (int i = 1; i < argc; ++i) {
+    if (String(argv[i]) == "-client") {
+      ++i;
+      continue;
+    }
+    req += String(argv[i]) + '\0';
+  }
+  write_all(fd, req.data(), req.size());
+  ::shutdown(fd, SHUT_WR);
+
+  String res = read_all(fd);
+  ::close(fd);
+  if (res.empty()) {
+    error("no response from '{}'", path);
+    return 1;
+  }
+  std::cout << res.substr(1);
+  return res[0];
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  Options opts;
+  if (!parse_args(argc, argv, opts))
+    return 1;
+
+  // Forward the request to a running server.
+  if (!opts.client.empty())
+    return request(opts.client, argc, argv);
+
+  Context cxt;
+
+  // Allow hot functions to be executed natively during constant
+  // evaluation, if requested.
+  std::unique_ptr<ll::Jit> jit;
+  if (opts.jit) {
+    jit.reset(new ll::Jit(cxt));
+    cxt.jit(jit.get());
+  }
+
+  if (!opts.server.empty())
+    return serve(cxt, opts.server);
+
+  // Check post-configuration options.
+  if (opts.paths.empty()) {
+    error("no input files given");
+    return -1;
   }
 
+  Decl* tu = translate(cxt, opts);
+  if (!tu)
+    return 1;
+  emit(cxt, opts, *tu, std::cout, std::cerr);
 }
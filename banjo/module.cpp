@@ -0,0 +1,1914 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "module.hpp"
+#include "ast.hpp"
+#include "context.hpp"
+#include "printer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace banjo
+{
+
+// -------------------------------------------------------------------------- //
+// Module format
+//
+// A module file begins with a fixed-size header:
+//
+//    magic    "BNJM"
+//    version  u32
+//    strings  u32 -- the number of strings
+//    exports  u32 -- the number of exported names
+//    types    u32 -- the number of types
+//    decls    u32 -- the number of declarations
+//
+// The header is followed by four tables of fixed-width entries, which
+// allow records to be found without decoding their predecessors:
+//
+//    string-table  u32 offset per string
+//    export-table  (u32 string, u32 declaration) per export, sorted by name
+//    type-table    u32 offset per type
+//    decl-table    u32 offset per declaration
+//
+// The remainder of the file holds the records. Records are sequences
+// of one-byte tags and LEB128-encoded integers. Strings, types, and
+// declarations are referred to by their index in the corresponding
+// table. Definitions, statements, and expressions are written inline
+// in the record of the declaration (or type) that owns them.
+//
+// Types are structurally unique within a module: two types with the
+// same structure have the same index. Every declaration reachable from
+// an exported declaration, including parameters and local variables,
+// has a record, so that the exported entities are self-contained.
+//
+// Only elaborated terms can be written. Unparsed terms, real literals,
+// extensions and unresolved member references are not supported.
+
+namespace
+{
+
+constexpr char          module_magic[4] = {'B', 'N', 'J', 'M'};
+constexpr std::uint32_t module_version  = 1;
+constexpr std::size_t   header_size     = 24;
+
+
+enum Name_tag
+{
+  simple_id_tag = 1,
+  operator_id_tag,
+  placeholder_id_tag,
+};
+
+
+enum Type_tag
+{
+  void_type_tag = 1,
+  boolean_type_tag,
+  byte_type_tag,
+  integer_type_tag,
+  float_type_tag,
+  function_type_tag,
+  qualified_type_tag,
+  pointer_type_tag,
+  reference_type_tag,
+  array_type_tag,
+  tuple_type_tag,
+  slice_type_tag,
+  pack_type_tag,
+  class_type_tag,
+  typename_type_tag,
+  type_type_tag,
+};
+
+
+enum Expr_tag
+{
+  boolean_expr_tag = 1,
+  small_integer_expr_tag,
+  integer_expr_tag,
+  tuple_expr_tag,
+  object_expr_tag,
+  value_expr_tag,
+  function_expr_tag,
+  overload_expr_tag,
+  field_expr_tag,
+  method_expr_tag,
+  add_expr_tag,
+  sub_expr_tag,
+  mul_expr_tag,
+  div_expr_tag,
+  rem_expr_tag,
+  neg_expr_tag,
+  pos_expr_tag,
+  bit_and_expr_tag,
+  bit_or_expr_tag,
+  bit_xor_expr_tag,
+  bit_lsh_expr_tag,
+  bit_rsh_expr_tag,
+  bit_not_expr_tag,
+  eq_expr_tag,
+  ne_expr_tag,
+  lt_expr_tag,
+  gt_expr_tag,
+  le_expr_tag,
+  ge_expr_tag,
+  cmp_expr_tag,
+  and_expr_tag,
+  or_expr_tag,
+  not_expr_tag,
+  assign_expr_tag,
+  call_expr_tag,
+  value_conv_tag,
+  qualification_conv_tag,
+  boolean_conv_tag,
+  integer_conv_tag,
+  float_conv_tag,
+  numeric_conv_tag,
+  dependent_conv_tag,
+  ellipsis_conv_tag,
+  trivial_init_tag,
+  copy_init_tag,
+  bind_init_tag,
+  direct_init_tag,
+  aggregate_init_tag,
+  check_expr_tag,
+  requires_expr_tag,
+  synthetic_expr_tag,
+};
+
+
+enum Stmt_tag
+{
+  empty_stmt_tag = 1,
+  compound_stmt_tag,
+  expression_stmt_tag,
+  declaration_stmt_tag,
+  return_stmt_tag,
+  yield_stmt_tag,
+  if_then_stmt_tag,
+  if_else_stmt_tag,
+  while_stmt_tag,
+  break_stmt_tag,
+  continue_stmt_tag,
+};
+
+
+enum Decl_tag
+{
+  variable_decl_tag = 1,
+  constant_decl_tag,
+  function_decl_tag,
+  method_decl_tag,
+  coroutine_decl_tag,
+  class_decl_tag,
+  field_decl_tag,
+  super_decl_tag,
+  concept_decl_tag,
+  template_decl_tag,
+  object_parm_tag,
+  value_parm_tag,
+  type_parm_tag,
+};
+
+
+enum Def_tag
+{
+  empty_def_tag = 1,
+  defaulted_def_tag,
+  deleted_def_tag,
+  expression_def_tag,
+  function_def_tag,
+  class_def_tag,
+  concept_def_tag,
+};
+
+
+enum Req_tag
+{
+  type_req_tag = 1,
+  syntactic_req_tag,
+  basic_req_tag,
+  conversion_req_tag,
+};
+
+
+enum Term_tag
+{
+  type_term_tag = 1,
+  expr_term_tag,
+  decl_term_tag,
+};
+
+
+// Returns the spelling of `n` used to index exported declarations.
+String
+export_key(Name const& n)
+{
+  std::stringstream ss;
+  ss << n;
+  return ss.str();
+}
+
+
+// Throws an exception indicating that `t` cannot be written to a module.
+template<typename T>
+[[noreturn]] void
+unsupported(T const& t)
+{
+  std::stringstream ss;
+  ss << t;
+  throw Module_error("cannot write '{}' to a module", ss.str());
+}
+
+
+void
+put_u32(std::string& out, std::uint32_t n)
+{
+  for (int i = 0; i < 4; ++i)
+    out.push_back(char((n >> (8 * i)) & 0xff));
+}
+
+
+std::uint32_t
+get_u32(char const* p)
+{
+  std::uint32_t n = 0;
+  for (int i = 0; i < 4; ++i)
+    n |= std::uint32_t(static_cast<unsigned char>(p[i])) << (8 * i);
+  return n;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Encoding
+
+// Encodes the entities exported by a translation unit.
+struct Encoder
+{
+  Encoder(Context& c)
+    : cxt(c), out(nullptr)
+  { }
+
+  void exports(Translation_unit const&);
+  std::string image();
+
+  // Primitives
+  void byte(int n) { out->push_back(char(n)); }
+  void varint(std::uint64_t);
+  void svarint(std::int64_t);
+
+  // References
+  std::size_t string_id(String const&);
+  std::size_t type_id(Type const&);
+  std::size_t decl_id(Decl const&);
+
+  void string(String const& s) { varint(string_id(s)); }
+  void type(Type const& t)     { varint(type_id(t)); }
+  void decl(Decl const& d)     { varint(decl_id(d)); }
+  void types(Type_list const&);
+  void decls(Decl_list const&);
+
+  // Inline terms
+  void name(Name const&);
+  void expr(Expr const&);
+  void exprs(Expr_list const&);
+  void stmt(Stmt const&);
+  void stmts(Stmt_list const&);
+  void def(Def const&);
+  void req(Req const&);
+  void term(Term const&);
+
+  // Records
+  void type_record(Type const&);
+  void decl_record(Decl const&);
+
+  Context&     cxt;
+  std::string* out; // The current record
+
+  std::vector<String>                          strs;
+  std::unordered_map<String, std::size_t>      str_ids;
+  std::vector<std::string>                     type_recs;
+  std::unordered_map<std::string, std::size_t> type_keys;
+  std::unordered_map<Type const*, std::size_t> type_ids;
+  std::vector<std::string>                     decl_recs;
+  std::vector<Decl const*>                     decl_queue;
+  std::unordered_map<Decl const*, std::size_t> decl_ids;
+  std::vector<std::pair<String, std::size_t>>  exps;
+};
+
+
+void
+Encoder::varint(std::uint64_t n)
+{
+  while (n >= 0x80) {
+    byte(int(n & 0x7f) | 0x80);
+    n >>= 7;
+  }
+  byte(int(n));
+}
+
+
+// Signed integers are zig-zag encoded so that small negative values
+// are also short.
+void
+Encoder::svarint(std::int64_t n)
+{
+  varint((std::uint64_t(n) << 1) ^ std::uint64_t(n >> 63));
+}
+
+
+std::size_t
+Encoder::string_id(String const& s)
+{
+  auto iter = str_ids.find(s);
+  if (iter != str_ids.end())
+    return iter->second;
+  std::size_t id = strs.size();
+  strs.push_back(s);
+  str_ids.emplace(s, id);
+  return id;
+}
+
+
+// Returns the index of the type `t`. The type is encoded into its own
+// record, and records with the same encoding share an index. Because
+// the components of a type are encoded by index, this makes types
+// structurally unique.
+std::size_t
+Encoder::type_id(Type const& t)
+{
+  auto iter = type_ids.find(&t);
+  if (iter != type_ids.end())
+    return iter->second;
+
+  std::string rec;
+  std::string* prev = out;
+  out = &rec;
+  type_record(t);
+  out = prev;
+
+  auto key = type_keys.find(rec);
+  std::size_t id;
+  if (key != type_keys.end()) {
+    id = key->second;
+  } else {
+    id = type_recs.size();
+    type_keys.emplace(rec, id);
+    type_recs.push_back(std::move(rec));
+  }
+  type_ids.emplace(&t, id);
+  return id;
+}
+
+
+// Returns the index of the declaration `d`. The record of a newly
+// referenced declaration is written after the current record.
+std::size_t
+Encoder::decl_id(Decl const& d)
+{
+  auto iter = decl_ids.find(&d);
+  if (iter != decl_ids.end())
+    return iter->second;
+  std::size_t id = decl_queue.size();
+  decl_queue.push_back(&d);
+  decl_ids.emplace(&d, id);
+  return id;
+}
+
+
+void
+Encoder::types(Type_list const& ts)
+{
+  varint(ts.size());
+  for (Type const& t : ts)
+    type(t);
+}
+
+
+void
+Encoder::decls(Decl_list const& ds)
+{
+  varint(ds.size());
+  for (Decl const& d : ds)
+    decl(d);
+}
+
+
+void
+Encoder::name(Name const& n)
+{
+  struct fn
+  {
+    Encoder& e;
+    void operator()(Name const& n)           { unsupported(n); }
+    void operator()(Simple_id const& n)      { e.byte(simple_id_tag); e.string(n.symbol().spelling()); }
+    void operator()(Operator_id const& n)    { e.byte(operator_id_tag); e.varint(n.kind()); }
+    void operator()(Placeholder_id const& n) { e.byte(placeholder_id_tag); }
+  };
+  apply(n, fn{*this});
+}
+
+
+void
+Encoder::type_record(Type const& t)
+{
+  struct fn
+  {
+    Encoder& e;
+    void operator()(Type const& t)           { unsupported(t); }
+    void operator()(Void_type const& t)      { e.byte(void_type_tag); }
+    void operator()(Boolean_type const& t)   { e.byte(boolean_type_tag); }
+    void operator()(Byte_type const& t)      { e.byte(byte_type_tag); }
+    void operator()(Type_type const& t)      { e.byte(type_type_tag); }
+
+    void operator()(Integer_type const& t)
+    {
+      e.byte(integer_type_tag);
+      e.byte(t.sign());
+      e.varint(t.precision());
+    }
+
+    void operator()(Float_type const& t)
+    {
+      e.byte(float_type_tag);
+      e.varint(t.precision());
+    }
+
+    void operator()(Function_type const& t)
+    {
+      e.byte(function_type_tag);
+      e.types(t.parameter_types());
+      e.type(t.return_type());
+    }
+
+    void operator()(Qualified_type const& t)
+    {
+      e.byte(qualified_type_tag);
+      e.type(t.type());
+      e.varint(t.qualifiers());
+    }
+
+    void operator()(Pointer_type const& t)   { e.byte(pointer_type_tag); e.type(t.type()); }
+    void operator()(Reference_type const& t) { e.byte(reference_type_tag); e.type(t.type()); }
+    void operator()(Slice_type const& t)     { e.byte(slice_type_tag); e.type(t.type()); }
+    void operator()(Pack_type const& t)      { e.byte(pack_type_tag); e.type(t.type()); }
+
+    void operator()(Array_type const& t)
+    {
+      e.byte(array_type_tag);
+      e.type(t.type());
+      e.expr(t.extent());
+    }
+
+    void operator()(Tuple_type const& t)
+    {
+      e.byte(tuple_type_tag);
+      e.types(t.element_types());
+    }
+
+    void operator()(Class_type const& t)     { e.byte(class_type_tag); e.decl(t.declaration()); }
+    void operator()(Coroutine_type const& t) { unsupported(t); }
+    void operator()(Typename_type const& t)  { e.byte(typename_type_tag); e.decl(t.declaration()); }
+  };
+  apply(t, fn{*this});
+}
+
+
+void
+Encoder::exprs(Expr_list const& es)
+{
+  varint(es.size());
+  for (Expr const& x : es)
+    expr(x);
+}
+
+
+// Every expression is written as its tag and type, followed by its
+// operands. The type of an untyped expression is written as 0, and
+// other types are offset by 1.
+void
+Encoder::expr(Expr const& e)
+{
+  struct fn
+  {
+    Encoder& e;
+
+    void head(Expr_tag k, Expr const& x)
+    {
+      e.byte(k);
+      e.varint(x.is_typed() ? e.type_id(x.type()) + 1 : 0);
+    }
+
+    void unary(Expr_tag k, Unary_expr const& x)
+    {
+      head(k, x);
+      e.expr(x.operand());
+    }
+
+    void binary(Expr_tag k, Binary_expr const& x)
+    {
+      head(k, x);
+      e.expr(x.left());
+      e.expr(x.right());
+    }
+
+    void conv(Expr_tag k, Conv const& x)
+    {
+      head(k, x);
+      e.expr(x.source());
+    }
+
+    void operator()(Expr const& x) { unsupported(x); }
+
+    void operator()(Boolean_expr const& x)
+    {
+      head(boolean_expr_tag, x);
+      e.byte(x.value());
+    }
+
+    void operator()(Integer_expr const& x)
+    {
+      if (x.is_small()) {
+        head(small_integer_expr_tag, x);
+        e.svarint(x.small_value());
+      } else {
+        head(integer_expr_tag, x);
+        bool sgn = cast<Integer_type>(x.type()).is_signed();
+        e.string(x.value().impl().toString(10, sgn));
+      }
+    }
+
+    void operator()(Tuple_expr const& x)
+    {
+      head(tuple_expr_tag, x);
+      e.exprs(x.elements());
+    }
+
+    void operator()(Object_expr const& x)   { head(object_expr_tag, x); e.decl(x.declaration()); }
+    void operator()(Value_expr const& x)    { head(value_expr_tag, x); e.decl(x.declaration()); }
+    void operator()(Function_expr const& x) { head(function_expr_tag, x); e.decl(x.declaration()); }
+
+    void operator()(Overload_expr const& x)
+    {
+      head(overload_expr_tag, x);
+      e.name(x.id());
+      e.decls(x.declarations());
+    }
+
+    void operator()(Field_expr const& x)
+    {
+      head(field_expr_tag, x);
+      e.expr(x.object());
+      e.decl(x.declaration());
+    }
+
+    void operator()(Method_expr const& x)
+    {
+      head(method_expr_tag, x);
+      e.expr(x.object());
+      e.decl(x.declaration());
+    }
+
+    void operator()(Add_expr const& x)     { binary(add_expr_tag, x); }
+    void operator()(Sub_expr const& x)     { binary(sub_expr_tag, x); }
+    void operator()(Mul_expr const& x)     { binary(mul_expr_tag, x); }
+    void operator()(Div_expr const& x)     { binary(div_expr_tag, x); }
+    void operator()(Rem_expr const& x)     { binary(rem_expr_tag, x); }
+    void operator()(Neg_expr const& x)     { unary(neg_expr_tag, x); }
+    void operator()(Pos_expr const& x)     { unary(pos_expr_tag, x); }
+    void operator()(Bit_and_expr const& x) { binary(bit_and_expr_tag, x); }
+    void operator()(Bit_or_expr const& x)  { binary(bit_or_expr_tag, x); }
+    void operator()(Bit_xor_expr const& x) { binary(bit_xor_expr_tag, x); }
+    void operator()(Bit_lsh_expr const& x) { binary(bit_lsh_expr_tag, x); }
+    void operator()(Bit_rsh_expr const& x) { binary(bit_rsh_expr_tag, x); }
+    void operator()(Bit_not_expr const& x) { unary(bit_not_expr_tag, x); }
+    void operator()(Eq_expr const& x)      { binary(eq_expr_tag, x); }
+    void operator()(Ne_expr const& x)      { binary(ne_expr_tag, x); }
+    void operator()(Lt_expr const& x)      { binary(lt_expr_tag, x); }
+    void operator()(Gt_expr const& x)      { binary(gt_expr_tag, x); }
+    void operator()(Le_expr const& x)      { binary(le_expr_tag, x); }
+    void operator()(Ge_expr const& x)      { binary(ge_expr_tag, x); }
+    void operator()(Cmp_expr const& x)     { binary(cmp_expr_tag, x); }
+    void operator()(And_expr const& x)     { binary(and_expr_tag, x); }
+    void operator()(Or_expr const& x)      { binary(or_expr_tag, x); }
+    void operator()(Not_expr const& x)     { unary(not_expr_tag, x); }
+    void operator()(Assign_expr const& x)  { binary(assign_expr_tag, x); }
+
+    void operator()(Call_expr const& x)
+    {
+      head(call_expr_tag, x);
+      e.expr(x.function());
+      e.exprs(x.arguments());
+    }
+
+    void operator()(Value_conv const& x)         { conv(value_conv_tag, x); }
+    void operator()(Qualification_conv const& x) { conv(qualification_conv_tag, x); }
+    void operator()(Boolean_conv const& x)       { conv(boolean_conv_tag, x); }
+    void operator()(Integer_conv const& x)       { conv(integer_conv_tag, x); }
+    void operator()(Float_conv const& x)         { conv(float_conv_tag, x); }
+    void operator()(Numeric_conv const& x)       { conv(numeric_conv_tag, x); }
+    void operator()(Dependent_conv const& x)     { conv(dependent_conv_tag, x); }
+    void operator()(Ellipsis_conv const& x)      { conv(ellipsis_conv_tag, x); }
+
+    void operator()(Trivial_init const& x) { head(trivial_init_tag, x); }
+
+    void operator()(Copy_init const& x)
+    {
+      head(copy_init_tag, x);
+      e.expr(x.expression());
+    }
+
+    void operator()(Bind_init const& x)
+    {
+      head(bind_init_tag, x);
+      e.expr(x.expression());
+    }
+
+    void operator()(Direct_init const& x)
+    {
+      head(direct_init_tag, x);
+      e.decl(x.consructor());
+      e.exprs(x.arguments());
+    }
+
+    void operator()(Aggregate_init const& x)
+    {
+      head(aggregate_init_tag, x);
+      e.exprs(x.initializers());
+    }
+
+    void operator()(Check_expr const& x)
+    {
+      head(check_expr_tag, x);
+      e.decl(x.declaration());
+      e.varint(x.arguments().size());
+      for (Term const& t : x.arguments())
+        e.term(t);
+    }
+
+    void operator()(Requires_expr const& x)
+    {
+      head(requires_expr_tag, x);
+      e.decls(x.template_parameters());
+      e.decls(x.normal_parameters());
+      e.varint(x.requirements().size());
+      for (Req const& r : x.requirements())
+        e.req(r);
+    }
+
+    void operator()(Synthetic_expr const& x)
+    {
+      head(synthetic_expr_tag, x);
+      e.decl(x.declaration());
+    }
+  };
+  apply(e, fn{*this});
+}
+
+
+void
+Encoder::stmts(Stmt_list const& ss)
+{
+  varint(ss.size());
+  for (Stmt const& s : ss)
+    stmt(s);
+}
+
+
+void
+Encoder::stmt(Stmt const& s)
+{
+  struct fn
+  {
+    Encoder& e;
+    void operator()(Stmt const& s)          { unsupported(s); }
+    void operator()(Empty_stmt const& s)    { e.byte(empty_stmt_tag); }
+    void operator()(Break_stmt const& s)    { e.byte(break_stmt_tag); }
+    void operator()(Continue_stmt const& s) { e.byte(continue_stmt_tag); }
+
+    void operator()(Compound_stmt const& s)
+    {
+      e.byte(compound_stmt_tag);
+      e.stmts(s.statements());
+    }
+
+    void operator()(Expression_stmt const& s)
+    {
+      e.byte(expression_stmt_tag);
+      e.expr(s.expression());
+    }
+
+    void operator()(Declaration_stmt const& s)
+    {
+      e.byte(declaration_stmt_tag);
+      e.decl(s.declaration());
+    }
+
+    void operator()(Return_stmt const& s)
+    {
+      e.byte(return_stmt_tag);
+      e.expr(s.expression());
+    }
+
+    void operator()(Yield_stmt const& s)
+    {
+      e.byte(yield_stmt_tag);
+      e.expr(s.expression());
+    }
+
+    void operator()(If_then_stmt const& s)
+    {
+      e.byte(if_then_stmt_tag);
+      e.expr(s.condition());
+      e.stmt(s.true_branch());
+    }
+
+    void operator()(If_else_stmt const& s)
+    {
+      e.byte(if_else_stmt_tag);
+      e.expr(s.condition());
+      e.stmt(s.true_branch());
+      e.stmt(s.false_branch());
+    }
+
+    void operator()(While_stmt const& s)
+    {
+      e.byte(while_stmt_tag);
+      e.expr(s.condition());
+      e.stmt(s.body());
+    }
+  };
+  apply(s, fn{*this});
+}
+
+
+void
+Encoder::def(Def const& d)
+{
+  struct fn
+  {
+    Encoder& e;
+    void operator()(Def const& d)           { unsupported(d); }
+    void operator()(Empty_def const& d)     { e.byte(empty_def_tag); }
+    void operator()(Defaulted_def const& d) { e.byte(defaulted_def_tag); }
+    void operator()(Deleted_def const& d)   { e.byte(deleted_def_tag); }
+
+    void operator()(Expression_def const& d)
+    {
+      e.byte(expression_def_tag);
+      e.expr(d.expression());
+    }
+
+    void operator()(Function_def const& d)
+    {
+      e.byte(function_def_tag);
+      e.stmt(d.statement());
+    }
+
+    void operator()(Class_def const& d)
+    {
+      e.byte(class_def_tag);
+      e.stmts(d.statements());
+      e.decls(d.base_classes());
+      e.decls(d.objects());
+    }
+
+    void operator()(Concept_def const& d)
+    {
+      e.byte(concept_def_tag);
+      e.varint(d.requirements().size());
+      for (Req const& r : d.requirements())
+        e.req(r);
+    }
+  };
+  apply(d, fn{*this});
+}
+
+
+void
+Encoder::req(Req const& r)
+{
+  struct fn
+  {
+    Encoder& e;
+    void operator()(Req const& r) { unsupported(r); }
+
+    void operator()(Type_req const& r)
+    {
+      e.byte(type_req_tag);
+      e.type(r.type());
+    }
+
+    void operator()(Syntactic_req const& r)
+    {
+      e.byte(syntactic_req_tag);
+      e.expr(r.expression());
+    }
+
+    void operator()(Basic_req const& r)
+    {
+      e.byte(basic_req_tag);
+      e.expr(r.expression());
+      e.type(r.type());
+    }
+
+    void operator()(Conversion_req const& r)
+    {
+      e.byte(conversion_req_tag);
+      e.expr(r.expression());
+      e.type(r.type());
+    }
+  };
+  apply(r, fn{*this});
+}
+
+
+void
+Encoder::term(Term const& t)
+{
+  if (Type const* ty = as<Type>(&t)) {
+    byte(type_term_tag);
+    type(*ty);
+  } else if (Expr const* e = as<Expr>(&t)) {
+    byte(expr_term_tag);
+    expr(*e);
+  } else if (Decl const* d = as<Decl>(&t)) {
+    byte(decl_term_tag);
+    decl(*d);
+  } else {
+    unsupported(t);
+  }
+}
+
+
+// Every declaration is written as its tag, name, and specifiers,
+// followed by the data specific to the kind of declaration.
+void
+Encoder::decl_record(Decl const& d)
+{
+  struct fn
+  {
+    Encoder& e;
+
+    void head(Decl_tag k, Decl const& d)
+    {
+      e.byte(k);
+      e.name(d.name());
+      e.varint(d.specifiers());
+    }
+
+    void index(Index ix)
+    {
+      e.varint(ix.depth());
+      e.varint(ix.offset());
+    }
+
+    void operator()(Decl const& d) { unsupported(d); }
+
+    void operator()(Variable_decl const& d)
+    {
+      head(variable_decl_tag, d);
+      e.type(d.type());
+      e.def(d.initializer());
+    }
+
+    void operator()(Constant_decl const& d)
+    {
+      head(constant_decl_tag, d);
+      e.type(d.type());
+      e.def(d.initializer());
+    }
+
+    void operator()(Field_decl const& d)
+    {
+      head(field_decl_tag, d);
+      e.type(d.type());
+      e.varint(d.index());
+      e.def(d.initializer());
+    }
+
+    void operator()(Super_decl const& d)
+    {
+      head(super_decl_tag, d);
+      e.type(d.type());
+      e.def(d.initializer());
+    }
+
+    void function(Decl_tag k, Function_decl const& d)
+    {
+      head(k, d);
+      e.type(d.type());
+      e.decls(d.parameters());
+      e.def(d.definition());
+    }
+
+    void operator()(Function_decl const& d) { function(function_decl_tag, d); }
+    void operator()(Method_decl const& d)   { function(method_decl_tag, d); }
+
+    void operator()(Coroutine_decl const& d)
+    {
+      head(coroutine_decl_tag, d);
+      e.type(d.return_type());
+      e.decls(d.parameters());
+      e.def(d.definition());
+    }
+
+    void operator()(Class_decl const& d)
+    {
+      head(class_decl_tag, d);
+      e.type(d.kind());
+      e.def(d.definition());
+    }
+
+    void operator()(Concept_decl const& d)
+    {
+      if (!d.is_defined())
+        unsupported(d);
+      head(concept_decl_tag, d);
+      e.decls(d.parameters());
+      e.def(d.definition());
+    }
+
+    void operator()(Template_decl const& d)
+    {
+      head(template_decl_tag, d);
+      e.decls(d.parameters());
+      e.decl(d.parameterized_declaration());
+    }
+
+    void operator()(Object_parm const& d)
+    {
+      head(object_parm_tag, d);
+      index(d.index());
+      e.type(d.type());
+      e.byte(d.has_default_arguement());
+      if (d.has_default_arguement())
+        e.expr(d.default_argument());
+    }
+
+    void operator()(Value_parm const& d)
+    {
+      head(value_parm_tag, d);
+      index(d.index());
+      e.type(d.type());
+      e.byte(d.has_default_arguement());
+      if (d.has_default_arguement())
+        e.expr(d.default_argument());
+    }
+
+    void operator()(Type_parm const& d)
+    {
+      head(type_parm_tag, d);
+      index(d.index());
+      e.byte(d.has_default_arguement());
+      if (d.has_default_arguement())
+        e.type(d.default_argument());
+    }
+  };
+  apply(d, fn{*this});
+}
+
+
+// Assign indexes to the exported declarations of the translation unit
+// and write the records of every declaration they reach.
+void
+Encoder::exports(Translation_unit const& tu)
+{
+  for (Stmt const& s : tu.statements()) {
+    if (Declaration_stmt const* ds = as<Declaration_stmt>(&s)) {
+      Decl const& d = ds->declaration();
+      if (d.specifiers() & export_spec)
+        exps.emplace_back(export_key(d.name()), decl_id(d));
+    }
+  }
+
+  // Writing a record may reference new declarations, which are
+  // appended to the queue.
+  for (std::size_t i = 0; i < decl_queue.size(); ++i) {
+    std::string rec;
+    out = &rec;
+    decl_record(*decl_queue[i]);
+    decl_recs.push_back(std::move(rec));
+  }
+  out = nullptr;
+
+  // Sort the export index so that names can be found by binary search.
+  std::stable_sort(exps.begin(), exps.end(), [](auto const& a, auto const& b) {
+    return a.first < b.first;
+  });
+}
+
+
+// Returns the module file image.
+std::string
+Encoder::image()
+{
+  // Intern the export names before sizing the string table.
+  std::vector<std::size_t> keys;
+  for (auto const& x : exps)
+    keys.push_back(string_id(x.first));
+
+  std::string file(module_magic, 4);
+  put_u32(file, module_version);
+  put_u32(file, strs.size());
+  put_u32(file, exps.size());
+  put_u32(file, type_recs.size());
+  put_u32(file, decl_recs.size());
+
+  // Encode the string records.
+  std::string str_recs;
+  out = &str_recs;
+  std::vector<std::size_t> str_offs;
+  for (String const& s : strs) {
+    str_offs.push_back(str_recs.size());
+    varint(s.size());
+    str_recs += s;
+  }
+  out = nullptr;
+
+  // Write the tables. Offsets are relative to the start of the file.
+  std::size_t off = header_size
+                  + 4 * strs.size()
+                  + 8 * exps.size()
+                  + 4 * type_recs.size()
+                  + 4 * decl_recs.size();
+  for (std::size_t n : str_offs)
+    put_u32(file, off + n);
+  off += str_recs.size();
+  for (std::size_t i = 0; i < exps.size(); ++i) {
+    put_u32(file, keys[i]);
+    put_u32(file, exps[i].second);
+  }
+  for (std::string const& r : type_recs) {
+    put_u32(file, off);
+    off += r.size();
+  }
+  for (std::string const& r : decl_recs) {
+    put_u32(file, off);
+    off += r.size();
+  }
+
+  // Write the records.
+  file += str_recs;
+  for (std::string const& r : type_recs)
+    file += r;
+  for (std::string const& r : decl_recs)
+    file += r;
+  return file;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Decoding
+
+// Decodes a record within a mapped module.
+struct Decoder
+{
+  Decoder(Module& m, std::size_t off);
+
+  // Primitives
+  int           byte();
+  std::uint64_t varint();
+  std::int64_t  svarint();
+
+  // References
+  String string()  { return mod.get_string(varint()); }
+  Type&  type()    { return mod.get_type(varint()); }
+  Decl&  decl()    { return mod.get_declaration(varint()); }
+  Type_list types();
+  Decl_list decls();
+
+  // Inline terms
+  Name&     name();
+  Expr&     expr();
+  Expr_list exprs();
+  Stmt&     stmt();
+  Stmt_list stmts();
+  Def&      def();
+  Req&      req();
+  Req_list  reqs();
+  Term&     term();
+
+  // Records
+  Type& type_record();
+  Decl& decl_record(std::size_t);
+
+  Module&     mod;
+  Context&    cxt;
+  char const* p;
+  char const* end;
+};
+
+
+// Offsets are validated when the module is loaded, but are checked
+// again here since the decoder is the only reader of records.
+Decoder::Decoder(Module& m, std::size_t off)
+  : mod(m), cxt(m.cxt), p(m.base), end(m.base + m.len)
+{
+  if (off > m.len)
+    throw Module_error("invalid offset in module '{}'", m.path());
+  p += off;
+}
+
+
+int
+Decoder::byte()
+{
+  if (p == end)
+    throw Module_error("unexpected end of module '{}'", mod.path());
+  return static_cast<unsigned char>(*p++);
+}
+
+
+std::uint64_t
+Decoder::varint()
+{
+  std::uint64_t n = 0;
+  int shift = 0;
+  while (true) {
+    int b = byte();
+    n |= std::uint64_t(b & 0x7f) << shift;
+    if (!(b & 0x80))
+      return n;
+    shift += 7;
+    if (shift >= 64)
+      throw Module_error("invalid integer in module '{}'", mod.path());
+  }
+}
+
+
+std::int64_t
+Decoder::svarint()
+{
+  std::uint64_t n = varint();
+  return std::int64_t(n >> 1) ^ -std::int64_t(n & 1);
+}
+
+
+Type_list
+Decoder::types()
+{
+  Type_list ts;
+  for (std::size_t n = varint(); n != 0; --n)
+    ts.push_back(type());
+  return ts;
+}
+
+
+Decl_list
+Decoder::decls()
+{
+  Decl_list ds;
+  for (std::size_t n = varint(); n != 0; --n)
+    ds.push_back(decl());
+  return ds;
+}
+
+
+Name&
+Decoder::name()
+{
+  switch (byte()) {
+    case simple_id_tag:
+      return cxt.get_id(string());
+    case operator_id_tag:
+      return cxt.get_id(Operator_kind(varint()));
+    case placeholder_id_tag:
+      return cxt.get_id();
+  }
+  throw Module_error("invalid name in module '{}'", mod.path());
+}
+
+
+Type&
+Decoder::type_record()
+{
+  switch (byte()) {
+    case void_type_tag:
+      return cxt.get_void_type();
+    case boolean_type_tag:
+      return cxt.get_bool_type();
+    case byte_type_tag:
+      return cxt.get_byte_type();
+    case type_type_tag:
+      return cxt.get_type_type();
+    case integer_type_tag: {
+      bool s = byte();
+      return cxt.get_integer_type(s, int(varint()));
+    }
+    case float_type_tag:
+      return cxt.make<Float_type>(int(varint()));
+    case function_type_tag: {
+      Type_list ts = types();
+      return cxt.get_function_type(ts, type());
+    }
+    case qualified_type_tag: {
+      Type& t = type();
+      return cxt.get_qualified_type(t, Qualifier_set(varint()));
+    }
+    case pointer_type_tag:
+      return cxt.get_pointer_type(type());
+    case reference_type_tag:
+      return cxt.get_reference_type(type());
+    case slice_type_tag:
+      return cxt.get_slice_type(type());
+    case pack_type_tag:
+      return cxt.get_pack_type(type());
+    case array_type_tag: {
+      Type& t = type();
+      return cxt.get_array_type(t, expr());
+    }
+    case tuple_type_tag:
+      return cxt.get_tuple_type(types());
+    case class_type_tag:
+      return cxt.get_class_type(cast<Type_decl>(decl()));
+    case typename_type_tag:
+      return cxt.get_typename_type(cast<Type_decl>(decl()));
+  }
+  throw Module_error("invalid type in module '{}'", mod.path());
+}
+
+
+Expr_list
+Decoder::exprs()
+{
+  Expr_list es;
+  for (std::size_t n = varint(); n != 0; --n)
+    es.push_back(expr());
+  return es;
+}
+
+
+Expr&
+Decoder::expr()
+{
+  int k = byte();
+  std::size_t ty = varint();
+  if (ty == 0) {
+    // Only overload sets are untyped.
+    if (k != overload_expr_tag)
+      throw Module_error("untyped expression in module '{}'", mod.path());
+    Name& n = name();
+    return cxt.make<Overload_expr>(n, decls());
+  }
+  Type& t = mod.get_type(ty - 1);
+
+  // Helper functions.
+  auto unary = [&](auto* node) -> Expr& {
+    using T = std::remove_pointer_t<decltype(node)>;
+    Expr& e = expr();
+    return cxt.make<T>(t, e);
+  };
+  auto binary = [&](auto* node) -> Expr& {
+    using T = std::remove_pointer_t<decltype(node)>;
+    Expr& e1 = expr();
+    Expr& e2 = expr();
+    return cxt.make<T>(t, e1, e2);
+  };
+
+  switch (k) {
+    case boolean_expr_tag:
+      return cxt.make<Boolean_expr>(t, bool(byte()));
+    case small_integer_expr_tag:
+      return cxt.get_integer(t, svarint());
+    case integer_expr_tag: {
+      Integer n = string();
+      return cxt.get_integer(t, n);
+    }
+    case tuple_expr_tag:
+      return cxt.make<Tuple_expr>(t, exprs());
+
+    case object_expr_tag: {
+      Decl& d = decl();
+      return cxt.make<Object_expr>(t, d.name(), d);
+    }
+    case value_expr_tag: {
+      Decl& d = decl();
+      return cxt.make<Value_expr>(t, d.name(), d);
+    }
+    case function_expr_tag: {
+      Decl& d = decl();
+      return cxt.make<Function_expr>(t, d.name(), d);
+    }
+    case overload_expr_tag: {
+      Name& n = name();
+      return cxt.make<Overload_expr>(n, decls());
+    }
+    case field_expr_tag: {
+      Expr& e = expr();
+      Decl& d = decl();
+      return cxt.make<Field_expr>(t, e, d.name(), d);
+    }
+    case method_expr_tag: {
+      Expr& e = expr();
+      Decl& d = decl();
+      return cxt.make<Method_expr>(t, e, d.name(), d);
+    }
+
+    case add_expr_tag:     return binary((Add_expr*)nullptr);
+    case sub_expr_tag:     return binary((Sub_expr*)nullptr);
+    case mul_expr_tag:     return binary((Mul_expr*)nullptr);
+    case div_expr_tag:     return binary((Div_expr*)nullptr);
+    case rem_expr_tag:     return binary((Rem_expr*)nullptr);
+    case neg_expr_tag:     return unary((Neg_expr*)nullptr);
+    case pos_expr_tag:     return unary((Pos_expr*)nullptr);
+    case bit_and_expr_tag: return binary((Bit_and_expr*)nullptr);
+    case bit_or_expr_tag:  return binary((Bit_or_expr*)nullptr);
+    case bit_xor_expr_tag: return binary((Bit_xor_expr*)nullptr);
+    case bit_lsh_expr_tag: return binary((Bit_lsh_expr*)nullptr);
+    case bit_rsh_expr_tag: return binary((Bit_rsh_expr*)nullptr);
+    case bit_not_expr_tag: return unary((Bit_not_expr*)nullptr);
+    case eq_expr_tag:      return binary((Eq_expr*)nullptr);
+    case ne_expr_tag:      return binary((Ne_expr*)nullptr);
+    case lt_expr_tag:      return binary((Lt_expr*)nullptr);
+    case gt_expr_tag:      return binary((Gt_expr*)nullptr);
+    case le_expr_tag:      return binary((Le_expr*)nullptr);
+    case ge_expr_tag:      return binary((Ge_expr*)nullptr);
+    case cmp_expr_tag:     return binary((Cmp_expr*)nullptr);
+    case and_expr_tag:     return binary((And_expr*)nullptr);
+    case or_expr_tag:      return binary((Or_expr*)nullptr);
+    case not_expr_tag:     return unary((Not_expr*)nullptr);
+    case assign_expr_tag:  return binary((Assign_expr*)nullptr);
+
+    case call_expr_tag: {
+      Expr& f = expr();
+      return cxt.make<Call_expr>(t, f, exprs());
+    }
+
+    case value_conv_tag:         return unary((Value_conv*)nullptr);
+    case qualification_conv_tag: return unary((Qualification_conv*)nullptr);
+    case boolean_conv_tag:       return unary((Boolean_conv*)nullptr);
+    case integer_conv_tag:       return unary((Integer_conv*)nullptr);
+    case float_conv_tag:         return unary((Float_conv*)nullptr);
+    case numeric_conv_tag:       return unary((Numeric_conv*)nullptr);
+    case dependent_conv_tag:     return unary((Dependent_conv*)nullptr);
+    case ellipsis_conv_tag:      return unary((Ellipsis_conv*)nullptr);
+
+    case trivial_init_tag:
+      return cxt.make<Trivial_init>(t);
+    case copy_init_tag:
+      return unary((Copy_init*)nullptr);
+    case bind_init_tag:
+      return unary((Bind_init*)nullptr);
+    case direct_init_tag: {
+      Decl& d = decl();
+      return cxt.make<Direct_init>(t, d, exprs());
+    }
+    case aggregate_init_tag:
+      return cxt.make<Aggregate_init>(t, exprs());
+
+    case check_expr_tag: {
+      Decl& d = decl();
+      Term_list ts;
+      for (std::size_t n = varint(); n != 0; --n)
+        ts.push_back(term());
+      return cxt.make<Check_expr>(t, d, ts);
+    }
+    case requires_expr_tag: {
+      Decl_list tps = decls();
+      Decl_list ps = decls();
+      return cxt.make<Requires_expr>(t, tps, ps, reqs());
+    }
+    case synthetic_expr_tag:
+      return cxt.make<Synthetic_expr>(t, decl());
+  }
+  throw Module_error("invalid expression in module '{}'", mod.path());
+}
+
+
+Stmt_list
+Decoder::stmts()
+{
+  Stmt_list ss;
+  for (std::size_t n = varint(); n != 0; --n)
+    ss.push_back(stmt());
+  return ss;
+}
+
+
+Stmt&
+Decoder::stmt()
+{
+  switch (byte()) {
+    case empty_stmt_tag:
+      return cxt.make_empty_statement();
+    case break_stmt_tag:
+      return cxt.make_break_statement();
+    case continue_stmt_tag:
+      return cxt.make_continue_statement();
+    case compound_stmt_tag:
+      return cxt.make_compound_statement(stmts());
+    case expression_stmt_tag:
+      return cxt.make_expression_statement(expr());
+    case declaration_stmt_tag:
+      return cxt.make_declaration_statement(decl());
+    case return_stmt_tag:
+      return cxt.make_return_statement(expr());
+    case yield_stmt_tag:
+      return cxt.make_yield_statement(expr());
+    case if_then_stmt_tag: {
+      Expr& e = expr();
+      return cxt.make_if_statement(e, stmt());
+    }
+    case if_else_stmt_tag: {
+      Expr& e = expr();
+      Stmt& s1 = stmt();
+      return cxt.make_if_statement(e, s1, stmt());
+    }
+    case while_stmt_tag: {
+      Expr& e = expr();
+      return cxt.make_while_statement(e, stmt());
+    }
+  }
+  throw Module_error("invalid statement in module '{}'", mod.path());
+}
+
+
+Def&
+Decoder::def()
+{
+  switch (byte()) {
+    case empty_def_tag:
+      return cxt.make_empty_definition();
+    case defaulted_def_tag:
+      return cxt.make_defaulted_definition();
+    case deleted_def_tag:
+      return cxt.make_deleted_definition();
+    case expression_def_tag:
+      return cxt.make_expression_definition(expr());
+    case function_def_tag:
+      return cxt.make_function_definition(stmt());
+    case class_def_tag: {
+      Class_def& d = cxt.make_class_definition(stmts());
+      d.bases_ = decls();
+      d.objs_ = decls();
+      return d;
+    }
+    case concept_def_tag:
+      return cxt.make_concept_definition(reqs());
+  }
+  throw Module_error("invalid definition in module '{}'", mod.path());
+}
+
+
+Req_list
+Decoder::reqs()
+{
+  Req_list rs;
+  for (std::size_t n = varint(); n != 0; --n)
+    rs.push_back(req());
+  return rs;
+}
+
+
+Req&
+Decoder::req()
+{
+  switch (byte()) {
+    case type_req_tag:
+      return cxt.make<Type_req>(type());
+    case syntactic_req_tag:
+      return cxt.make_syntactic_requirement(expr());
+    case basic_req_tag: {
+      Expr& e = expr();
+      return cxt.make_basic_requirement(e, type());
+    }
+    case conversion_req_tag: {
+      Expr& e = expr();
+      return cxt.make_conversion_requirement(e, type());
+    }
+  }
+  throw Module_error("invalid requirement in module '{}'", mod.path());
+}
+
+
+Term&
+Decoder::term()
+{
+  switch (byte()) {
+    case type_term_tag:
+      return type();
+    case expr_term_tag:
+      return expr();
+    case decl_term_tag:
+      return decl();
+  }
+  throw Module_error("invalid term in module '{}'", mod.path());
+}
+
+
+// Bind the members of an imported class in its scope so that they
+// can be found by qualified lookup.
+void
+bind_members(Context& cxt, Class_decl& c)
+{
+  Scope& s = cxt.saved_scope(c);
+  for (Stmt& st : cast<Class_def>(c.definition()).statements()) {
+    Declaration_stmt* ds = as<Declaration_stmt>(&st);
+    if (!ds || is<Super_decl>(&ds->declaration()))
+      continue;
+    Decl& d = ds->declaration();
+    if (Overload_set* ovl = s.lookup(d.name()))
+      ovl->insert(d);
+    else
+      s.bind(d);
+  }
+}
+
+
+// Decode the declaration with index `id`.
+//
+// The declaration is recorded in the module before its definition is
+// decoded, so that recursive references within the definition (e.g.,
+// a recursive call) resolve to the same declaration.
+Decl&
+Decoder::decl_record(std::size_t id)
+{
+  Decl*& slot = mod.decls[id];
+  int k = byte();
+  Name& n = name();
+  Specifier_set spec = Specifier_set(varint());
+
+  // Sets the slot and the specifiers of a new declaration.
+  auto finish = [&](Decl& d) -> Decl& {
+    d.spec_ = spec;
+    slot = &d;
+    return d;
+  };
+
+  auto index = [&]() {
+    int depth = varint();
+    int offset = varint();
+    return Index {depth, offset};
+  };
+
+  switch (k) {
+    case variable_decl_tag:
+    case constant_decl_tag:
+    case field_decl_tag:
+    case super_decl_tag: {
+      Type& t = type();
+      int ix = k == field_decl_tag ? varint() : 0;
+      Def& placeholder = cxt.make_empty_definition();
+      Decl* d;
+      if (k == variable_decl_tag)
+        d = &cxt.make<Variable_decl>(n, t, placeholder);
+      else if (k == constant_decl_tag)
+        d = &cxt.make<Constant_decl>(n, t, placeholder);
+      else if (k == field_decl_tag)
+        d = &cxt.make<Field_decl>(n, t, placeholder);
+      else
+        d = &cxt.make<Super_decl>(n, t, placeholder);
+      finish(*d);
+      Def& init = def();
+      if (Field_decl* f = as<Field_decl>(d)) {
+        f->index_ = ix;
+        f->def_ = &init;
+      } else if (Variable_decl* v = as<Variable_decl>(d)) {
+        v->def_ = &init;
+      } else if (Constant_decl* c = as<Constant_decl>(d)) {
+        c->def_ = &init;
+      } else {
+        cast<Super_decl>(d)->def_ = &init;
+      }
+      return *d;
+    }
+
+    case function_decl_tag:
+    case method_decl_tag: {
+      Type& t = type();
+      Decl_list ps = decls();
+      Def& placeholder = cxt.make_empty_definition();
+      Function_decl* d;
+      if (k == function_decl_tag)
+        d = &cxt.make<Function_decl>(n, t, ps, placeholder);
+      else
+        d = &cxt.make<Method_decl>(n, t, ps, placeholder);
+      d->constr_ = nullptr;
+      finish(*d);
+      d->def_ = &def();
+      return *d;
+    }
+
+    case coroutine_decl_tag: {
+      Type& t = type();
+      Decl_list ps = decls();
+      Def& placeholder = cxt.make_empty_definition();
+      Coroutine_decl& d = cxt.make<Coroutine_decl>(n, t, ps, placeholder);
+      finish(d);
+      d.def_ = &def();
+      return d;
+    }
+
+    case class_decl_tag: {
+      Type& t = type();
+      Def& placeholder = cxt.make_empty_definition();
+      Class_decl& d = cxt.make<Class_decl>(n, t, placeholder);
+      finish(d);
+      d.def_ = &def();
+      bind_members(cxt, d);
+      return d;
+    }
+
+    case concept_decl_tag: {
+      Decl_list ps = decls();
+      Concept_decl& d = cxt.make<Concept_decl>(n, ps);
+      finish(d);
+      d.def = &def();
+      return d;
+    }
+
+    case template_decl_tag: {
+      Decl_list ps = decls();
+      Decl& pattern = decl();
+
+      // The pattern may refer to the template, in which case the
+      // template was decoded while decoding the pattern.
+      if (slot)
+        return *slot;
+      return finish(cxt.make<Template_decl>(ps, pattern));
+    }
+
+    case object_parm_tag: {
+      Index ix = index();
+      Type& t = type();
+      Object_parm& d = cxt.make<Object_parm>(n, t);
+      d.index() = ix;
+      finish(d);
+      if (byte())
+        d.init_ = &expr();
+      return d;
+    }
+
+    case value_parm_tag: {
+      Index ix = index();
+      Type& t = type();
+      Value_parm& d = cxt.make<Value_parm>(ix, n, t);
+      finish(d);
+      if (byte())
+        d.init_ = &expr();
+      return d;
+    }
+
+    case type_parm_tag: {
+      Index ix = index();
+      Type_parm& d = cxt.make<Type_parm>(ix, n);
+      finish(d);
+      if (byte())
+        d.def = &type();
+      return d;
+    }
+  }
+  throw Module_error("invalid declaration in module '{}'", mod.path());
+}
+
+
+// Returns the location of the table entries of the module.
+inline char const*
+string_table(Module const& m)
+{
+  return m.base + header_size;
+}
+
+
+inline char const*
+export_table(Module const& m)
+{
+  return string_table(m) + 4 * m.nstrings;
+}
+
+
+inline char const*
+type_table(Module const& m)
+{
+  return export_table(m) + 8 * m.nexports;
+}
+
+
+inline char const*
+decl_table(Module const& m)
+{
+  return type_table(m) + 4 * m.ntypes;
+}
+
+
+// Compares the string with index `id` to `s`. The string is bounded
+// by the end of the module.
+int
+compare_string(Module const& m, std::size_t id, String const& s)
+{
+  if (id >= m.nstrings)
+    throw Module_error("invalid string in module '{}'", m.path());
+  Decoder dec(const_cast<Module&>(m), get_u32(string_table(m) + 4 * id));
+  std::size_t n = dec.varint();
+  if (std::size_t(dec.end - dec.p) < n)
+    throw Module_error("unexpected end of module '{}'", m.path());
+  if (int cmp = std::memcmp(dec.p, s.data(), std::min(n, s.size())))
+    return cmp;
+  return n < s.size() ? -1 : n > s.size();
+}
+
+
+// Returns true if every entry of the tables of `m` refers to a record
+// within the module or to an entry of another table.
+bool
+check_tables(Module const& m)
+{
+  // The tables must fit in the file.
+  std::size_t records = header_size
+                      + 4 * m.nstrings
+                      + 8 * m.nexports
+                      + 4 * m.ntypes
+                      + 4 * m.ndecls;
+  if (records > m.len)
+    return false;
+
+  auto check_offsets = [&](char const* tab, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+      std::size_t off = get_u32(tab + 4 * i);
+      if (off < records || off >= m.len)
+        return false;
+    }
+    return true;
+  };
+  if (!check_offsets(string_table(m), m.nstrings)
+      || !check_offsets(type_table(m), m.ntypes)
+      || !check_offsets(decl_table(m), m.ndecls))
+    return false;
+
+  char const* tab = export_table(m);
+  for (std::size_t i = 0; i < m.nexports; ++i) {
+    char const* ent = tab + 8 * i;
+    if (get_u32(ent) >= m.nstrings || get_u32(ent + 4) >= m.ndecls)
+      return false;
+  }
+  return true;
+}
+
+
+} // namespace
+
+
+// -------------------------------------------------------------------------- //
+// Modules
+
+// Map the module file at `path` into memory and validate its header
+// and tables.
+Module::Module(Context& c, String const& path)
+  : cxt(c), file(path), base(nullptr), len(0)
+{
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw Module_error("cannot open module '{}'", path);
+  struct stat st;
+  if (::fstat(fd, &st) < 0 || std::size_t(st.st_size) < header_size) {
+    ::close(fd);
+    throw Module_error("invalid module '{}'", path);
+  }
+  len = st.st_size;
+  void* p = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED)
+    throw Module_error("cannot map module '{}'", path);
+  base = static_cast<char const*>(p);
+
+  if (std::memcmp(base, module_magic, 4) || get_u32(base + 4) != module_version) {
+    ::munmap(const_cast<char*>(base), len);
+    throw Module_error("invalid module '{}'", path);
+  }
+  nstrings = get_u32(base + 8);
+  nexports = get_u32(base + 12);
+  ntypes = get_u32(base + 16);
+  ndecls = get_u32(base + 20);
+  if (!check_tables(*this)) {
+    ::munmap(const_cast<char*>(base), len);
+    throw Module_error("invalid module '{}'", path);
+  }
+
+  types.assign(ntypes, nullptr);
+  decls.assign(ndecls, nullptr);
+}
+
+
+Module::~Module()
+{
+  ::munmap(const_cast<char*>(base), len);
+}
+
+
+String
+Module::get_string(std::size_t id) const
+{
+  if (id >= nstrings)
+    throw Module_error("invalid string in module '{}'", file);
+  Decoder dec(const_cast<Module&>(*this), get_u32(string_table(*this) + 4 * id));
+  std::size_t n = dec.varint();
+  if (std::size_t(dec.end - dec.p) < n)
+    throw Module_error("unexpected end of module '{}'", file);
+  return String(dec.p, n);
+}
+
+
+// Returns the type with index `id`, decoding it on first use.
+Type&
+Module::get_type(std::size_t id)
+{
+  if (id >= ntypes)
+    throw Module_error("invalid type in module '{}'", file);
+  if (!types[id]) {
+    Decoder dec(*this, get_u32(type_table(*this) + 4 * id));
+    types[id] = &dec.type_record();
+  }
+  return *types[id];
+}
+
+
+// Returns the declaration with index `id`, decoding it on first use.
+Decl&
+Module::get_declaration(std::size_t id)
+{
+  if (id >= ndecls)
+    throw Module_error("invalid declaration in module '{}'", file);
+  if (!decls[id]) {
+    Decoder dec(*this, get_u32(decl_table(*this) + 4 * id));
+    return dec.decl_record(id);
+  }
+  return *decls[id];
+}
+
+
+// Search the export index for declarations of `n`. Only the matching
+// declarations (and the entities they refer to) are decoded.
+Decl_list
+Module::lookup(Name const& n)
+{
+  String key = export_key(n);
+  char const* tab = export_table(*this);
+  std::size_t lo = 0;
+  std::size_t hi = nexports;
+  while (lo < hi) {
+    std::size_t mid = lo + (hi - lo) / 2;
+    if (compare_string(*this, get_u32(tab + 8 * mid), key) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  Decl_list ds;
+  for (; lo < nexports; ++lo) {
+    char const* ent = tab + 8 * lo;
+    if (compare_string(*this, get_u32(ent), key) != 0)
+      break;
+    ds.push_back(get_declaration(get_u32(ent + 4)));
+  }
+  return ds;
+}
+
+
+// Write the declarations exported from `tu` to the module file at
+// `path`. Throws a Module_error if an exported declaration refers to
+// a term that cannot be written.
+void
+write_module(Context& cxt, Translation_unit const& tu, String const& path)
+{
+  Encoder enc(cxt);
+  enc.exports(tu);
+  std::string image = enc.image();
+
+  // Write to a temporary file and rename it, so that processes that
+  // have mapped a previous version of the module are not affected.
+  String tmp = path + ".tmp";
+  std::ofstream os(tmp, std::ios::binary);
+  os.write(image.data(), image.size());
+  os.close();
+  if (!os || std::rename(tmp.c_str(), path.c_str()) != 0)
+    throw Module_error("cannot write module '{}'", path);
+}
+
+
+// Returns the module at `path`, loading it if it has not already been
+// loaded.
+Module&
+load_module(Context& cxt, String const& path)
+{
+  Module_map& map = cxt.modules();
+  auto iter = map.find(path);
+  if (iter == map.end())
+    iter = map.emplace(path, std::make_unique<Module>(cxt, path)).first;
+  return *iter->second;
+}
+
+
+} // namespace banjo
@@ -0,0 +1,82 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_MODULE_HPP
+#define BANJO_MODULE_HPP
+
+// Precompiled modules. The declarations exported by a translation unit
+// are written, after elaboration, to a compact binary file. Importing
+// that file maps it into memory and deserializes declarations only when
+// their names are first looked up, so the cost of an import is roughly
+// proportional to the number of names used, not the size of the module.
+
+#include "prelude.hpp"
+#include "language.hpp"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+
+namespace banjo
+{
+
+// The extension of precompiled module files.
+constexpr char const* module_extension = ".bmod";
+
+
+// A precompiled module mapped into memory.
+//
+// The module contains a sorted index of exported names, a table of
+// (structurally unique) types, and a table of declarations. Types and
+// declarations are decoded on first use and memoized, so that every
+// reference to an entity within the module yields the same object.
+struct Module
+{
+  Module(Context&, String const&);
+  ~Module();
+
+  // Non-copyable
+  Module(Module const&) = delete;
+  Module& operator=(Module const&) = delete;
+
+  // Returns the path of the module file.
+  String const& path() const { return file; }
+
+  // Returns the number of exported declarations.
+  std::size_t exports() const { return nexports; }
+
+  // Returns the exported declarations of `n`, deserializing them as
+  // needed. The list is empty if no such declarations are exported.
+  Decl_list lookup(Name const&);
+
+  // Deserialization. These are used by the decoder.
+  Type& get_type(std::size_t);
+  Decl& get_declaration(std::size_t);
+  String get_string(std::size_t) const;
+
+  Context&             cxt;
+  String               file;
+  char const*          base;     // The mapped file
+  std::size_t          len;      // The length of the mapping
+  std::size_t          nstrings;
+  std::size_t          nexports;
+  std::size_t          ntypes;
+  std::size_t          ndecls;
+  std::vector<Type*>   types;    // Decoded types
+  std::vector<Decl*>   decls;    // Decoded declarations
+};
+
+
+// Maps module paths to loaded modules.
+using Module_map = std::unordered_map<String, std::unique_ptr<Module>>;
+
+
+void    write_module(Context&, Translation_unit const&, String const&);
+Module& load_module(Context&, String const&);
+
+
+} // namespace banjo
+
+
+#endif
@@ -149,7 +149,7 @@ Parser::member_statement()
       return declaration_statement();
     
     default:
-      error("expected member-statement");
+      error(cxt, "expected member-statement");
       throw Syntax_error();
   }
 }
@@ -169,36 +169,49 @@ Parser::parameter_specifier_seq()
 //      function-declaration
 //      type-declaration
 //      concept-declaration
+//
+// The declaration is located at its first token.
 Decl&
 Parser::declaration()
 {
+  Source_location loc = location();
+
   // Parse and cache the specifier sequences.
   specifier_seq();
 
+  Decl* d;
   switch (lookahead()) {
     case var_tok:
-      return variable_declaration();
+      d = &variable_declaration();
+      break;
 
     case const_tok:
-      return constant_declaration();
+      d = &constant_declaration();
+      break;
     
     case def_tok:
-      return function_declaration();
+      d = &function_declaration();
+      break;
 
     case coroutine_tok:
-      return coroutine_declaration();
+      d = &coroutine_declaration();
+      break;
 
     case class_tok:
-      return class_declaration();
+      d = &class_declaration();
+      break;
 
     case concept_tok:
       lingo_unreachable();
     case super_tok:
-      return super_declaration();
-    default:
+      d = &super_declaration();
       break;
+    default:
+      throw Syntax_error("invalid declaration");
   }
-  throw Syntax_error("invalid declaration");
+  if (!d->loc)
+    d->loc = loc;
+  return *d;
 }
 
 
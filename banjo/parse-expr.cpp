@@ -22,142 +22,38 @@ Parser::expression()
 }
 
 
-// Parse a logical-or expression.
+// -------------------------------------------------------------------------- //
+// Binary expressions
+//
+// Binary expressions are parsed by precedence climbing over a table of
+// binary operators keyed on the token kind. The table gives the precedence
+// of each operator and the semantic action used to build it. All binary
+// operators are left associative.
 //
 //    logical-or-expression:
 //      logical-and-expression
 //      logical-or-expression '||' logical-and-expression
-Expr&
-Parser::logical_or_expression()
-{
-  Expr* e1 = &logical_and_expression();
-  while (true) {
-    if (Token tok = match_if(bar_bar_tok)) {
-      Expr& e2 = logical_and_expression();
-      e1 = &on_logical_or_expression(tok, *e1, e2);
-    } else {
-      break;
-    }
-  }
-  return *e1;
-}
-
-
-// Parse a logical-and expression.
 //
 //    logical-and-expression:
 //      inclusive-or-expression
 //      logical-and-expression '&&' inclusive-or-expression
 //
-Expr&
-Parser::logical_and_expression()
-{
-  Expr* e1 = &inclusive_or_expression();
-  while (true) {
-    if (Token tok = match_if(amp_amp_tok)) {
-      Expr& e2 = inclusive_or_expression();
-      e1 = &on_logical_and_expression(tok, *e1, e2);
-    } else {
-      break;
-    }
-  }
-  return *e1;
-}
-
-
-// Parse a bitwise inclusive-or expression.
-//
 //    inclusive-or-expression:
 //      exclusive-or-expression
 //      inclusive-or-expression '|' exclusive-or-expression
 //
-// FIXME: This skips the bitwise expressions.
-Expr&
-Parser::inclusive_or_expression()
-{
-  Expr* e1 = &exclusive_or_expression();
-  while (true) {
-    if (Token tok = match_if(bar_tok)) {
-      Expr& e2 = exclusive_or_expression();
-      e1 = &on_or_expression(tok, *e1, e2);
-    } else {
-      break;
-    }
-  }
-  return *e1;
-}
-
-
-// Parse a bitwise exclusive-or expression.
-//
 //    exclusive-or-expression:
 //      and-expression
 //      exclusive-or-expression '^' and-expression
 //
-Expr&
-Parser::exclusive_or_expression()
-{
-  Expr* e1 = &and_expression();
-  while (true) {
-    if (Token tok = match_if(caret_tok)) {
-      Expr& e2 = and_expression();
-      e1 = &on_xor_expression(tok, *e1, e2);
-    } else {
-      break;
-    }
-  }
-  return *e1;
-}
-
-
-// Parse a bitwise and expression.
-//
-//    exclusive-or-expression:
+//    and-expression:
 //      equality-expression
-//      exclusive-or-expression '&' equality-expression
-//
-Expr&
-Parser::and_expression()
-{
-  Expr* e1 = &equality_expression();
-  while (true) {
-    if (Token tok = match_if(amp_tok)) {
-      Expr& e2 = equality_expression();
-      e1 = &on_and_expression(tok, *e1, e2);
-    } else {
-      break;
-    }
-  }
-  return *e1;
-}
-
-
-// Parse an equality expression.
+//      and-expression '&' equality-expression
 //
 //    equality-expression:
 //      relational-expression:
 //      equality-expression '==' relational-expression
 //      equality-expression '!=' relational-expression
-Expr&
-Parser::equality_expression()
-{
-  Expr* e1 = &relational_expression();
-  while (true) {
-    if (Token tok = match_if(eq_eq_tok)) {
-      Expr& e2 = relational_expression();
-      e1 = &on_eq_expression(tok, *e1, e2);
-    } else if (Token tok = match_if(bang_eq_tok)) {
-      Expr& e2 = relational_expression();
-      e1 = &on_ne_expression(tok, *e1, e2);
-    } else {
-      break;
-    }
-  }
-  return *e1;
-}
-
-
-// Parse a relational expression.
 //
 //    relational-expression:
 //      shift-expression:
@@ -166,110 +62,132 @@ Parser::equality_expression()
 //      relational-expression '<=' shift-expression
 //      relational-expression '>=' shift-expression
 //      relational-expression '<=>' shift-expression
-Expr&
-Parser::relational_expression()
-{
-  Expr* e1 = &shift_expression();
-  while (true) {
-    if (Token tok = match_if(lt_tok)) {
-      Expr& e2 = shift_expression();
-      e1 = &on_lt_expression(tok, *e1, e2);
-    } else if (Token tok = match_if(gt_tok)) {
-      Expr& e2 = shift_expression();
-      e1 = &on_gt_expression(tok, *e1, e2);
-    } else if (Token tok = match_if(lt_eq_tok)) {
-      Expr& e2 = shift_expression();
-      e1 = &on_le_expression(tok, *e1, e2);
-    } else if (Token tok = match_if(gt_eq_tok)) {
-      Expr& e2 = shift_expression();
-      e1 = &on_ge_expression(tok, *e1, e2);
-    } else if (Token tok = match_if(lt_eq_gt_tok)) {
-      Expr& e2 = shift_expression();
-      e1 = &on_cmp_expression(tok, *e1, e2);
-    } else {
-      break;
-    }
-  }
-  return *e1;
-}
-
-
-// Parse a shift expression.
 //
 //    shift-expression:
 //      additive_expression:
 //      shift-expression '<<' additive_expression
 //      shift-expression '>>' additive_expression
 //
-Expr&
-Parser::shift_expression()
-{
-  Expr* e1 = &additive_expression();
-  while (true) {
-    if (Token tok = match_if(lt_lt_tok)) {
-      Expr& e2 = additive_expression();
-      e1 = &on_lsh_expression(tok, *e1, e2);
-    } else if (Token tok = match_if(gt_gt_tok)) {
-      Expr& e2 = additive_expression();
-      e1 = &on_rsh_expression(tok, *e1, e2);
-    } else {
-      break;
-    }
-  }
-  return *e1;
-}
-
-
-// Parse an additive expression.
-//
 //    additive-expression:
 //      multiplicative-expression:
 //      additive-expression '+' multiplicative-expression
 //      additive-expression '-' multiplicative-expression
-Expr&
-Parser::additive_expression()
-{
-  Expr* e1 = &multiplicative_expression();
-  while (true) {
-    if (Token tok = match_if(plus_tok)) {
-      Expr& e2 = multiplicative_expression();
-      e1 = &on_add_expression(tok, *e1, e2);
-    } else if (Token tok = match_if(minus_tok)) {
-      Expr& e2 = unary_expression();
-      e1 = &on_sub_expression(tok, *e1, e2);
-    } else {
-      break;
-    }
-  }
-  return *e1;
-}
-
-
-// Parse a multiplicative expression.
 //
 //    multiplicative-expression:
 //      unary-expression:
 //      multiplicative-expression '*' unary-expression
 //      multiplicative-expression '/' unary-expression
 //      multiplicative-expression '%' unary-expression
+
+namespace
+{
+
+// Precedences of binary operators, from lowest to highest.
+enum
+{
+  no_prec,
+  logical_or_prec,
+  logical_and_prec,
+  inclusive_or_prec,
+  exclusive_or_prec,
+  and_prec,
+  equality_prec,
+  relational_prec,
+  shift_prec,
+  additive_prec,
+  multiplicative_prec,
+};
+
+
+// The semantic action for a binary operator.
+using Binary_action = Expr& (Parser::*)(Token, Expr&, Expr&);
+
+
+// A binary operator has a precedence and a semantic action. Tokens that
+// are not binary operators have no precedence.
+struct Binary_operator
+{
+  int           prec;
+  Binary_action action;
+};
+
+
+// The number of token kinds that can be binary operators.
+constexpr int binary_operator_tokens = first_keyword_tok;
+
+
+// Builds the table of binary operators.
+struct Binary_operator_table
+{
+  Binary_operator_table()
+    : ops()
+  {
+    add(bar_bar_tok,   logical_or_prec,     &Parser::on_logical_or_expression);
+    add(amp_amp_tok,   logical_and_prec,    &Parser::on_logical_and_expression);
+    add(bar_tok,       inclusive_or_prec,   &Parser::on_or_expression);
+    add(caret_tok,     exclusive_or_prec,   &Parser::on_xor_expression);
+    add(amp_tok,       and_prec,            &Parser::on_and_expression);
+    add(eq_eq_tok,     equality_prec,       &Parser::on_eq_expression);
+    add(bang_eq_tok,   equality_prec,       &Parser::on_ne_expression);
+    add(lt_tok,        relational_prec,     &Parser::on_lt_expression);
+    add(gt_tok,        relational_prec,     &Parser::on_gt_expression);
+    add(lt_eq_tok,     relational_prec,     &Parser::on_le_expression);
+    add(gt_eq_tok,     relational_prec,     &Parser::on_ge_expression);
+    add(lt_eq_gt_tok,  relational_prec,     &Parser::on_cmp_expression);
+    add(lt_lt_tok,     shift_prec,          &Parser::on_lsh_expression);
+    add(gt_gt_tok,     shift_prec,          &Parser::on_rsh_expression);
+    add(plus_tok,      additive_prec,       &Parser::on_add_expression);
+    add(minus_tok,     additive_prec,       &Parser::on_sub_expression);
+    add(star_tok,      multiplicative_prec, &Parser::on_mul_expression);
+    add(slash_tok,     multiplicative_prec, &Parser::on_div_expression);
+    add(percent_tok,   multiplicative_prec, &Parser::on_rem_expression);
+  }
+
+  void add(Token_kind k, int p, Binary_action a)
+  {
+    ops[k] = {p, a};
+  }
+
+  // Returns the operator for the token kind k.
+  Binary_operator const& operator[](Token_kind k) const
+  {
+    static Binary_operator const none {no_prec, nullptr};
+    if (0 <= k && k < binary_operator_tokens)
+      return ops[k];
+    return none;
+  }
+
+  Binary_operator ops[binary_operator_tokens];
+};
+
+
+Binary_operator_table const binary_operators;
+
+} // namespace
+
+
+// Parse a logical-or expression.
+Expr&
+Parser::logical_or_expression()
+{
+  return binary_expression(logical_or_prec);
+}
+
+
+// Parse a binary expression whose operators have precedence at least
+// `prec`. The right operand of each operator is parsed with a strictly
+// higher precedence, making operators left associative.
 Expr&
-Parser::multiplicative_expression()
+Parser::binary_expression(int prec)
 {
   Expr* e1 = &unary_expression();
   while (true) {
-    // Use a switch?
-    if (Token tok = match_if(star_tok)) {
-      Expr& e2 = unary_expression();
-      e1 = &on_mul_expression(tok, *e1, e2);
-    } else if (Token tok = match_if(slash_tok)) {
-      Expr& e2 = unary_expression();
-      e1 = &on_div_expression(tok, *e1, e2);
-    } else if (Token tok = match_if(percent_tok)) {
-      Expr& e2 = unary_expression();
-      e1 = &on_rem_expression(tok, *e1, e2);
-    } else {
+    Binary_operator const& op = binary_operators[lookahead()];
+    if (op.prec < prec)
       break;
-    }
+    Token tok = accept();
+    Expr& e2 = binary_expression(op.prec + 1);
+    e1 = &(this->*op.action)(tok, *e1, e2);
   }
   return *e1;
 }
@@ -287,20 +205,29 @@ Parser::multiplicative_expression()
 Expr&
 Parser::unary_expression()
 {
-  if (Token tok = match_if(bang_tok)) {
-    Expr& e = unary_expression();
-    return on_logical_not_expression(tok, e);
-  } else if (Token tok = match_if(minus_tok)) {
-    Expr& e = unary_expression();
-    return on_neg_expression(tok, e);
-  } else if (Token tok = match_if(plus_tok)) {
-    Expr& e = unary_expression();
-    return on_pos_expression(tok, e);
-  } else if (Token tok = match_if(caret_tok)) {
-    Expr& e = unary_expression();
-    return on_compl_expression(tok, e);
-  } else {
-    return postfix_expression();
+  switch (lookahead()) {
+    case bang_tok: {
+      Token tok = accept();
+      Expr& e = unary_expression();
+      return on_logical_not_expression(tok, e);
+    }
+    case minus_tok: {
+      Token tok = accept();
+      Expr& e = unary_expression();
+      return on_neg_expression(tok, e);
+    }
+    case plus_tok: {
+      Token tok = accept();
+      Expr& e = unary_expression();
+      return on_pos_expression(tok, e);
+    }
+    case caret_tok: {
+      Token tok = accept();
+      Expr& e = unary_expression();
+      return on_compl_expression(tok, e);
+    }
+    default:
+      return postfix_expression();
   }
 }
 
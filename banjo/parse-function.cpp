@@ -143,6 +143,7 @@ Decl&
 Parser::parameter_declaration()
 {
   Match_any_token_pred end_type(*this, comma_tok, rparen_tok, eq_tok);
+  Source_location loc = location();
 
   // Parse and cache the optional parameter specifier.
   parameter_specifier_seq();
@@ -164,7 +165,9 @@ Parser::parameter_declaration()
     if (next_token_is(eq_tok))
       lingo_unimplemented("default arguments");
 
-    return on_function_parameter(*name, type);
+    Decl& p = on_function_parameter(*name, type);
+    p.loc = loc;
+    return p;
   }
 
   Type& type = cxt.make_auto_type();
@@ -173,7 +176,9 @@ Parser::parameter_declaration()
   if (next_token_is(eq_tok))
     lingo_unimplemented("default arguments");
 
-  return on_function_parameter(*name, type);
+  Decl& p = on_function_parameter(*name, type);
+  p.loc = loc;
+  return p;
 }
 
 
@@ -36,12 +36,22 @@ Parser::translation_unit()
 //    toplevel-statement-seq:
 //      toplevel-statement
 //      toplevel-statement-seq toplevel-statement
+//
+// The tokens of each top-level declaration are recorded in its
+// fingerprint (see fingerprint.hpp).
 Stmt_list
 Parser::toplevel_statement_seq()
 {
   Stmt_list ss;
   while (!is_eof()) {
+    Fingerprint fp;
+    print = &fp;
     Stmt& s = toplevel_statement();
+    print = nullptr;
+    if (Declaration_stmt* d = as<Declaration_stmt>(&s)) {
+      fp.finish();
+      cxt.fingerprints()[&d->declaration()] = std::move(fp);
+    }
     ss.push_back(s);
   }
   return ss;
@@ -52,6 +62,8 @@ Parser::toplevel_statement_seq()
 //
 //    toplevel-statement:
 //      declaration-statement
+//      import-declaration
+//      export-declaration
 //
 // TODO: What other kinds of toplevel-statements should we have. Note that
 // imports and modules are declarations. 
@@ -59,6 +71,12 @@ Stmt&
 Parser::toplevel_statement()
 {
   switch (lookahead()) {
+    case import_tok:
+      return import_declaration();
+
+    case export_tok:
+      return export_declaration();
+
     // Declaration specifiers.
     case virtual_tok:
     case abstract_tok:
@@ -78,11 +96,40 @@ Parser::toplevel_statement()
       return declaration_statement();
     
     default:
-      error("expected toplevel-statement");
+      error(cxt, "expected toplevel-statement");
       throw Syntax_error();
   }
 }
 
 
+// Parse an import declaration.
+//
+//    import-declaration:
+//      'import' identifier ';'
+//
+// The named module is loaded from the file 'identifier.bmod'.
+Stmt&
+Parser::import_declaration()
+{
+  require(import_tok);
+  Name& n = identifier();
+  match(semicolon_tok);
+  return on_import_declaration(n);
+}
+
+
+// Parse an export declaration.
+//
+//    export-declaration:
+//      'export' declaration-statement
+Stmt&
+Parser::export_declaration()
+{
+  require(export_tok);
+  Stmt& s = declaration_statement();
+  return on_export_declaration(s);
+}
+
+
 
 } // namespace banjo
@@ -61,6 +61,18 @@ Parser::lookahead() const
 }
 
 
+// Returns the source location of the next token, or an invalid
+// location if the locations of tokens are not known.
+Source_location
+Parser::location() const
+{
+  if (!locs)
+    return {};
+  std::size_t n = tokens.position() - tokens.begin();
+  return n < locs->size() ? (*locs)[n] : Source_location();
+}
+
+
 // Returns the nth token of lookahead.
 Token_kind
 Parser::lookahead(int n) const
@@ -112,10 +124,9 @@ Parser::match(Token_kind k)
 {
   if (lookahead() == k)
     return accept();
-  String msg = format("expected '{}' but got '{}'",
-                      get_spelling(k),
-                      token_spelling(tokens));
-  throw Syntax_error(cxt, msg);
+  throw Syntax_error(cxt, "expected '{}' but got '{}'",
+                     get_spelling(k),
+                     token_spelling(tokens));
 }
 
 
@@ -158,12 +169,10 @@ Parser::require(char const* s)
 void
 Parser::expect(Token_kind k)
 {
-  if (next_token_is_not(k)) {
-    String msg = format("expected '{}' but got '{}'",
-                        get_spelling(k),
-                        token_spelling(tokens));
-    throw Syntax_error(cxt, msg);
-  }
+  if (next_token_is_not(k))
+    throw Syntax_error(cxt, "expected '{}' but got '{}'",
+                       get_spelling(k),
+                       token_spelling(tokens));
 }
 
 
@@ -179,6 +188,12 @@ Parser::accept()
   // Update the global input location.
   cxt.input_location(tok.location());
 
+  // Record the token in the fingerprint of the current top-level
+  // declaration. Tokens accepted by a failed trial parse are recorded
+  // again, but that happens the same way for the same tokens.
+  if (print)
+    print->add(tok);
+
   // If the token is a brace, then record that for the purpose of
   // brace matching and diagnostics.
   switch (tok.kind()) {
@@ -31,7 +31,7 @@ struct Parser
   using Specs = Specifier_set; // For brevity
 
   Parser(Context& cxt, Token_stream& ts)
-    : cxt(cxt), build(cxt), tokens(ts), state()
+    : cxt(cxt), build(cxt), tokens(ts), state(), print(nullptr), locs(nullptr)
   { }
 
   Decl& operator()() { return translation_unit(); }
@@ -85,15 +85,7 @@ struct Parser
   // Expressions
   Expr& expression();
   Expr& logical_or_expression();
-  Expr& logical_and_expression();
-  Expr& inclusive_or_expression();
-  Expr& exclusive_or_expression();
-  Expr& and_expression();
-  Expr& equality_expression();
-  Expr& relational_expression();
-  Expr& shift_expression();
-  Expr& additive_expression();
-  Expr& multiplicative_expression();
+  Expr& binary_expression(int);
   Expr& unary_expression();
   Expr& postfix_expression();
   Expr& call_expression(Expr&);
@@ -186,6 +178,8 @@ struct Parser
   Decl& translation_unit();
   Stmt_list toplevel_statement_seq();
   Stmt& toplevel_statement();
+  Stmt& import_declaration();
+  Stmt& export_declaration();
 
   // Unparsed terms
   template<typename P> Type& unparsed_type(P);
@@ -337,6 +331,8 @@ struct Parser
   // Toplevel structure
   Decl& start_translation_unit();
   Decl& finish_translation_unit(Decl&, Stmt_list&&);
+  Stmt& on_import_declaration(Name&);
+  Stmt& on_export_declaration(Stmt&);
 
 
   // Token matching.
@@ -355,6 +351,8 @@ struct Parser
   void       expect(Token_kind);
   Token      accept();
 
+  Source_location location() const;
+
   template<typename... Kinds> bool next_token_is_one_of(Token_kind, Kinds...);
 
   bool next_token_is_one_of();
@@ -404,6 +402,11 @@ struct Parser
   Builder       build;
   Token_stream& tokens;
   State         state;
+  Fingerprint*  print; // Records accepted tokens, if non-null
+
+  // The source location of each token in the stream, if non-null.
+  // Declarations are located at their first token.
+  std::vector<Source_location> const* locs;
 };
 
 
@@ -557,26 +560,30 @@ struct Trial_parser
     , state(p.state)
     , scope(&p.current_scope())
     , fail(false)
+    , diags(p.cxt)
   { }
 
   void failed() { fail = true; }
 
+  // Diagnostics issued during a failed trial are discarded without
+  // being formatted.
   ~Trial_parser()
   {
-    // TODO: Manage diagnostics as part of the parser in order to
-    // detet failures?
     if (fail) {
       parser.tokens.reposition(pos);
       parser.cxt.leave_scope(scope);
       parser.state = state;
+    } else {
+      diags.commit();
     }
   }
 
-  Parser&  parser;
-  Position pos;
-  State    state;
-  Scope*   scope;
-  bool     fail;
+  Parser&               parser;
+  Position              pos;
+  State                 state;
+  Scope*                scope;
+  bool                  fail;
+  Speculate_diagnostics diags;
 };
 
 
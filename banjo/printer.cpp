@@ -1011,6 +1011,10 @@ Printer::literal(Integer_expr const& e)
   // FIXME: Provide a to_string for the Integer class. Also, it might be
   // nice to track radixes as part of the type so we don't have to print
   // everything in base 10.
+  if (e.is_small()) {
+    token(std::to_string(e.small_value()));
+    return;
+  }
   Integer_type const& t = cast<Integer_type>(e.type());
   Integer const& n = e.value();
   String const& s = n.impl().toString(10, t.is_signed());
@@ -1331,6 +1335,8 @@ Printer::specifier(Token_kind k)
 void
 Printer::specifier_seq(Specifier_set s)
 {
+  if (s & export_spec)
+    specifier(export_tok);
   if (s & static_spec)
     specifier(static_tok);
   if (s & dynamic_spec)
@@ -1992,6 +1998,52 @@ Printer::grouped_constraint(Cons const& c)
 }
 
 
+// -------------------------------------------------------------------------- //
+// Layout
+
+// Print the layout of a class as a sequence of comments. Each member
+// is printed with its offset and size, and padding is shown explicitly.
+//
+//    // class C: size 16, alignment 8
+//    //   0   x : int (4)
+//    //   4   padding (4)
+//    //   8   y : int64 (8)
+void
+Printer::class_layout(Class_layout const& l)
+{
+  os << "// class ";
+  identifier(*l.decl_);
+  os << ": size " << l.size() << ", alignment " << l.alignment();
+  if (l.is_reordered())
+    os << ", reordered";
+
+  std::size_t n = 0;
+  auto pad = [&](std::size_t k) {
+    if (k > n) {
+      newline();
+      os << "//   " << n << "\tpadding (" << k - n << ')';
+    }
+  };
+  for (Member_layout const& m : l.members()) {
+    pad(m.offset);
+    newline();
+    os << "//   " << m.offset << "\t";
+    if (Super_decl const* s = as<Super_decl>(m.decl)) {
+      os << "base : ";
+      type(s->type());
+    } else {
+      Field_decl const* f = cast<Field_decl>(m.decl);
+      identifier(*f);
+      os << " : ";
+      type(f->type());
+    }
+    os << " (" << m.size << ')';
+    n = m.offset + m.size;
+  }
+  pad(l.size());
+}
+
+
 // -------------------------------------------------------------------------- //
 // Streaming
 
@@ -2056,6 +2108,15 @@ operator<<(std::ostream& os, Decl const& d)
 }
 
 
+std::ostream&
+operator<<(std::ostream& os, Class_layout const& l)
+{
+  Printer print(os);
+  print.class_layout(l);
+  return os;
+}
+
+
 std::ostream&
 operator<<(std::ostream& os, Cons const& c)
 {
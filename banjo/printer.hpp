@@ -8,6 +8,7 @@
 #include "language.hpp"
 #include "ast-stmt.hpp"
 #include "ast-decl.hpp"
+#include "layout.hpp"
 
 #include <iosfwd>
 
@@ -238,6 +239,11 @@ struct Printer
   void constraint(Disjunction_cons const&);
   void grouped_constraint(Cons const&);
 
+  // Layout
+  // Not part of the language, but useful for inspecting the
+  // storage of classes.
+  void class_layout(Class_layout const&);
+
   std::ostream& os;     // Output stream
   int           indent; // The current indentation
 };
@@ -253,6 +259,7 @@ std::ostream& operator<<(std::ostream&, Expr const&);
 std::ostream& operator<<(std::ostream&, Stmt const&);
 std::ostream& operator<<(std::ostream&, Decl const&);
 std::ostream& operator<<(std::ostream&, Cons const&);
+std::ostream& operator<<(std::ostream&, Class_layout const&);
 
 
 } // namespace banjo
@@ -0,0 +1,304 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "reachability.hpp"
+#include "ast.hpp"
+
+#include <vector>
+
+
+namespace banjo
+{
+
+namespace
+{
+
+// Computes the set of declarations named by the definitions of a set
+// of root declarations. Each declaration is visited once.
+struct Reachability
+{
+  using Self = Reachability;
+
+  void reference(Decl const&);
+  void run();
+
+  void declaration(Decl const&);
+  void variable_declaration(Variable_decl const&);
+  void constant_declaration(Constant_decl const&);
+  void function_declaration(Function_decl const&);
+  void coroutine_declaration(Coroutine_decl const&);
+  void class_declaration(Class_decl const&);
+
+  void definition(Def const&);
+  void statement(Stmt const&);
+  void statement_seq(Stmt_list const&);
+  void expression(Expr const&);
+  void expression_seq(Expr_list const&);
+  void type(Type const&);
+
+  Decl_set                 seen;
+  std::vector<Decl const*> work;
+};
+
+
+// Record a reference to d.
+void
+Reachability::reference(Decl const& d)
+{
+  if (seen.insert(&d).second)
+    work.push_back(&d);
+}
+
+
+// Visit the definitions of referenced declarations until no new
+// declarations are found.
+void
+Reachability::run()
+{
+  while (!work.empty()) {
+    Decl const* d = work.back();
+    work.pop_back();
+    declaration(*d);
+  }
+}
+
+
+void
+Reachability::declaration(Decl const& d)
+{
+  struct fn
+  {
+    Self& r;
+    void operator()(Decl const& d)           { /* Do nothing. */ }
+    void operator()(Variable_decl const& d)  { r.variable_declaration(d); }
+    void operator()(Constant_decl const& d)  { r.constant_declaration(d); }
+    void operator()(Function_decl const& d)  { r.function_declaration(d); }
+    void operator()(Coroutine_decl const& d) { r.coroutine_declaration(d); }
+    void operator()(Class_decl const& d)     { r.class_declaration(d); }
+  };
+  apply(d, fn{*this});
+}
+
+
+void
+Reachability::variable_declaration(Variable_decl const& d)
+{
+  type(d.type());
+  definition(d.initializer());
+}
+
+
+void
+Reachability::constant_declaration(Constant_decl const& d)
+{
+  definition(d.initializer());
+}
+
+
+void
+Reachability::function_declaration(Function_decl const& d)
+{
+  for (Decl const& p : d.parameters())
+    type(p.type());
+  type(d.return_type());
+  definition(d.definition());
+}
+
+
+void
+Reachability::coroutine_declaration(Coroutine_decl const& d)
+{
+  for (Decl const& p : d.parameters())
+    type(p.type());
+  type(d.return_type());
+  definition(d.definition());
+}
+
+
+void
+Reachability::class_declaration(Class_decl const& d)
+{
+  definition(d.definition());
+}
+
+
+void
+Reachability::definition(Def const& d)
+{
+  struct fn
+  {
+    Self& r;
+    void operator()(Def const& d)            { /* Do nothing. */ }
+    void operator()(Expression_def const& d) { r.expression(d.expression()); }
+    void operator()(Function_def const& d)   { r.statement(d.statement()); }
+    void operator()(Class_def const& d)      { r.statement_seq(d.statements()); }
+  };
+  apply(d, fn{*this});
+}
+
+
+void
+Reachability::statement(Stmt const& s)
+{
+  struct fn
+  {
+    Self& r;
+    void operator()(Stmt const& s)             { /* Do nothing. */ }
+    void operator()(Compound_stmt const& s)    { r.statement_seq(s.statements()); }
+    void operator()(Return_stmt const& s)      { r.expression(s.expression()); }
+    void operator()(Yield_stmt const& s)       { r.expression(s.expression()); }
+    void operator()(Expression_stmt const& s)  { r.expression(s.expression()); }
+    void operator()(Declaration_stmt const& s) { r.declaration(s.declaration()); }
+
+    void operator()(If_then_stmt const& s)
+    {
+      r.expression(s.condition());
+      r.statement(s.true_branch());
+    }
+
+    void operator()(If_else_stmt const& s)
+    {
+      r.expression(s.condition());
+      r.statement(s.true_branch());
+      r.statement(s.false_branch());
+    }
+
+    void operator()(While_stmt const& s)
+    {
+      r.expression(s.condition());
+      r.statement(s.body());
+    }
+  };
+  apply(s, fn{*this});
+}
+
+
+void
+Reachability::statement_seq(Stmt_list const& ss)
+{
+  for (Stmt const& s : ss)
+    statement(s);
+}
+
+
+void
+Reachability::expression(Expr const& e)
+{
+  struct fn
+  {
+    Self& r;
+    void operator()(Expr const& e)           { /* Do nothing. */ }
+    void operator()(Decl_expr const& e)      { r.reference(e.declaration()); }
+    void operator()(Dot_expr const& e)       { r.expression(e.object()); }
+    void operator()(Tuple_expr const& e)     { r.expression_seq(e.elements()); }
+    void operator()(Unary_expr const& e)     { r.expression(e.operand()); }
+    void operator()(Conv const& e)           { r.expression(e.source()); }
+    void operator()(Copy_init const& e)      { r.expression(e.expression()); }
+    void operator()(Bind_init const& e)      { r.expression(e.expression()); }
+    void operator()(Aggregate_init const& e) { r.expression_seq(e.initializers()); }
+
+    void operator()(Nested_decl_expr const& e)
+    {
+      r.expression(e.object());
+      r.reference(e.declaration());
+    }
+
+    void operator()(Binary_expr const& e)
+    {
+      r.expression(e.left());
+      r.expression(e.right());
+    }
+
+    void operator()(Call_expr const& e)
+    {
+      r.expression(e.function());
+      r.expression_seq(e.arguments());
+    }
+
+    void operator()(Direct_init const& e)
+    {
+      r.reference(e.consructor());
+      r.expression_seq(e.arguments());
+    }
+  };
+  type(e.type());
+  apply(e, fn{*this});
+}
+
+
+void
+Reachability::expression_seq(Expr_list const& es)
+{
+  for (Expr const& e : es)
+    expression(e);
+}
+
+
+// A coroutine is named by the type of its frame.
+void
+Reachability::type(Type const& t)
+{
+  if (Coroutine_type const* c = as<Coroutine_type>(&t.non_reference_type()))
+    reference(c->declaration());
+}
+
+
+// Returns true if d is the program's entry point.
+bool
+is_main(Decl const& d)
+{
+  if (!is<Function_decl>(d))
+    return false;
+  Simple_id const* id = as<Simple_id>(&d.name());
+  return id && id->symbol().spelling() == "main";
+}
+
+} // namespace
+
+
+// Returns the set of declarations reachable from the exported
+// declarations of the unit and from `main`. Types are always reachable,
+// as are declarations that cannot be removed.
+//
+// A unit that exports nothing and has no `main` is a collection of
+// definitions for use by other translations. All of its declarations
+// are reachable.
+Decl_set
+reachable_declarations(Translation_unit const& tu)
+{
+  Reachability r;
+  bool roots = false;
+  for (Stmt const& s : tu.statements()) {
+    Declaration_stmt const* ds = as<Declaration_stmt>(&s);
+    if (!ds)
+      continue;
+    Decl const& d = ds->declaration();
+    if (!is_removable(d))
+      r.reference(d);
+    else if ((d.specifiers() & export_spec) || is_main(d)) {
+      r.reference(d);
+      roots = true;
+    }
+  }
+
+  if (!roots) {
+    for (Stmt const& s : tu.statements()) {
+      if (Declaration_stmt const* ds = as<Declaration_stmt>(&s))
+        r.reference(ds->declaration());
+    }
+  }
+
+  r.run();
+  return std::move(r.seen);
+}
+
+
+// Returns true if code generation can omit d when it is unreachable.
+bool
+is_removable(Decl const& d)
+{
+  return is<Function_decl>(d) || is<Coroutine_decl>(d) || is<Variable_decl>(d);
+}
+
+
+} // namespace banjo
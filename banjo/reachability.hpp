@@ -0,0 +1,32 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_REACHABILITY_HPP
+#define BANJO_REACHABILITY_HPP
+
+// Reachability of declarations. A declaration is reachable when it is
+// named, directly or indirectly, by the definition of an exported
+// declaration or of `main`. Code is generated only for reachable
+// functions, coroutines, and variables, so the cost of translation
+// scales with the code that is actually used.
+
+#include "prelude.hpp"
+#include "language.hpp"
+
+#include <unordered_set>
+
+
+namespace banjo
+{
+
+using Decl_set = std::unordered_set<Decl const*>;
+
+
+Decl_set reachable_declarations(Translation_unit const&);
+bool     is_removable(Decl const&);
+
+
+} // namespace banjo
+
+
+#endif
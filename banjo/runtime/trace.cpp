@@ -0,0 +1,299 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+// The function tracing runtime. Programs compiled with
+// '-finstrument-functions' call
+//
+//    void __banjo_enter(char const* fn)
+//    void __banjo_exit(char const* fn)
+//
+// on entry to and exit from each generated function, where fn is the
+// name of the function. The same pointer is passed to both hooks. Link
+// those programs with the banjo-trace library.
+//
+// Each thread records the number of calls to each function, and the
+// inclusive and exclusive time spent in each function. The time of a
+// recursive function is included only once for its outermost call. The
+// records of a thread are merged when the thread exits, and a report is
+// written when the program exits. The report is written to the file
+// named by the BANJO_TRACE environment variable, or to stderr.
+//
+// The hooks take no locks and allocate only to grow a thread's tables.
+// Time is measured by the time stamp counter where it is available.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <x86intrin.h>
+#endif
+
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+
+// Returns the current time in ticks.
+inline std::uint64_t
+now()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  auto t = Clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(t).count();
+#endif
+}
+
+
+// The totals of a function.
+struct Totals
+{
+  std::uint64_t calls     = 0;
+  std::uint64_t inclusive = 0; // In ticks
+  std::uint64_t exclusive = 0; // In ticks
+};
+
+
+// The records of a function in a thread.
+struct Record
+{
+  char const*   fn;
+  Totals        totals;
+  std::uint32_t active; // The number of activations on the stack
+};
+
+
+// An activation of a function.
+struct Frame
+{
+  Record*       rec;
+  std::uint64_t start;
+  std::uint64_t children; // Ticks spent in callees
+};
+
+
+// Totals by function name for the whole program. Note that different
+// modules may pass different pointers for the same function.
+struct Report
+{
+  Report();
+  ~Report();
+
+  void write(std::FILE*);
+
+  std::mutex                              mutex;
+  std::unordered_map<std::string, Totals> fns;
+  std::size_t                             threads;
+
+  // Used to convert ticks to seconds.
+  std::uint64_t     ticks;
+  Clock::time_point time;
+};
+
+
+Report&
+report()
+{
+  static Report r;
+  return r;
+}
+
+
+// The records and call stack of a thread. Records are kept in an open
+// addressing hash table keyed by function pointer.
+struct Thread_trace
+{
+  Thread_trace();
+  ~Thread_trace();
+
+  Record* get(char const*);
+  void    grow();
+
+  std::vector<Record> table;
+  std::size_t         size;
+  std::vector<Frame>  stack;
+};
+
+
+inline std::size_t
+hash(char const* fn)
+{
+  std::uintptr_t n = reinterpret_cast<std::uintptr_t>(fn);
+  return (n >> 4) ^ (n >> 16);
+}
+
+
+Thread_trace::Thread_trace()
+  : table(1024, Record{nullptr, {}, 0}), size(0)
+{
+  // Ensure that the report outlives the trace of the main thread.
+  report();
+  stack.reserve(256);
+}
+
+
+// Merge the records of the thread into the report.
+Thread_trace::~Thread_trace()
+{
+  Report& r = report();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  ++r.threads;
+  for (Record const& rec : table) {
+    if (!rec.fn)
+      continue;
+    Totals& t = r.fns[rec.fn];
+    t.calls += rec.totals.calls;
+    t.inclusive += rec.totals.inclusive;
+    t.exclusive += rec.totals.exclusive;
+  }
+}
+
+
+// Returns the record for fn, creating it if needed.
+inline Record*
+Thread_trace::get(char const* fn)
+{
+  std::size_t mask = table.size() - 1;
+  std::size_t i = hash(fn) & mask;
+  while (true) {
+    Record& rec = table[i];
+    if (rec.fn == fn)
+      return &rec;
+    if (!rec.fn)
+      break;
+    i = (i + 1) & mask;
+  }
+
+  // Keep the table at most half full.
+  if (2 * (size + 1) > table.size()) {
+    grow();
+    return get(fn);
+  }
+  ++size;
+  table[i].fn = fn;
+  return &table[i];
+}
+
+
+// Double the size of the table. Records on the stack are updated to
+// refer to their new locations.
+void
+Thread_trace::grow()
+{
+  std::vector<Record> old(2 * table.size(), Record{nullptr, {}, 0});
+  old.swap(table);
+  std::size_t mask = table.size() - 1;
+  std::unordered_map<Record const*, Record*> moved;
+  for (Record& rec : old) {
+    if (!rec.fn)
+      continue;
+    std::size_t i = hash(rec.fn) & mask;
+    while (table[i].fn)
+      i = (i + 1) & mask;
+    table[i] = rec;
+    moved[&rec] = &table[i];
+  }
+  for (Frame& f : stack)
+    f.rec = moved[f.rec];
+}
+
+
+thread_local Thread_trace trace;
+
+
+Report::Report()
+  : threads(0), ticks(now()), time(Clock::now())
+{ }
+
+
+Report::~Report()
+{
+  std::FILE* out = stderr;
+  char const* path = std::getenv("BANJO_TRACE");
+  if (path && *path) {
+    out = std::fopen(path, "w");
+    if (!out) {
+      std::fprintf(stderr, "banjo: cannot open trace '%s'\n", path);
+      return;
+    }
+  }
+  write(out);
+  if (out != stderr)
+    std::fclose(out);
+}
+
+
+// Write the totals of each function, ordered by decreasing exclusive
+// time.
+void
+Report::write(std::FILE* out)
+{
+  // Calibrate ticks against the steady clock.
+  double secs = std::chrono::duration<double>(Clock::now() - time).count();
+  std::uint64_t elapsed = now() - ticks;
+  double ms = elapsed ? 1000 * secs / elapsed : 0;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  std::vector<std::pair<std::string, Totals>> ents(fns.begin(), fns.end());
+  std::sort(ents.begin(), ents.end(), [](auto const& a, auto const& b) {
+    return a.second.exclusive > b.second.exclusive;
+  });
+
+  std::fprintf(out, "banjo trace: %zu function(s), %zu thread(s)\n",
+               ents.size(), threads);
+  std::fprintf(out, "%14s %16s %16s  %s\n",
+               "calls", "inclusive (ms)", "exclusive (ms)", "function");
+  for (auto const& ent : ents) {
+    Totals const& t = ent.second;
+    std::fprintf(out, "%14llu %16.3f %16.3f  %s\n",
+                 static_cast<unsigned long long>(t.calls),
+                 t.inclusive * ms,
+                 t.exclusive * ms,
+                 ent.first.c_str());
+  }
+}
+
+
+} // namespace
+
+
+extern "C" void
+__banjo_enter(char const* fn)
+{
+  Thread_trace& t = trace;
+  Record* rec = t.get(fn);
+  ++rec->totals.calls;
+  ++rec->active;
+  t.stack.push_back(Frame{rec, now(), 0});
+}
+
+
+// Exits that do not match the top of the stack are ignored.
+extern "C" void
+__banjo_exit(char const* fn)
+{
+  std::uint64_t end = now();
+  Thread_trace& t = trace;
+  if (t.stack.empty() || t.stack.back().rec->fn != fn)
+    return;
+  Frame f = t.stack.back();
+  t.stack.pop_back();
+
+  std::uint64_t elapsed = end - f.start;
+  Record* rec = f.rec;
+  rec->totals.exclusive += elapsed - std::min(elapsed, f.children);
+  if (--rec->active == 0)
+    rec->totals.inclusive += elapsed;
+  if (!t.stack.empty())
+    t.stack.back().children += elapsed;
+}
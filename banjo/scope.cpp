@@ -3,6 +3,7 @@
 
 #include "scope.hpp"
 #include "ast.hpp"
+#include "module.hpp"
 #include "printer.hpp"
 
 #include <iostream>
@@ -19,6 +20,25 @@ Scope::bind(Decl& d)
 }
 
 
+// Search the imported modules for declarations of `n`, binding them in
+// this scope. Declarations are deserialized when their names are first
+// looked up, and found by ordinary lookup afterwards.
+Overload_set*
+Scope::import(Name const& n)
+{
+  Overload_set* ovl = nullptr;
+  for (Module* m : imports) {
+    for (Decl& d : m->lookup(n)) {
+      if (ovl)
+        ovl->insert(d);
+      else
+        ovl = &bind(d).second;
+    }
+  }
+  return ovl;
+}
+
+
 // Streaming
 
 std::ostream& 
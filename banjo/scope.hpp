@@ -12,6 +12,9 @@
 namespace banjo
 {
 
+struct Module;
+
+
 // -------------------------------------------------------------------------- //
 // Scope definitions
 
@@ -20,6 +23,10 @@ namespace banjo
 using Name_map = std::unordered_map<Name const*, Overload_set, Name_hash, Name_eq>;
 
 
+// A sequence of modules imported into a scope.
+using Module_list = std::vector<Module*>;
+
+
 // A scope defines a maximal lexical region of text where an entity may be 
 // referred to without qualification. Scope objects are associated with the
 // term defining their enclosing region of text.
@@ -61,16 +68,21 @@ struct Scope
   Binding& bind(Name const&, Decl&);
 
   // Return the binding for the given symbol, or nullptr
-  // if no such binding exists.
+  // if no such binding exists. Non-const lookup also searches
+  // the modules imported into the scope.
   Overload_set const* lookup(Name const& n) const;
   Overload_set*       lookup(Name const& n);
 
+  // Bind the declarations of `n` exported by imported modules.
+  Overload_set* import(Name const& n);
+
   // Returns 1 if the name is bound and 0 otherwise.
   std::size_t count(Name const& n) const { return names.count(&n); }
 
-  Scope*   parent;
-  Term*    cxt;
-  Name_map names;
+  Scope*      parent;
+  Term*       cxt;
+  Name_map    names;
+  Module_list imports;
 };
 
 
@@ -105,6 +117,8 @@ Scope::lookup(Name const& n)
   auto iter = names.find(&n);
   if (iter != names.end())
     return &iter->second;
+  else if (!imports.empty())
+    return import(n);
   else
     return nullptr;
 }
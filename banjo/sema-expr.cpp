@@ -217,11 +217,21 @@ Parser::on_boolean_literal(Token, bool b)
 }
 
 
+// Literals of at most 18 decimal digits always fit in 64 bits. Compute
+// their values directly rather than through an arbitrary precision
+// integer.
 Expr&
 Parser::on_integer_literal(Token tok)
 {
   Type& t = build.get_int_type();
-  Integer n = tok.spelling();
+  String const& s = tok.spelling();
+  if (s.size() <= 18) {
+    std::int64_t n = 0;
+    for (char c : s)
+      n = n * 10 + (c - '0');
+    return build.get_integer(t, n);
+  }
+  Integer n = s;
   return build.get_integer(t, n);
 }
 
@@ -3,13 +3,18 @@
 
 #include "parser.hpp"
 #include "printer.hpp"
+#include "ast-name.hpp"
 #include "ast-stmt.hpp"
 #include "elab-declarations.hpp"
 #include "elab-overloads.hpp"
 #include "elab-classes.hpp"
 #include "elab-expressions.hpp"
+#include "elab-inlining.hpp"
+#include "elab-constants.hpp"
 #include "elaboration.hpp"
+#include "module.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 
@@ -45,6 +50,8 @@ Parser::finish_translation_unit(Decl& d, Stmt_list&& ss)
   Elaborate_overloads    overloads(*this);
   Elaborate_classes      classes(*this);
   Elaborate_expressions  expressions(*this);
+  Elaborate_inlining     inlining(*this);
+  Elaborate_constants    constants(*this);
 
   declarations(tu); // Assign types to declarations
 
@@ -55,8 +62,41 @@ Parser::finish_translation_unit(Decl& d, Stmt_list&& ss)
 
   expressions(tu);  // Update expressions
 
+  inlining(tu);     // Inline calls to small functions
+
+  constants(tu);    // Fold constant expressions
+
   return tu;
 }
 
 
+// Load the named module and make its exported declarations visible
+// in the current scope. Declarations are deserialized on first lookup.
+//
+// TODO: Search a list of module directories.
+Stmt&
+Parser::on_import_declaration(Name& n)
+{
+  String path = cast<Simple_id>(n).symbol().spelling() + module_extension;
+  if (!cxt.module_directory().empty())
+    path = cxt.module_directory() + '/' + path;
+  Module& m = load_module(cxt, path);
+  Module_list& ms = current_scope().imports;
+  if (std::find(ms.begin(), ms.end(), &m) == ms.end())
+    ms.push_back(&m);
+  return cxt.make_empty_statement();
+}
+
+
+// Mark the declaration as exported. Exported declarations are written
+// to the module file of the translation unit.
+Stmt&
+Parser::on_export_declaration(Stmt& s)
+{
+  Decl& d = cast<Declaration_stmt>(s).declaration();
+  d.spec_ |= export_spec;
+  return s;
+}
+
+
 } // namespace banjo
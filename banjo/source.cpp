@@ -0,0 +1,111 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "source.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+
+namespace banjo
+{
+
+std::ostream&
+operator<<(std::ostream& os, Source_position const& pos)
+{
+  if (!pos.file)
+    return os << "<unknown>";
+  return os << *pos.file << ':' << pos.line << ':' << pos.column;
+}
+
+
+// Returns the line and column of loc, building the line table of the
+// file on first use.
+Source_position
+Source_file::position(Source_location loc) const
+{
+  std::call_once(once, [this]() {
+    lines.push_back(0);
+    for (char const* p = first; p != last; ++p) {
+      if (*p == '\n')
+        lines.push_back(p - first + 1);
+    }
+  });
+  std::uint32_t n = loc.off - base;
+  auto iter = std::upper_bound(lines.begin(), lines.end(), n) - 1;
+  int line = iter - lines.begin() + 1;
+  int col = n - *iter + 1;
+  return {&path, line, col};
+}
+
+
+// Map the text [first, last) of the file at path into the offset space.
+// Each file is followed by one offset that denotes its end. If the file
+// was previously added with the same text, that file is returned.
+Source_file const&
+Source_manager::add(String const& path, char const* first, char const* last)
+{
+  std::uint64_t size = std::uint64_t(last - first) + 1;
+  auto iter = std::find_if(files.begin(), files.end(), [&](Entry const& e) {
+    return e.file->path == path;
+  });
+  if (iter != files.end()) {
+    Source_file& f = *iter->file;
+    if (f.text.compare(0, String::npos, first, last - first) == 0)
+      return f;
+    if (size <= iter->extent) {
+      std::uint32_t base = f.base;
+      iter->file.reset(new Source_file(path, first, last, base));
+      return *iter->file;
+    }
+    files.erase(iter);
+  }
+
+  std::uint64_t end = std::uint64_t(next) + 2 * size;
+  if (end > UINT32_MAX)
+    throw Limitation_error("too much source text");
+  files.push_back({std::make_unique<Source_file>(path, first, last, next),
+                   std::uint32_t(2 * size)});
+  next = end;
+  return *files.back().file;
+}
+
+
+// Returns the file added for path, or nullptr if there is none.
+Source_file const*
+Source_manager::find(String const& path) const
+{
+  for (Entry const& e : files) {
+    if (e.file->path == path)
+      return e.file.get();
+  }
+  return nullptr;
+}
+
+
+// Returns the file containing loc, or nullptr if loc is invalid.
+Source_file const*
+Source_manager::file(Source_location loc) const
+{
+  if (!loc)
+    return nullptr;
+  auto iter = std::upper_bound(files.begin(), files.end(), loc.off,
+    [](std::uint32_t n, Entry const& e) { return n < e.file->base; });
+  if (iter == files.begin())
+    return nullptr;
+  --iter;
+  return iter->file->contains(loc) ? iter->file.get() : nullptr;
+}
+
+
+// Returns the file, line, and column of loc.
+Source_position
+Source_manager::position(Source_location loc) const
+{
+  if (Source_file const* f = file(loc))
+    return f->position(loc);
+  return {nullptr, 0, 0};
+}
+
+
+} // namespace banjo
@@ -0,0 +1,172 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_SOURCE_HPP
+#define BANJO_SOURCE_HPP
+
+// Compact source locations. Every input file is mapped into a single
+// space of offsets, so a location is a 32-bit offset into that space.
+// Line and column numbers are computed only when they are needed (e.g.,
+// to print a diagnostic) using line tables that are built the first
+// time a file is queried.
+
+#include "prelude.hpp"
+
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+namespace banjo
+{
+
+// A location in the source offset space. The offset 0 is reserved for
+// the invalid location.
+struct Source_location
+{
+  Source_location()
+    : off(0)
+  { }
+
+  explicit Source_location(std::uint32_t n)
+    : off(n)
+  { }
+
+  bool is_valid() const { return off != 0; }
+  explicit operator bool() const { return is_valid(); }
+
+  std::uint32_t offset() const { return off; }
+
+  std::uint32_t off;
+};
+
+
+inline bool
+operator==(Source_location a, Source_location b)
+{
+  return a.off == b.off;
+}
+
+
+inline bool
+operator!=(Source_location a, Source_location b)
+{
+  return a.off != b.off;
+}
+
+
+inline bool
+operator<(Source_location a, Source_location b)
+{
+  return a.off < b.off;
+}
+
+
+// A pair of locations denoting a region of text.
+struct Source_region
+{
+  Source_region() = default;
+
+  Source_region(Source_location a, Source_location b)
+    : first(a), last(b)
+  { }
+
+  Source_location start() const { return first; }
+  Source_location end() const   { return last; }
+
+  Source_location first;
+  Source_location last;
+};
+
+
+// A decoded source location.
+struct Source_position
+{
+  String const* file;   // The path of the file, or nullptr if invalid
+  int           line;   // The 1-based line number
+  int           column; // The 1-based column number
+};
+
+
+std::ostream& operator<<(std::ostream&, Source_position const&);
+
+
+// An input file mapped into the offset space. The file occupies the
+// offsets [base, base + size]; the last offset denotes the end of the
+// file. The file owns a copy of its text.
+struct Source_file
+{
+  Source_file(String const& p, char const* f, char const* l, std::uint32_t b)
+    : path(p), text(f, l), first(text.data()), last(first + text.size()), base(b)
+  { }
+
+  std::uint32_t size() const { return last - first; }
+
+  bool contains(Source_location loc) const;
+  Source_position position(Source_location) const;
+
+  String         path;
+  String         text;
+  char const*    first;
+  char const*    last;
+  std::uint32_t  base;
+
+  // The offsets of the beginning of each line, computed on demand.
+  mutable std::vector<std::uint32_t> lines;
+  mutable std::once_flag             once;
+};
+
+
+// Returns true if loc is within the file.
+inline bool
+Source_file::contains(Source_location loc) const
+{
+  return base <= loc.off && loc.off <= base + size();
+}
+
+
+// The source manager maps input files into the offset space. Files
+// must be added before they are lexed; after that, the manager can be
+// queried concurrently.
+//
+// There is at most one file for each path. Adding a file whose text
+// has changed replaces the previous file, reusing its offsets when the
+// new text fits. Each file reserves twice the offsets it needs, so the
+// offset space does not grow without bound when the same files are
+// added repeatedly (e.g., by the compile server).
+struct Source_manager
+{
+  Source_manager()
+    : next(1)
+  { }
+
+  Source_file const& add(String const&, char const*, char const*);
+
+  Source_file const* find(String const&) const;
+  Source_file const* file(Source_location) const;
+  Source_position    position(Source_location) const;
+
+  // Returns the location of the character at p in f.
+  Source_location location(Source_file const& f, char const* p) const
+  {
+    return Source_location(f.base + (p - f.first));
+  }
+
+  // A file and the number of offsets reserved for it.
+  struct Entry
+  {
+    std::unique_ptr<Source_file> file;
+    std::uint32_t                extent;
+  };
+
+  std::vector<Entry> files; // In order of increasing base
+  std::uint32_t      next;  // The base offset of the next file
+};
+
+
+} // namespace banjo
+
+
+#endif
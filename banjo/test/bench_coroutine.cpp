@@ -0,0 +1,76 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+// Measures the cost of resuming a compiled coroutine whose frame is
+// allocated on the caller's stack, compared to one whose frame is
+// allocated on the heap, and to calling a compiled function. Each is
+// driven by a loop in generated code.
+//
+//    bench_coroutine [rounds]
+
+#include "test.hpp"
+
+#include <banjo/gen/llvm/jit.hpp>
+
+#include <cstdlib>
+
+
+// Each round yields 8 values, so each round is 8 resumes (plus the
+// final resume that finishes the coroutine).
+char const* source = R"(
+codef gen : (n : int) -> int {
+  yield n;
+  yield n + 1;
+  yield n + 2;
+  yield n + 3;
+  yield n + 4;
+  yield n + 5;
+  yield n + 6;
+  yield n + 7;
+}
+
+def step : (n : int, k : int) -> int = n + k;
+)";
+
+constexpr int yields = 8;
+
+
+int
+main(int argc, char* argv[])
+{
+  std::int64_t rounds = argc > 1 ? std::atoll(argv[1]) : 1000000;
+
+  Context cxt;
+  ll::Jit jit(cxt);
+  cxt.jit(&jit);
+  Decl& tu = translate(cxt, source);
+
+  Coroutine_decl& co = find<Coroutine_decl>(tu, "gen");
+  Function_decl& fn = find<Function_decl>(tu, "step");
+
+  ll::Thunk stack = jit.compile(co, false);
+  ll::Thunk heap = jit.compile(co, true);
+  ll::Thunk call = jit.compile_driver(fn);
+  if (!stack || !heap || !call) {
+    std::cerr << "cannot compile benchmark\n";
+    return 1;
+  }
+
+  std::int64_t ops = rounds * yields;
+  std::int64_t args1[] = {rounds, 1};
+  std::int64_t args2[] = {ops, 1, 2};
+  std::int64_t r1 = 0, r2 = 0, r3 = 0;
+
+  double t1 = measure([&]() { r1 = stack(args1); }, ops);
+  double t2 = measure([&]() { r2 = heap(args1); }, ops);
+  double t3 = measure([&]() { r3 = call(args2); }, ops);
+
+  if (r1 != r2 || r3 != ops * 3) {
+    std::cerr << "wrong results: " << r1 << ' ' << r2 << ' ' << r3 << '\n';
+    return 1;
+  }
+
+  std::cout << "resume (stack frame): " << t1 << " ns\n";
+  std::cout << "resume (heap frame):  " << t2 << " ns\n";
+  std::cout << "function call:        " << t3 << " ns\n";
+}
@@ -0,0 +1,108 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+// Measures the cost of failed name lookup and failed conversion when
+// the failure is reported by throwing an exception, compared to the
+// non-throwing variants used on speculative paths.
+//
+//    bench_lookup [count]
+
+#include "test.hpp"
+
+#include <banjo/lookup.hpp>
+#include <banjo/conversion.hpp>
+
+
+char const* source = R"(
+class C1 { var x : int; }
+class C2 { var x : int; var y : int; }
+
+var v1 : int;
+var v2 : bool;
+
+def f : (n : int) -> int = n;
+)";
+
+
+int
+main(int argc, char* argv[])
+{
+  std::int64_t count = argc > 1 ? std::atoll(argv[1]) : 100000;
+
+  Context cxt;
+  Decl& tu = translate(cxt, source);
+
+  // Look up names from within the translation unit.
+  Enter_scope scope(cxt, tu);
+
+  // None of these names are declared.
+  Name* names[] = {
+    &cxt.get_id("a"),
+    &cxt.get_id("b"),
+    &cxt.get_id("v3"),
+    &cxt.get_id("g"),
+  };
+
+  // None of these conversions are valid.
+  Type& c1 = cxt.get_class_type(find<Class_decl>(tu, "C1"));
+  Type& c2 = cxt.get_class_type(find<Class_decl>(tu, "C2"));
+  Expr& e1 = cxt.get_int(0);
+  Expr& e2 = cxt.get_true();
+  std::pair<Expr*, Type*> convs[] = {
+    {&e1, &c1},
+    {&e2, &c1},
+    {&e1, &c2},
+    {&e2, &c2},
+  };
+
+  std::int64_t ops = count * 4;
+  std::int64_t n1 = 0, n2 = 0, n3 = 0, n4 = 0;
+
+  // Neither variant should emit diagnostics.
+  Suppress_diagnostics quiet(cxt);
+
+  double t1 = measure([&]() {
+    for (std::int64_t i = 0; i < count; ++i) {
+      for (Name* n : names) {
+        try {
+          unqualified_lookup(cxt, *n);
+        } catch (Lookup_error&) {
+          ++n1;
+        }
+      }
+    }
+  }, ops);
+  double t2 = measure([&]() {
+    for (std::int64_t i = 0; i < count; ++i) {
+      for (Name* n : names)
+        n2 += try_unqualified_lookup(cxt, *n).empty();
+    }
+  }, ops);
+  double t3 = measure([&]() {
+    for (std::int64_t i = 0; i < count; ++i) {
+      for (auto const& c : convs) {
+        try {
+          standard_conversion(*c.first, *c.second);
+        } catch (Type_error&) {
+          ++n3;
+        }
+      }
+    }
+  }, ops);
+  double t4 = measure([&]() {
+    for (std::int64_t i = 0; i < count; ++i) {
+      for (auto const& c : convs)
+        n4 += !try_standard_conversion(*c.first, *c.second);
+    }
+  }, ops);
+
+  if (n1 != ops || n2 != ops || n3 != ops || n4 != ops) {
+    std::cerr << "unexpected successes: " << n1 << ' ' << n2 << ' ' << n3 << ' ' << n4 << '\n';
+    return 1;
+  }
+
+  std::cout << "failed lookup (throwing):         " << t1 << " ns\n";
+  std::cout << "failed lookup (non-throwing):     " << t2 << " ns\n";
+  std::cout << "failed conversion (throwing):     " << t3 << " ns\n";
+  std::cout << "failed conversion (non-throwing): " << t4 << " ns\n";
+}
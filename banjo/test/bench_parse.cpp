@@ -0,0 +1,116 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+// Measures the time needed to parse expression-dense inputs. Each input
+// is a long list of comma-separated expressions of a given shape. Only
+// parsing (and the semantic actions it invokes) is timed; lexing is not.
+// The number of heap allocations per expression is also reported.
+//
+//    bench_parse [count] [repeat]
+
+#include "test.hpp"
+
+#include <banjo/lexer.hpp>
+#include <banjo/parser.hpp>
+
+#include <lingo/io.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+
+// Count heap allocations.
+std::size_t allocs = 0;
+
+
+void*
+operator new(std::size_t n)
+{
+  ++allocs;
+  if (void* p = std::malloc(n ? n : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+
+void
+operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+
+// Shapes of expressions, from bare literals to long operator chains.
+char const* shapes[] = {
+  "1",
+  "-1",
+  "1 + 2 * 3 - 4",
+  "(1 + 2) * (3 - 4) / 5 % 6",
+  "1 < 2 && 3 == 4 || 5 != 6 && !(7 >= 8)",
+  "1 + 2 + 3 + 4 + 5 + 6 + 7 + 8 + 9 + 10 + 11 + 12 + 13 + 14 + 15 + 16",
+};
+
+
+using Clock = std::chrono::steady_clock;
+
+
+// Parse the expression list in s once, and return the number of
+// nanoseconds spent parsing. The number of allocations made while
+// parsing is stored in n.
+double
+parse_once(Context& cxt, String const& s, std::size_t& n)
+{
+  Buffer buf = s;
+  Character_stream cs = buf;
+  Token_stream ts;
+  Lexer lex(cxt, cs, ts);
+  lex();
+  if (error_count())
+    std::exit(1);
+
+  Parser parse(cxt, ts);
+  std::size_t a = allocs;
+  auto start = Clock::now();
+  Expr_list es = parse.expression_list();
+  auto stop = Clock::now();
+  n = allocs - a;
+  std::chrono::duration<double, std::nano> ns = stop - start;
+  return ns.count();
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  int count = argc > 1 ? std::atoi(argv[1]) : 10000;
+  int repeat = argc > 2 ? std::atoi(argv[2]) : 10;
+
+  Context cxt;
+  for (char const* shape : shapes) {
+    String s;
+    for (int i = 0; i < count; ++i) {
+      if (i)
+        s += ", ";
+      s += shape;
+    }
+
+    // Take the best of several runs.
+    double best = 0;
+    std::size_t n = 0;
+    for (int i = 0; i < repeat; ++i) {
+      double t = parse_once(cxt, s, n);
+      if (i == 0 || t < best)
+        best = t;
+    }
+    std::cout << best / count << " ns/expr, "
+              << double(n) / count << " allocs/expr: " << shape << '\n';
+  }
+}
@@ -7,7 +7,13 @@
 #include <banjo/context.hpp>
 #include <banjo/ast.hpp>
 #include <banjo/printer.hpp>
+#include <banjo/lexer.hpp>
+#include <banjo/parser.hpp>
 
+#include <lingo/io.hpp>
+
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 
 
@@ -15,4 +21,54 @@ using namespace lingo;
 using namespace banjo;
 
 
+// Lex, parse, and elaborate the source text, returning its translation
+// unit. Exits if the text cannot be lexed. The text is never freed,
+// since the locations of tokens refer to it.
+inline Decl&
+translate(Context& cxt, char const* text)
+{
+  Buffer* buf = new Buffer(String(text));
+  Character_stream cs = *buf;
+  Token_stream ts;
+  Lexer lex(cxt, cs, ts);
+  lex();
+  if (error_count())
+    std::exit(1);
+  Parser parse(cxt, ts);
+  return parse();
+}
+
+
+// Returns the top-level declaration of kind T having the given name.
+// Exits if there is no such declaration.
+template<typename T>
+T&
+find(Decl& tu, char const* name)
+{
+  for (Stmt& s : banjo::cast<Translation_unit>(tu).statements()) {
+    if (Declaration_stmt* d = banjo::as<Declaration_stmt>(&s)) {
+      Decl& decl = d->declaration();
+      if (banjo::is<T>(decl) && banjo::cast<Simple_id>(decl.name()).symbol().spelling() == name)
+        return banjo::cast<T>(decl);
+    }
+  }
+  std::cerr << "no declaration '" << name << "'\n";
+  std::exit(1);
+}
+
+
+// Run f and return the average number of nanoseconds per operation.
+template<typename F>
+double
+measure(F f, std::int64_t ops)
+{
+  using Clock = std::chrono::steady_clock;
+  auto start = Clock::now();
+  f();
+  auto stop = Clock::now();
+  std::chrono::duration<double, std::nano> ns = stop - start;
+  return ns.count() / ops;
+}
+
+
 #endif
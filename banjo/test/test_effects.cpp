@@ -0,0 +1,63 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+// Checks the parameters that a function might modify. A large input
+// parameter is passed by address only when the function does not
+// modify it. An object bound to a reference might be modified.
+
+#include "test.hpp"
+
+#include <banjo/effects.hpp>
+
+
+char const* source = R"(
+class S {
+  var a : int;
+  var b : int;
+  var c : int;
+  var d : int;
+  var e : int;
+}
+
+def set : (r : &int, n : int) -> int = n;
+
+def read : (in s : S, n : int) -> int = s.a + n;
+
+def write : (in s : S, n : int) -> int = set(s.a, n);
+
+def write_local : (in s : S, n : int) -> int
+{
+  var m : int = n;
+  return set(m, s.b);
+}
+)";
+
+
+int failures = 0;
+
+
+// Check whether fn might modify each of its parameters.
+void
+check_modifies(Effect_analysis& fx, Function_decl& fn, bool s, bool n)
+{
+  Decl_list& ps = fn.parameters();
+  if (fx.modifies(fn, *ps[0]) != s || fx.modifies(fn, *ps[1]) != n) {
+    std::cerr << "wrong modified parameters for " << fn.name() << '\n';
+    ++failures;
+  }
+}
+
+
+int
+main()
+{
+  Context cxt;
+  Decl& tu = translate(cxt, source);
+
+  Effect_analysis fx;
+  check_modifies(fx, find<Function_decl>(tu, "read"), false, false);
+  check_modifies(fx, find<Function_decl>(tu, "write"), true, false);
+  check_modifies(fx, find<Function_decl>(tu, "write_local"), false, false);
+
+  return failures != 0;
+}
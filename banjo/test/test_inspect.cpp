@@ -196,8 +196,8 @@ void
 order_concept_directive(Parser& p)
 {
   p.require(concept_tok);
-  Concept_decl& c1 = cast<Concept_decl>(p.concept_name());
-  Concept_decl& c2 = cast<Concept_decl>(p.concept_name());
+  Concept_decl& c1 = banjo::cast<Concept_decl>(p.concept_name());
+  Concept_decl& c2 = banjo::cast<Concept_decl>(p.concept_name());
   p.match(semicolon_tok);
 
   // TODO: Determine which subsumes the other by synthesizing
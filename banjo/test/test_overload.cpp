@@ -0,0 +1,70 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+// Checks that building a candidate for overload resolution reports a
+// candidate that is not viable instead of throwing an exception.
+
+#include "test.hpp"
+
+#include <banjo/call.hpp>
+
+
+char const* source = R"(
+class C { var x : int; }
+
+def f : (c : C) -> int = 0;
+def g : (n : int) -> int = n;
+)";
+
+
+int failures = 0;
+
+
+// Build the candidate for a call to fn and check its viability.
+void
+check_candidate(Context& cxt, Function_decl& fn, Expr_list& args, bool viable)
+{
+  try {
+    Function_candidate c = build_function_candidate(cxt, fn, args);
+    if (bool(c) != viable) {
+      std::cerr << "candidate " << fn.name() << " is "
+                << (viable ? "not " : "") << "viable\n";
+      ++failures;
+    }
+  } catch (...) {
+    std::cerr << "candidate " << fn.name() << " threw an exception\n";
+    ++failures;
+  }
+}
+
+
+int
+main()
+{
+  Context cxt;
+  Decl& tu = translate(cxt, source);
+
+  Function_decl& f = find<Function_decl>(tu, "f");
+  Function_decl& g = find<Function_decl>(tu, "g");
+
+  Expr_list none;
+  Expr_list ints;
+  ints.push_back(cxt.get_int(0));
+
+  // Failures must not be diagnosed.
+  Suppress_diagnostics quiet(cxt);
+
+  check_candidate(cxt, f, ints, false); // no conversion from int to C
+  check_candidate(cxt, f, none, false); // too few arguments
+  check_candidate(cxt, g, ints, true);
+
+  // The throwing form still reports the failure by throwing.
+  try {
+    initialize_parameters(cxt, f.type().parameter_types(), ints);
+    std::cerr << "initialize_parameters did not fail\n";
+    ++failures;
+  } catch (...) {
+  }
+
+  return failures != 0;
+}